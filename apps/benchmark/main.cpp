@@ -0,0 +1,126 @@
+#include <chrono>
+#include <iostream>
+#include <string_view>
+#include <type_traits>
+
+#include "camera.h"
+#include "material.h"
+#include "image_dumper.h"
+#include "sampler.h"
+#include "ray_tracer.h"
+
+#include "hittable/sphere.h"
+#include "hittable/triangle.h"
+#include "hittable/model.h"
+#include "hittable/hittable_list.h"
+#include "hittable/wide_bvh.h"
+
+// Renders a fixed procedural scene and logs the timings, so that builds with different options (e.g. single
+// and double precision) can be compared on the same input.
+
+constexpr uint32_t IMAGE_WIDTH = 320;
+constexpr uint32_t IMAGE_HEIGHT = 180;
+constexpr uint32_t GRID_SIZE = 256; // Quads per side of the terrain mesh
+
+void create_scene(HittableList& scene);
+
+int main() {
+    const std::string_view precision = std::is_same_v<real, float> ? "single" : "double";
+
+    std::cout << "Benchmark information:\n";
+    std::cout << "    Precision: " << precision << " (" << sizeof(real) << " bytes)\n";
+    std::cout << "    Triangle size: " << sizeof(Triangle) << " bytes\n";
+    std::cout << "    HitRecord size: " << sizeof(HitRecord) << " bytes\n";
+    std::cout << "\n";
+
+    const Camera camera({
+        .width = IMAGE_WIDTH,
+        .height = IMAGE_HEIGHT,
+        .vertical_fov = 50.0,
+        .look_from = vec3(0.0, 3.0, 6.0),
+        .look_at = vec3(0.0, 0.0, 0.0),
+        .up = vec3(0.0, 1.0, 0.0),
+    });
+
+    HittableList scene;
+    create_scene(scene);
+
+    const auto bvh_scene = WideBVH(scene);
+    std::cout << bvh_scene.report() << "\n";
+
+    P6ImageDumper image(IMAGE_WIDTH, IMAGE_HEIGHT);
+
+    const RayTracer ray_tracer({
+        .samples_per_pixel = 32,
+        .max_depth = 10,
+        .num_threads = RayTracer::max_num_threads(),
+        .seed = 1,
+    });
+
+    ray_tracer.benchmark_primary_rays(camera, bvh_scene);
+    std::cout << "\n";
+
+    const auto start = std::chrono::high_resolution_clock::now();
+    ray_tracer.render(camera, bvh_scene, image);
+    const auto end = std::chrono::high_resolution_clock::now();
+
+    std::cout << "Render time: " << std::chrono::duration<double, std::milli>(end - start).count() << "ms\n";
+
+    const auto dump_start = std::chrono::high_resolution_clock::now();
+    image.dump("benchmark.ppm");
+    const auto dump_end = std::chrono::high_resolution_clock::now();
+
+    std::cout << "Dump time: " << std::chrono::duration<double, std::milli>(dump_end - dump_start).count() << "ms\n";
+
+    return 0;
+}
+
+void create_scene(HittableList& scene) {
+    Sampler sampler(7);
+
+    // Wavy terrain, so the BVH has a large number of small triangles
+    std::vector<Triangle::Vertex> vertices;
+    std::vector<uvec3> faces;
+
+    for (uint32_t row = 0; row <= GRID_SIZE; ++row) {
+        for (uint32_t col = 0; col <= GRID_SIZE; ++col) {
+            const auto u = static_cast<real>(col) / static_cast<real>(GRID_SIZE);
+            const auto v = static_cast<real>(row) / static_cast<real>(GRID_SIZE);
+            const auto height = real(0.2) * glm::sin(real(12) * u) * glm::cos(real(9) * v);
+
+            vertices.push_back({
+                .pos = vec3(real(10) * u - real(5), height - real(0.5), real(10) * v - real(7)),
+                .uv = vec2(u, v),
+                .normal = vec3(0.0, 1.0, 0.0),
+            });
+        }
+    }
+
+    for (uint32_t row = 0; row < GRID_SIZE; ++row) {
+        for (uint32_t col = 0; col < GRID_SIZE; ++col) {
+            const auto i = row * (GRID_SIZE + 1) + col;
+            faces.emplace_back(i, i + 1, i + GRID_SIZE + 1);
+            faces.emplace_back(i + 1, i + GRID_SIZE + 2, i + GRID_SIZE + 1);
+        }
+    }
+
+    scene.add_hittable<Mesh>(vertices, faces, scene.add_material<Lambertian>(vec3(0.6, 0.6, 0.5)));
+
+    // Small spheres scattered over the terrain
+    for (uint32_t i = 0; i < 200; ++i) {
+        const auto center = vec3(sampler.next_real(-4, 4), sampler.next_real(0, 1), sampler.next_real(-6, 1));
+        const auto choose_material = sampler.next_real();
+
+        const IMaterial* material;
+        if (choose_material < real(0.7))
+            material = scene.add_material<Lambertian>(vec3_random(sampler) * vec3_random(sampler));
+        else if (choose_material < real(0.9))
+            material = scene.add_material<Metal>(vec3_random(sampler, real(0.5), 1), sampler.next_real(0, real(0.3)));
+        else
+            material = scene.add_material<Dielectric>(real(1.5));
+
+        scene.add_hittable<Sphere>(center, real(0.15), material);
+    }
+
+    scene.add_hittable<Sphere>(vec3(0.0, 6.0, 0.0), real(2), scene.add_material<DiffuseEmissive>(vec3(1.0), real(4)));
+}
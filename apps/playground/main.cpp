@@ -1,13 +1,15 @@
+#include <iostream>
+
 #include "camera.h"
 #include "material.h"
 #include "image_dumper.h"
-#include "rand.h"
+#include "sampler.h"
 #include "ray_tracer.h"
 
 #include "hittable/sphere.h"
 #include "hittable/model.h"
 #include "hittable/hittable_list.h"
-#include "hittable/bvh_node.h"
+#include "hittable/wide_bvh.h"
 
 constexpr uint32_t IMAGE_WIDTH = 600;
 constexpr uint32_t IMAGE_HEIGHT = static_cast<uint32_t>(IMAGE_WIDTH / (16.0f / 9.0f));
@@ -30,7 +32,8 @@ int main() {
     HittableList scene;
     sponza_scene(scene);
 
-    const auto bvh_scene = BVHNode(scene);
+    const auto bvh_scene = WideBVH(scene);
+    std::cout << bvh_scene.report() << "\n";
 
     // Image dumper
     PPMImageDumper image(IMAGE_WIDTH, IMAGE_HEIGHT);
@@ -53,50 +56,54 @@ int main() {
 }
 
 void sponza_scene(HittableList& scene) {
-    scene.add_hittable<Model>("../../models/sponza_multiple_meshes/sponza.obj", vec3(0.0), vec3(1.0), vec3(0.0));
+    const auto model_material = scene.add_material<Lambertian>(vec3(real(0.18)));
+    scene.add_hittable<Model>("../../models/sponza_multiple_meshes/sponza.obj", vec3(0.0), vec3(1.0), vec3(0.0),
+                              model_material);
 
-    const auto light_material = std::make_shared<DiffuseEmissive>(vec3(1.0f), 5.0);
+    const auto light_material = scene.add_material<DiffuseEmissive>(vec3(1.0f), 5.0);
     scene.add_hittable<Sphere>(vec3(1.0, 2.0, 1.0), 0.7, light_material);
 }
 
 void create_scene(HittableList& scene) {
-    auto ground_material = std::make_shared<Lambertian>(vec3(0.5, 0.5, 0.5));
+    Sampler sampler(42);
+
+    auto ground_material = scene.add_material<Lambertian>(vec3(0.5, 0.5, 0.5));
     scene.add_hittable<Sphere>(vec3(0, -1000, 0), 1000, ground_material);
 
     for (int32_t a = -11; a < 11; a++) {
         for (int32_t b = -11; b < 11; b++) {
-            auto choose_mat = random_double();
-            vec3 center(a + 0.9 * random_double(), 0.2, b + 0.9 * random_double());
+            auto choose_mat = sampler.next_double();
+            vec3 center(a + 0.9 * sampler.next_double(), 0.2, b + 0.9 * sampler.next_double());
 
             if (glm::length(center - vec3(4, 0.2, 0)) > 0.9) {
-                std::shared_ptr<IMaterial> sphere_material;
+                const IMaterial* sphere_material;
 
                 if (choose_mat < 0.8) {
                     // diffuse
-                    auto albedo = vec3_random() * vec3_random();
-                    sphere_material = std::make_shared<Lambertian>(albedo);
+                    auto albedo = vec3_random(sampler) * vec3_random(sampler);
+                    sphere_material = scene.add_material<Lambertian>(albedo);
                     scene.add_hittable<Sphere>(center, 0.2, sphere_material);
                 } else if (choose_mat < 0.95) {
                     // metal
-                    auto albedo = vec3_random(0.5, 1);
-                    auto fuzz = random_double(0, 0.5);
-                    sphere_material = std::make_shared<Metal>(albedo, fuzz);
+                    auto albedo = vec3_random(sampler, 0.5, 1);
+                    auto fuzz = sampler.next_real(0, real(0.5));
+                    sphere_material = scene.add_material<Metal>(albedo, fuzz);
                     scene.add_hittable<Sphere>(center, 0.2, sphere_material);
                 } else {
                     // glass
-                    sphere_material = std::make_shared<Dielectric>(1.5);
+                    sphere_material = scene.add_material<Dielectric>(1.5);
                     scene.add_hittable<Sphere>(center, 0.2, sphere_material);
                 }
             }
         }
     }
 
-    auto material1 = std::make_shared<Dielectric>(1.5);
+    auto material1 = scene.add_material<Dielectric>(1.5);
     scene.add_hittable<Sphere>(vec3(0, 1, 0), 1.0, material1);
 
-    auto material2 = std::make_shared<Lambertian>(vec3(0.4, 0.2, 0.1));
+    auto material2 = scene.add_material<Lambertian>(vec3(0.4, 0.2, 0.1));
     scene.add_hittable<Sphere>(vec3(-4, 1, 0), 1.0, material2);
 
-    auto material3 = std::make_shared<Metal>(vec3(0.7, 0.6, 0.5), 0.0);
+    auto material3 = scene.add_material<Metal>(vec3(0.7, 0.6, 0.5), 0.0);
     scene.add_hittable<Sphere>(vec3(4, 1, 0), 1.0, material3);
 }
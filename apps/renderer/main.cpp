@@ -1,3 +1,4 @@
+#include <filesystem>
 #include <iostream>
 
 #include "scene_parser.h"
@@ -5,11 +6,13 @@
 #include "camera.h"
 #include "ray_tracer.h"
 #include "image_dumper.h"
-#include "hittable/bvh_node.h"
+#include "accumulation_buffer.h"
+#include "hittable/wide_bvh.h"
 
 int main(int32_t argc, const char* argv[]) {
     if (argc < 2) {
-        std::cout << "Usage: ./RayTracerRenderer <scene_file>.json\n";
+        std::cout << "Usage: ./RayTracerRenderer <scene_file>.json [<checkpoint_file>]\n";
+        std::cout << "    With a checkpoint the render is progressive, and resumes from the checkpoint if it exists\n";
         return 1;
     }
 
@@ -19,19 +22,43 @@ int main(int32_t argc, const char* argv[]) {
         return 1;
 
     Camera camera(parser->camera_description());
-    PPMImageDumper image(camera.width(), camera.height());
+    P6ImageDumper image(camera.width(), camera.height());
+    // Written linearly, the brightness of a pixel is proportional to its number of samples
+    P6ImageDumper sample_counts(camera.width(), camera.height(), IImageDumper::Transfer::Linear);
 
-    const auto bvh_scene = BVHNode(*parser->scene());
+    const auto bvh_scene = WideBVH(*parser->scene());
 
-    const RayTracer ray_tracer({
+    RayTracer::Description description{
         .samples_per_pixel = 50,
         .max_depth = 20,
         .num_threads = RayTracer::max_num_threads(),
-    });
+        .adaptive_sampling = true,
+    };
 
-    ray_tracer.render(camera, bvh_scene, image);
+    if (argc < 3) {
+        const RayTracer ray_tracer(description);
+        ray_tracer.render(camera, bvh_scene, image, &sample_counts);
+
+        image.dump("output.ppm");
+        sample_counts.dump("sample_counts.ppm");
+
+        return 0;
+    }
+
+    const std::filesystem::path checkpoint = argv[2];
+    description.checkpoint_path = checkpoint;
+
+    auto accumulation = std::filesystem::exists(checkpoint)
+                            ? AccumulationBuffer::load(checkpoint)
+                            : AccumulationBuffer(camera.width(), camera.height(), description.seed);
+    if (!accumulation)
+        return 1;
+
+    const RayTracer ray_tracer(description);
+    if (!ray_tracer.render_progressive(camera, bvh_scene, *accumulation, image))
+        return 1;
 
     image.dump("output.ppm");
 
     return 0;
-}
\ No newline at end of file
+}
@@ -8,6 +8,7 @@
 using json = nlohmann::json;
 
 #include "material.h"
+#include "texture_cache.h"
 #include "hittable/sphere.h"
 #include "hittable/hittable_list.h"
 
@@ -28,6 +29,8 @@ SceneParser::SceneParser(const std::filesystem::path& path) {
 
     m_camera_description = {};
     m_scene = std::make_shared<HittableList>();
+    m_textures = std::make_shared<TextureCache>(TextureCache::Description{});
+    m_directory = path.parent_path();
 
     if (data.contains("camera"))
         parse_camera(data["camera"]);
@@ -55,24 +58,34 @@ void SceneParser::parse_camera(const auto& data) {
     m_camera_description.up = parse_value(data, "up", m_camera_description.up);
 }
 
-std::shared_ptr<IMaterial> parse_material(const json& data) {
+const IMaterial* parse_material(const json& data,
+                                HittableList& scene,
+                                TextureCache& textures,
+                                const std::filesystem::path& directory) {
     const auto& type = data["type"];
 
-    std::shared_ptr<IMaterial> mat;
-    if (type == "lambertian") {
+    const IMaterial* mat;
+    if (type == "lambertian" && data.contains("texture")) {
+        const auto path = directory / data["texture"].get<std::string>();
+        const auto texture = textures.get(path, Texture::Filtering::Trilinear);
+        if (texture == nullptr)
+            return nullptr;
+
+        mat = scene.add_material<Lambertian>(texture);
+    } else if (type == "lambertian") {
         const auto albedo = parse_value(data, "albedo", vec3(1.0));
-        mat = std::make_shared<Lambertian>(albedo);
+        mat = scene.add_material<Lambertian>(albedo);
     } else if (type == "metal") {
         const auto albedo = parse_value(data, "albedo", vec3(1.0));
-        const auto fuzz = parse_value(data, "fuzz", 0.0);
-        mat = std::make_shared<Metal>(albedo, fuzz);
+        const auto fuzz = parse_value(data, "fuzz", real(0));
+        mat = scene.add_material<Metal>(albedo, fuzz);
     } else if (type == "dielectric") {
-        const auto refraction_index = parse_value(data, "index", 0.0);
-        mat = std::make_shared<Dielectric>(refraction_index);
+        const auto refraction_index = parse_value(data, "index", real(0));
+        mat = scene.add_material<Dielectric>(refraction_index);
     } else if (type == "emissive") {
         const auto color = parse_value(data, "color", vec3(1.0));
-        const auto intensity = parse_value(data, "intensity", 1.0);
-        mat = std::make_shared<DiffuseEmissive>(color, intensity);
+        const auto intensity = parse_value(data, "intensity", real(1));
+        mat = scene.add_material<DiffuseEmissive>(color, intensity);
     } else {
         std::cout << "Material with type: '" << type << "' not supported\n";
         return nullptr;
@@ -89,9 +102,9 @@ void SceneParser::parse_scene(const auto& data) {
 
         if (type == "sphere") {
             const auto center = parse_value(obj, "center", vec3(0.0));
-            const auto radius = parse_value(obj, "radius", 0.5);
+            const auto radius = parse_value(obj, "radius", real(0.5));
 
-            const auto material = parse_material(obj["material"]);
+            const auto material = parse_material(obj["material"], *m_scene, *m_textures, m_directory);
             assert(material != nullptr);
 
             m_scene->add_hittable<Sphere>(center, radius, material);
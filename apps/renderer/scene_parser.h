@@ -7,6 +7,7 @@
 #include "camera.h"
 
 class HittableList;
+class TextureCache;
 
 class SceneParser {
   public:
@@ -18,6 +19,8 @@ class SceneParser {
   private:
     Camera::Description m_camera_description{};
     std::shared_ptr<HittableList> m_scene{};
+    std::shared_ptr<TextureCache> m_textures{}; // Owns the textures of the materials of the scene
+    std::filesystem::path m_directory{};         // Texture paths are relative to the scene file
 
     SceneParser(const std::filesystem::path& path);
 
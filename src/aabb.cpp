@@ -1,13 +1,15 @@
 #include "aabb.h"
 
+#include <cmath>
+
 #include "ray.h"
 
 AABB::AABB(interval x, interval y, interval z) : m_x(x), m_y(y), m_z(z) {}
 
 AABB::AABB(vec3 a, vec3 b) {
-    m_x = interval(fmin(a.x, b.x), fmax(a.x, b.x));
-    m_y = interval(fmin(a.y, b.y), fmax(a.y, b.y));
-    m_z = interval(fmin(a.z, b.z), fmax(a.z, b.z));
+    m_x = interval(std::fmin(a.x, b.x), std::fmax(a.x, b.x));
+    m_y = interval(std::fmin(a.y, b.y), std::fmax(a.y, b.y));
+    m_z = interval(std::fmin(a.z, b.z), std::fmax(a.z, b.z));
 }
 
 AABB::AABB(const AABB& a, const AABB& b) {
@@ -16,6 +18,11 @@ AABB::AABB(const AABB& a, const AABB& b) {
     m_z = interval(a.m_z, b.m_z);
 }
 
+real AABB::surface_area() const {
+    const auto extent = max() - min();
+    return 2 * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+}
+
 const interval& AABB::axis(uint32_t n) const {
     if (n == 1)
         return m_y;
@@ -29,7 +36,7 @@ bool AABB::hit(const Ray& ray, const interval& ray_t) const {
     auto ray_t_max = ray_t.max;
 
     for (uint32_t a = 0; a < 3; ++a) {
-        const auto inv_direction = 1.0 / ray.direction()[static_cast<int32_t>(a)];
+        const auto inv_direction = real(1) / ray.direction()[static_cast<int32_t>(a)];
         const auto origin = ray.origin()[static_cast<int32_t>(a)];
 
         auto t0 = (axis(a).min - origin) * inv_direction;
@@ -38,12 +45,14 @@ bool AABB::hit(const Ray& ray, const interval& ray_t) const {
         if (inv_direction < 0)
             std::swap(t0, t1);
 
-        if (t0 > ray_t.min)
+        // Shrink the running interval, so the result is the intersection of the three slabs
+        if (t0 > ray_t_min)
             ray_t_min = t0;
-        if (t1 < ray_t.max)
+        if (t1 < ray_t_max)
             ray_t_max = t1;
 
-        if (ray_t_max <= ray_t_min)
+        // Strict comparison so that flat boxes (e.g. axis aligned triangles) are not missed
+        if (ray_t_max < ray_t_min)
             return false;
     }
 
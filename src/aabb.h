@@ -16,6 +16,9 @@ class AABB {
     [[nodiscard]] vec3 max() const { return vec3(m_x.max, m_y.max, m_z.max); }
     [[nodiscard]] vec3 min() const { return vec3(m_x.min, m_y.min, m_z.min); }
 
+    [[nodiscard]] vec3 centroid() const { return (min() + max()) * real(0.5); }
+    [[nodiscard]] real surface_area() const;
+
     [[nodiscard]] const interval& axis(uint32_t n) const;
     [[nodiscard]] bool hit(const Ray& ray, const interval& ray_t) const;
 
@@ -0,0 +1,117 @@
+#include "accumulation_buffer.h"
+
+#include <array>
+#include <cassert>
+#include <fstream>
+#include <iostream>
+
+// Checkpoint layout, in native byte order: magic, version, width, height, seed, then the sums of all the pixels as
+// three doubles each, whatever the precision of the build, and their sample counts
+static constexpr std::array<char, 4> CHECKPOINT_MAGIC = {'R', 'T', 'A', 'B'};
+static constexpr uint32_t CHECKPOINT_VERSION = 1;
+
+template <typename T>
+static void write_value(std::ofstream& file, const T& value) {
+    file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+static bool read_value(std::ifstream& file, T& value) {
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+AccumulationBuffer::AccumulationBuffer(uint32_t width, uint32_t height, uint64_t seed)
+      : m_width(width),
+        m_height(height),
+        m_seed(seed),
+        m_sums(static_cast<std::size_t>(width) * height, vec3(0.0)),
+        m_num_samples(static_cast<std::size_t>(width) * height, 0) {}
+
+std::optional<AccumulationBuffer> AccumulationBuffer::load(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return std::nullopt;
+
+    std::array<char, 4> magic{};
+    uint32_t version = 0, width = 0, height = 0;
+    uint64_t seed = 0;
+
+    if (!read_value(file, magic) || magic != CHECKPOINT_MAGIC || !read_value(file, version) ||
+        version != CHECKPOINT_VERSION || !read_value(file, width) || !read_value(file, height) ||
+        !read_value(file, seed)) {
+        std::cout << "Not a valid checkpoint: " << path << "\n";
+        return std::nullopt;
+    }
+
+    // The header is not trusted to size the allocation, the pixels it declares must all be in the file
+    constexpr auto pixel_size = 3 * sizeof(double) + sizeof(uint32_t);
+    std::error_code error;
+    const auto file_size = std::filesystem::file_size(path, error);
+    const auto header_size = static_cast<uintmax_t>(file.tellg());
+    if (error || file_size < header_size ||
+        static_cast<uintmax_t>(width) * height > (file_size - header_size) / pixel_size) {
+        std::cout << "Truncated checkpoint: " << path << "\n";
+        return std::nullopt;
+    }
+
+    AccumulationBuffer buffer(width, height, seed);
+
+    for (auto& sum : buffer.m_sums) {
+        std::array<double, 3> values{};
+        if (!read_value(file, values)) {
+            std::cout << "Truncated checkpoint: " << path << "\n";
+            return std::nullopt;
+        }
+        sum = vec3(values[0], values[1], values[2]);
+    }
+
+    for (auto& num_samples : buffer.m_num_samples) {
+        if (!read_value(file, num_samples)) {
+            std::cout << "Truncated checkpoint: " << path << "\n";
+            return std::nullopt;
+        }
+    }
+
+    return buffer;
+}
+
+bool AccumulationBuffer::save(const std::filesystem::path& path) const {
+    auto temporary = path;
+    temporary += ".tmp";
+
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file)
+            return false;
+
+        write_value(file, CHECKPOINT_MAGIC);
+        write_value(file, CHECKPOINT_VERSION);
+        write_value(file, m_width);
+        write_value(file, m_height);
+        write_value(file, m_seed);
+
+        for (const auto& sum : m_sums) {
+            const std::array<double, 3> values = {sum.x, sum.y, sum.z};
+            write_value(file, values);
+        }
+
+        for (const auto num_samples : m_num_samples)
+            write_value(file, num_samples);
+
+        file.flush();
+        if (!file)
+            return false;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    return !error;
+}
+
+void AccumulationBuffer::add(std::size_t row, std::size_t col, const vec3& sum, uint32_t num_samples) {
+    assert(row < m_height && col < m_width);
+
+    const auto pixel = row * m_width + col;
+    m_sums[pixel] += sum;
+    m_num_samples[pixel] += num_samples;
+}
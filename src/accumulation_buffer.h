@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+#include "vec.h"
+
+// Sums and counts of the samples taken by every pixel of a progressive render. The random stream of a sample only
+// depends on (seed, pixel, sample index), and the samples of a pixel are indexed from its count, so the buffer and
+// its seed are all the state needed to resume a render exactly where it stopped.
+class AccumulationBuffer {
+  public:
+    AccumulationBuffer(uint32_t width, uint32_t height, uint64_t seed);
+
+    // Reads a checkpoint written by save, std::nullopt if it is missing or not valid
+    [[nodiscard]] static std::optional<AccumulationBuffer> load(const std::filesystem::path& path);
+
+    // Writes a temporary file first and renames it, so an interrupted save never destroys the previous checkpoint.
+    // Returns false if the file could not be written.
+    [[nodiscard]] bool save(const std::filesystem::path& path) const;
+
+    [[nodiscard]] uint32_t width() const { return m_width; }
+    [[nodiscard]] uint32_t height() const { return m_height; }
+    [[nodiscard]] uint64_t seed() const { return m_seed; }
+
+    void add(std::size_t row, std::size_t col, const vec3& sum, uint32_t num_samples);
+
+    [[nodiscard]] const vec3& sum(std::size_t row, std::size_t col) const { return m_sums[row * m_width + col]; }
+    [[nodiscard]] uint32_t num_samples(std::size_t row, std::size_t col) const {
+        return m_num_samples[row * m_width + col];
+    }
+
+  private:
+    uint32_t m_width, m_height;
+    uint64_t m_seed;
+
+    std::vector<vec3> m_sums;
+    std::vector<uint32_t> m_num_samples;
+};
@@ -0,0 +1,92 @@
+#include "adaptive_sampling.h"
+
+#include <algorithm>
+#include <limits>
+
+// Relative luminance of a linear RGB color
+static real luminance(const vec3& color) {
+    return glm::dot(color, vec3(0.2126, 0.7152, 0.0722));
+}
+
+AdaptiveSampling::AdaptiveSampling(Description description, uint32_t width, uint32_t height, uint64_t budget)
+      : m_desc(description), m_width(width), m_height(height), m_budget(budget), m_pixels(width * height) {
+    m_desc.min_samples = std::max(m_desc.min_samples, 2u);
+    m_desc.batch_size = std::max(m_desc.batch_size, 1u);
+}
+
+const std::vector<AdaptiveSampling::Request>& AdaptiveSampling::next_round() {
+    m_round.clear();
+
+    if (m_first_round) {
+        m_first_round = false;
+
+        const auto total = static_cast<uint64_t>(m_desc.min_samples) * m_pixels.size();
+        m_budget -= std::min(m_budget, total);
+
+        for (uint32_t pixel = 0; pixel < m_pixels.size(); ++pixel)
+            m_round.push_back({.pixel = pixel, .first_sample = 0, .num_samples = m_desc.min_samples});
+
+        return m_round;
+    }
+
+    m_noisy.clear();
+    for (uint32_t pixel = 0; pixel < m_pixels.size(); ++pixel) {
+        const auto error = neighbourhood_error(pixel);
+        if (error >= m_desc.threshold)
+            m_noisy.emplace_back(error, pixel);
+    }
+
+    // Ties are broken by pixel index, so the rounds only depend on the samples taken
+    std::sort(m_noisy.begin(), m_noisy.end(), [](const auto& a, const auto& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
+
+    for (const auto& [error, pixel] : m_noisy) {
+        if (m_budget == 0)
+            break;
+
+        const auto num_samples = static_cast<uint32_t>(std::min<uint64_t>(m_desc.batch_size, m_budget));
+        m_budget -= num_samples;
+
+        m_round.push_back({.pixel = pixel, .first_sample = m_pixels[pixel].num_samples, .num_samples = num_samples});
+    }
+
+    return m_round;
+}
+
+void AdaptiveSampling::add_sample(uint32_t pixel, const vec3& radiance) {
+    auto& estimate = m_pixels[pixel];
+    estimate.sum += radiance;
+    estimate.num_samples++;
+
+    const auto value = luminance(radiance);
+    const auto delta = value - estimate.mean;
+    estimate.mean += delta / static_cast<real>(estimate.num_samples);
+    estimate.m2 += delta * (value - estimate.mean);
+}
+
+real AdaptiveSampling::relative_error(uint32_t pixel) const {
+    const auto& estimate = m_pixels[pixel];
+    if (estimate.num_samples < 2)
+        return std::numeric_limits<real>::infinity();
+
+    // Luminance is never negative, so a zero mean means every sample was black
+    if (estimate.m2 <= 0 || estimate.mean <= 0)
+        return 0;
+
+    const auto n = static_cast<real>(estimate.num_samples);
+    const auto variance = estimate.m2 / (n - real(1));
+    return glm::sqrt(variance / n) / estimate.mean;
+}
+
+real AdaptiveSampling::neighbourhood_error(uint32_t pixel) const {
+    const auto row = pixel / m_width;
+    const auto col = pixel % m_width;
+
+    real error = 0;
+    for (auto r = std::max(row, 1u) - 1; r <= std::min(row + 1, m_height - 1); ++r)
+        for (auto c = std::max(col, 1u) - 1; c <= std::min(col + 1, m_width - 1); ++c)
+            error = std::max(error, relative_error(r * m_width + c));
+
+    return error;
+}
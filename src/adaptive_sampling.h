@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "vec.h"
+
+// Spreads the sample budget of a rectangle of pixels, e.g. a tile, between them. Every pixel first takes
+// min_samples, then the pixels that are still noisy receive batch_size more samples per round, noisiest first,
+// until they converge or the budget runs out. Noise is the relative standard error of the mean luminance, tracked
+// with Welford's running variance. A few samples often miss rare bright paths and underestimate the variance, so a
+// pixel only converges once all its neighbours have too.
+class AdaptiveSampling {
+  public:
+    struct Description {
+        uint32_t min_samples = 8;
+        uint32_t batch_size = 8;
+        real threshold = real(0.05); // Relative error under which a pixel stops taking samples
+    };
+
+    // Samples to take for a pixel. Sample indices continue from the ones the pixel already took.
+    struct Request {
+        uint32_t pixel;
+        uint32_t first_sample;
+        uint32_t num_samples;
+    };
+
+    // Pixels are indexed row by row. budget is the total number of samples of all the pixels, at least min_samples
+    // each are always taken.
+    AdaptiveSampling(Description description, uint32_t width, uint32_t height, uint64_t budget);
+
+    // Requests of the next round, empty once every pixel has converged or the budget is spent. The samples of a
+    // round must all be added before asking for the next one.
+    [[nodiscard]] const std::vector<Request>& next_round();
+
+    void add_sample(uint32_t pixel, const vec3& radiance);
+
+    [[nodiscard]] const vec3& sum(uint32_t pixel) const { return m_pixels[pixel].sum; }
+    [[nodiscard]] uint32_t num_samples(uint32_t pixel) const { return m_pixels[pixel].num_samples; }
+    // Error of the pixel alone, and largest error of the pixel and its 8 neighbours
+    [[nodiscard]] real relative_error(uint32_t pixel) const;
+    [[nodiscard]] real neighbourhood_error(uint32_t pixel) const;
+
+    [[nodiscard]] bool converged(uint32_t pixel) const { return neighbourhood_error(pixel) < m_desc.threshold; }
+
+  private:
+    struct PixelEstimate {
+        vec3 sum{0.0};
+        uint32_t num_samples = 0;
+
+        // Running mean and sum of squared deviations of the luminance
+        real mean = 0;
+        real m2 = 0;
+    };
+
+    Description m_desc;
+    uint32_t m_width, m_height;
+    uint64_t m_budget; // Samples not handed out yet
+    bool m_first_round = true;
+
+    std::vector<PixelEstimate> m_pixels;
+    std::vector<Request> m_round;
+    std::vector<std::pair<real, uint32_t>> m_noisy; // (relative error, pixel), sorted noisiest first
+};
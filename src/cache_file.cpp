@@ -0,0 +1,102 @@
+#include "cache_file.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <string>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//
+// MappedFile
+//
+
+std::optional<MappedFile> MappedFile::open(const std::filesystem::path& path) {
+    const auto descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0)
+        return std::nullopt;
+
+    struct stat status {};
+    if (::fstat(descriptor, &status) != 0 || status.st_size <= 0) {
+        ::close(descriptor);
+        return std::nullopt;
+    }
+
+    const auto size = static_cast<std::size_t>(status.st_size);
+    auto* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+
+    // The mapping stays valid once the descriptor is closed
+    ::close(descriptor);
+
+    if (data == MAP_FAILED)
+        return std::nullopt;
+
+    // The whole file is read right away, start loading it
+    ::madvise(data, size, MADV_WILLNEED);
+
+    return MappedFile(static_cast<const std::byte*>(data), size);
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+      : m_data(std::exchange(other.m_data, nullptr)), m_size(std::exchange(other.m_size, 0)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    std::swap(m_data, other.m_data);
+    std::swap(m_size, other.m_size);
+    return *this;
+}
+
+MappedFile::~MappedFile() {
+    if (m_data != nullptr)
+        ::munmap(const_cast<std::byte*>(m_data), m_size);
+}
+
+//
+// CacheWriter
+//
+
+// Writes all of data, resuming after partial writes and interruptions
+static bool write_all(int descriptor, std::span<const std::byte> data) {
+    while (!data.empty()) {
+        const auto written = ::write(descriptor, data.data(), data.size());
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+            return false;
+
+        data = data.subspan(static_cast<std::size_t>(written));
+    }
+
+    return true;
+}
+
+bool CacheWriter::save(const std::filesystem::path& path) const {
+    // Unique temporary file next to the cache, so concurrent writers of the same cache never share it and the rename
+    // stays on one file system
+    auto temporary = path.string() + ".XXXXXX";
+    const auto descriptor = ::mkstemp(temporary.data());
+    if (descriptor < 0)
+        return false;
+
+    auto saved = write_all(descriptor, m_data);
+    saved = ::close(descriptor) == 0 && saved;
+
+    std::error_code error;
+    if (saved)
+        std::filesystem::rename(temporary, path, error);
+
+    if (!saved || error) {
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+
+    return true;
+}
+
+void CacheWriter::append(const void* data, std::size_t size) {
+    const auto* bytes = static_cast<const std::byte*>(data);
+    m_data.insert(m_data.end(), bytes, bytes + size);
+}
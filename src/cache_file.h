@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+// Read only memory mapping of a whole file. Pages are loaded by the OS on first access, so opening a large file is
+// cheap and its contents are shared with the page cache instead of being copied into a stream buffer.
+class MappedFile {
+  public:
+    // std::nullopt if the file is missing, empty or cannot be mapped
+    [[nodiscard]] static std::optional<MappedFile> open(const std::filesystem::path& path);
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    ~MappedFile();
+
+    [[nodiscard]] std::span<const std::byte> bytes() const { return {m_data, m_size}; }
+
+  private:
+    MappedFile(const std::byte* data, std::size_t size) : m_data(data), m_size(size) {}
+
+    const std::byte* m_data = nullptr;
+    std::size_t m_size = 0;
+};
+
+// Builds a binary cache in memory from trivially copyable values and arrays, in native byte order, and writes it
+// to disk in a single block
+class CacheWriter {
+  public:
+    template <typename T>
+    void write(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        append(&value, sizeof(T));
+    }
+
+    // Arrays are stored as their size followed by the elements
+    template <typename T>
+    void write(const std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        write(static_cast<uint64_t>(values.size()));
+        append(values.data(), values.size() * sizeof(T));
+    }
+
+    // Writes a uniquely named temporary file first and renames it, so readers never map a partially written cache.
+    // Returns false, leaving no temporary file behind, if the file could not be written.
+    [[nodiscard]] bool save(const std::filesystem::path& path) const;
+
+  private:
+    std::vector<std::byte> m_data;
+
+    void append(const void* data, std::size_t size);
+};
+
+// Reads back the values and arrays written by CacheWriter, in the same order. Every read is checked against the
+// end of the data and fails once the data is exhausted, so a truncated file is detected instead of read past.
+// Arrays are copied out of the data, which is packed without alignment, so they do not refer to it once read.
+class CacheReader {
+  public:
+    explicit CacheReader(std::span<const std::byte> data) : m_data(data) {}
+
+    template <typename T>
+    [[nodiscard]] bool read(T& value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        return extract(&value, sizeof(T));
+    }
+
+    template <typename T>
+    [[nodiscard]] bool read(std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+        uint64_t size = 0;
+        if (!read(size) || size > remaining() / sizeof(T))
+            return false;
+
+        values.resize(static_cast<std::size_t>(size));
+        return extract(values.data(), values.size() * sizeof(T));
+    }
+
+    [[nodiscard]] std::size_t remaining() const { return m_data.size() - m_offset; }
+
+  private:
+    std::span<const std::byte> m_data;
+    std::size_t m_offset = 0;
+
+    [[nodiscard]] bool extract(void* destination, std::size_t size) {
+        if (size > remaining())
+            return false;
+
+        std::memcpy(destination, m_data.data() + m_offset, size);
+        m_offset += size;
+        return true;
+    }
+};
@@ -10,7 +10,7 @@ class Camera {
         uint32_t height = 1080;
 
         // Camera positioning
-        double vertical_fov = 90.0; // in degrees 
+        real vertical_fov = 90.0; // in degrees 
         vec3 look_from = vec3(0.0, 0.0, -1.0);
         vec3 look_at = vec3(0.0);
         vec3 up = vec3(0.0, 1.0, 0.0);
@@ -25,9 +25,13 @@ class Camera {
     [[nodiscard]] std::pair<vec3, vec3> deltas() const { return {m_delta_u, m_delta_v}; }
     [[nodiscard]] vec3 pixel00_location() const { return m_pixel00_loc; }
 
+    // Angle covered by a pixel, the spread of the ray cones of camera rays
+    [[nodiscard]] real pixel_spread() const { return m_pixel_spread; }
+
   private:
     Description m_desc;
 
     vec3 m_delta_u{}, m_delta_v{};
     vec3 m_pixel00_loc{};
+    real m_pixel_spread = 0;
 };
@@ -0,0 +1,226 @@
+#include "bvh_builder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <numeric>
+
+BVHBuilder::BVHBuilder(Description description) : m_desc(description) {
+    m_desc.num_bins = std::max(m_desc.num_bins, 2u);
+    m_desc.max_leaf_size = std::max(m_desc.max_leaf_size, 1u);
+}
+
+BVHBuilder::Result BVHBuilder::build(const std::vector<AABB>& primitive_bounds) const {
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    Result result{};
+    if (primitive_bounds.empty())
+        return result;
+
+    const auto num_primitives = static_cast<uint32_t>(primitive_bounds.size());
+
+    result.primitive_indices.resize(num_primitives);
+    std::iota(result.primitive_indices.begin(), result.primitive_indices.end(), 0u);
+    result.nodes.reserve(2 * num_primitives - 1);
+
+    BuildContext context{
+        .bounds = primitive_bounds,
+        .centroids = {},
+        .result = result,
+    };
+
+    context.centroids.reserve(num_primitives);
+    for (const auto& bbox : primitive_bounds)
+        context.centroids.push_back(bbox.centroid());
+
+    build_r(context, 0, num_primitives, 1);
+
+    const auto end = std::chrono::high_resolution_clock::now();
+
+    result.report.num_primitives = num_primitives;
+    result.report.num_nodes = static_cast<uint32_t>(result.nodes.size());
+    result.report.sah_cost = sah_cost(result);
+    result.report.build_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+    return result;
+}
+
+uint32_t BVHBuilder::build_r(BuildContext& context, uint32_t start, uint32_t end, uint32_t depth) const {
+    auto& nodes = context.result.nodes;
+    auto& indices = context.result.primitive_indices;
+
+    auto node_box = context.bounds[indices[start]];
+    for (auto i = start + 1; i < end; ++i)
+        node_box = AABB(node_box, context.bounds[indices[i]]);
+
+    const auto node_index = static_cast<uint32_t>(nodes.size());
+    nodes.push_back(Node{.bounding_box = node_box});
+
+    const auto can_split = (end - start) > 1 && depth < MAX_DEPTH;
+    const auto middle = can_split ? partition(context, start, end, node_box) : start;
+
+    if (middle == start) {
+        nodes[node_index].first_primitive = start;
+        nodes[node_index].num_primitives = end - start;
+
+        auto& report = context.result.report;
+        report.num_leaves++;
+        report.max_depth = std::max(report.max_depth, depth);
+        report.max_leaf_primitives = std::max(report.max_leaf_primitives, end - start);
+
+        return node_index;
+    }
+
+    // Left child is always placed right after its parent
+    const auto left = build_r(context, start, middle, depth + 1);
+    const auto right = build_r(context, middle, end, depth + 1);
+
+    nodes[node_index].left = left;
+    nodes[node_index].right = right;
+
+    return node_index;
+}
+
+uint32_t BVHBuilder::partition(BuildContext& context, uint32_t start, uint32_t end, const AABB& node_box) const {
+    auto& indices = context.result.primitive_indices;
+    const auto& centroids = context.centroids;
+
+    const auto count = end - start;
+    const auto num_bins = m_desc.num_bins;
+
+    auto centroid_min = centroids[indices[start]];
+    auto centroid_max = centroids[indices[start]];
+    for (auto i = start + 1; i < end; ++i) {
+        centroid_min = glm::min(centroid_min, centroids[indices[i]]);
+        centroid_max = glm::max(centroid_max, centroids[indices[i]]);
+    }
+
+    const auto node_area = node_box.surface_area();
+    const auto inv_node_area = node_area > 0.0 ? 1.0 / node_area : 0.0;
+
+    const auto bin_index = [&](uint32_t primitive, int32_t axis) {
+        const auto extent = centroid_max[axis] - centroid_min[axis];
+        const auto offset = (centroids[primitive][axis] - centroid_min[axis]) / extent;
+        return std::min(static_cast<uint32_t>(offset * static_cast<real>(num_bins)), num_bins - 1);
+    };
+
+    struct Bin {
+        AABB bounding_box;
+        uint32_t count = 0;
+    };
+
+    auto best_cost = std::numeric_limits<double>::infinity();
+    auto best_axis = -1;
+    auto best_split = 0u;
+
+    std::vector<Bin> bins(num_bins);
+    std::vector<double> right_cost(num_bins);
+
+    for (int32_t axis = 0; axis < 3; ++axis) {
+        if (centroid_max[axis] <= centroid_min[axis])
+            continue;
+
+        std::fill(bins.begin(), bins.end(), Bin{});
+
+        for (auto i = start; i < end; ++i) {
+            auto& bin = bins[bin_index(indices[i], axis)];
+            const auto& bbox = context.bounds[indices[i]];
+
+            bin.bounding_box = bin.count == 0 ? bbox : AABB(bin.bounding_box, bbox);
+            bin.count++;
+        }
+
+        // Sweep from the right, storing the cost of the right side of every split plane
+        Bin accumulated{};
+        for (auto b = num_bins - 1; b > 0; --b) {
+            if (bins[b].count > 0) {
+                accumulated.bounding_box = accumulated.count == 0
+                                               ? bins[b].bounding_box
+                                               : AABB(accumulated.bounding_box, bins[b].bounding_box);
+                accumulated.count += bins[b].count;
+            }
+            right_cost[b] = accumulated.count == 0
+                                ? 0.0
+                                : accumulated.bounding_box.surface_area() * static_cast<real>(accumulated.count);
+        }
+
+        // Sweep from the left, evaluating the split between bins [0, b) and [b, num_bins)
+        accumulated = {};
+        for (auto b = 1u; b < num_bins; ++b) {
+            if (bins[b - 1].count > 0) {
+                accumulated.bounding_box = accumulated.count == 0
+                                               ? bins[b - 1].bounding_box
+                                               : AABB(accumulated.bounding_box, bins[b - 1].bounding_box);
+                accumulated.count += bins[b - 1].count;
+            }
+
+            if (accumulated.count == 0 || accumulated.count == count)
+                continue;
+
+            const auto left_cost = accumulated.bounding_box.surface_area() * static_cast<real>(accumulated.count);
+            const auto cost =
+                m_desc.traversal_cost + m_desc.intersection_cost * (left_cost + right_cost[b]) * inv_node_area;
+
+            if (cost < best_cost) {
+                best_cost = cost;
+                best_axis = axis;
+                best_split = b;
+            }
+        }
+    }
+
+    const auto leaf_cost = m_desc.intersection_cost * count;
+
+    if (best_axis == -1) {
+        // All centroids are in the same position, there is no plane that separates them
+        return count <= m_desc.max_leaf_size ? start : start + count / 2;
+    }
+
+    if (count <= m_desc.max_leaf_size && best_cost >= leaf_cost)
+        return start;
+
+    const auto middle_it = std::partition(indices.begin() + start, indices.begin() + end, [&](uint32_t primitive) {
+        return bin_index(primitive, best_axis) < best_split;
+    });
+    auto middle = static_cast<uint32_t>(middle_it - indices.begin());
+
+    if (middle == start || middle == end) {
+        // Should not happen with a valid split, but fall back to a median split along the chosen axis
+        middle = start + count / 2;
+        std::nth_element(indices.begin() + start,
+                         indices.begin() + middle,
+                         indices.begin() + end,
+                         [&](uint32_t a, uint32_t b) { return centroids[a][best_axis] < centroids[b][best_axis]; });
+    }
+
+    return middle;
+}
+
+double BVHBuilder::sah_cost(const Result& result) const {
+    const auto root_area = result.nodes.front().bounding_box.surface_area();
+    if (root_area <= 0.0)
+        return 0.0;
+
+    auto cost = 0.0;
+    for (const auto& node : result.nodes) {
+        const auto relative_area = node.bounding_box.surface_area() / root_area;
+
+        if (node.is_leaf())
+            cost += m_desc.intersection_cost * node.num_primitives * relative_area;
+        else
+            cost += m_desc.traversal_cost * relative_area;
+    }
+
+    return cost;
+}
+
+std::ostream& operator<<(std::ostream& os, const BVHBuilder::Report& report) {
+    os << "BVH information:\n";
+    os << "    Primitives: " << report.num_primitives << "\n";
+    os << "    Nodes: " << report.num_nodes << " (" << report.num_leaves << " leaves)\n";
+    os << "    Max depth: " << report.max_depth << "\n";
+    os << "    Max primitives per leaf: " << report.max_leaf_primitives << "\n";
+    os << "    SAH cost: " << report.sah_cost << "\n";
+    os << "    Build time: " << report.build_time_ms << "ms\n";
+    return os;
+}
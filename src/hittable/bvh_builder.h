@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "aabb.h"
+
+// Builds a binary BVH over a set of primitive bounding boxes using the binned Surface Area Heuristic.
+// The builder only works with indices, so the resulting hierarchy can be turned into any node representation.
+class BVHBuilder {
+  public:
+    // Nodes at this depth are turned into leaves, which bounds the traversal stack size
+    static constexpr uint32_t MAX_DEPTH = 64;
+
+    struct Description {
+        uint32_t num_bins = 16;     // Number of bins evaluated per axis when looking for a split
+        uint32_t max_leaf_size = 4; // Nodes with more primitives than this are always split
+
+        // SAH cost model
+        double traversal_cost = 1.0;
+        double intersection_cost = 1.0;
+    };
+
+    struct Node {
+        AABB bounding_box;
+
+        // Interior nodes: index of the children in the node list
+        uint32_t left = 0;
+        uint32_t right = 0;
+
+        // Leaf nodes: range inside the primitive index list
+        uint32_t first_primitive = 0;
+        uint32_t num_primitives = 0;
+
+        [[nodiscard]] bool is_leaf() const { return num_primitives > 0; }
+    };
+
+    struct Report {
+        uint32_t num_primitives = 0;
+        uint32_t num_nodes = 0;
+        uint32_t num_leaves = 0;
+        uint32_t max_depth = 0;
+        uint32_t max_leaf_primitives = 0;
+
+        double sah_cost = 0.0; // Expected cost of a random ray hitting the root bounding box
+        double build_time_ms = 0.0;
+    };
+
+    struct Result {
+        // Nodes are stored in depth-first order: nodes[0] is the root and the left child of
+        // an interior node always immediately follows it
+        std::vector<Node> nodes;
+        std::vector<uint32_t> primitive_indices;
+        Report report;
+    };
+
+    explicit BVHBuilder(Description description);
+
+    [[nodiscard]] Result build(const std::vector<AABB>& primitive_bounds) const;
+
+  private:
+    Description m_desc;
+
+    struct BuildContext {
+        const std::vector<AABB>& bounds;
+        std::vector<vec3> centroids;
+        Result& result;
+    };
+
+    uint32_t build_r(BuildContext& context, uint32_t start, uint32_t end, uint32_t depth) const;
+    [[nodiscard]] uint32_t partition(BuildContext& context, uint32_t start, uint32_t end, const AABB& node_box) const;
+
+    [[nodiscard]] double sah_cost(const Result& result) const;
+};
+
+std::ostream& operator<<(std::ostream& os, const BVHBuilder::Report& report);
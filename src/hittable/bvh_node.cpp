@@ -1,46 +1,73 @@
 #include "bvh_node.h"
 
-#include <algorithm>
+#include <cassert>
 
-#include "rand.h"
+#include "interval.h"
 #include "hittable/hittable_list.h"
 
-BVHNode::BVHNode(const HittableList& list) : BVHNode(list.objects(), 0, list.objects().size()) {}
+BVHNode::BVHNode(const HittableList& list, BVHBuilder::Description description)
+      : BVHNode(list.objects(), description) {}
 
-BVHNode::BVHNode(const std::vector<std::shared_ptr<IHittable>>& objects, std::size_t start, std::size_t end) {
-    const auto axis = random_int(0, 2);
-    const auto comparator = (axis == 0) ? box_x_compare : (axis == 1) ? box_y_compare : box_z_compare;
+BVHNode::BVHNode(const std::vector<std::shared_ptr<IHittable>>& objects, BVHBuilder::Description description)
+      : BVHNode(objects, 0, objects.size(), description) {}
 
-    const auto span = end - start;
+BVHNode::BVHNode(const std::vector<std::shared_ptr<IHittable>>& objects,
+                 std::size_t start,
+                 std::size_t end,
+                 BVHBuilder::Description description) {
+    assert(start < end && end <= objects.size());
 
-    if (span == 1) {
-        m_left = m_right = objects[start];
-    } else if (span == 2) {
-        if (comparator(objects[start], objects[start + 1])) {
-            m_left = objects[start];
-            m_right = objects[start + 1];
-        } else {
-            m_left = objects[start + 1];
-            m_right = objects[start];
-        }
-    } else {
-        auto objs = objects;
-        std::sort(objs.begin() + start, objs.begin() + end, comparator);
+    const auto range = std::vector<std::shared_ptr<IHittable>>(objects.begin() + static_cast<std::ptrdiff_t>(start),
+                                                               objects.begin() + static_cast<std::ptrdiff_t>(end));
+
+    std::vector<AABB> bounds;
+    bounds.reserve(range.size());
+    for (const auto& object : range)
+        bounds.push_back(object->bounding_box());
+
+    const auto result = BVHBuilder(description).build(bounds);
+    *this = BVHNode(range, result, 0);
+    m_report = result.report;
+}
 
-        const auto middle = start + span / 2;
-        m_left = std::make_shared<BVHNode>(objs, start, middle);
-        m_right = std::make_shared<BVHNode>(objs, middle, end);
+BVHNode::BVHNode(const std::vector<std::shared_ptr<IHittable>>& objects,
+                 const BVHBuilder::Result& result,
+                 uint32_t node) {
+    const auto& build_node = result.nodes[node];
+    m_bounding_box = build_node.bounding_box;
+
+    if (build_node.is_leaf()) {
+        m_primitives.reserve(build_node.num_primitives);
+        for (auto i = 0u; i < build_node.num_primitives; ++i)
+            m_primitives.push_back(objects[result.primitive_indices[build_node.first_primitive + i]]);
+        return;
     }
 
-    m_bounding_box = AABB(m_left->bounding_box(), m_right->bounding_box());
+    m_left = std::shared_ptr<BVHNode>(new BVHNode(objects, result, build_node.left));
+    m_right = std::shared_ptr<BVHNode>(new BVHNode(objects, result, build_node.right));
 }
 
-std::optional<HitRecord> BVHNode::hits(const Ray& ray, const interval& ray_t) const {
+std::optional<Intersection> BVHNode::intersect(const Ray& ray, const interval& ray_t) const {
     if (!m_bounding_box.hit(ray, ray_t))
         return {};
 
-    auto hit_left = m_left->hits(ray, ray_t);
-    auto hit_right = m_right->hits(ray, interval(ray_t.min, hit_left.has_value() ? hit_left->ts : ray_t.max));
+    if (m_left == nullptr) {
+        std::optional<Intersection> record;
+        auto closest_max_t = ray_t.max;
+
+        for (const auto& primitive : m_primitives) {
+            const auto r = primitive->intersect(ray, interval(ray_t.min, closest_max_t));
+            if (r.has_value()) {
+                record = r;
+                closest_max_t = record->t;
+            }
+        }
+
+        return record;
+    }
+
+    auto hit_left = m_left->intersect(ray, ray_t);
+    auto hit_right = m_right->intersect(ray, interval(ray_t.min, hit_left.has_value() ? hit_left->t : ray_t.max));
 
     if (hit_right.has_value())
         return hit_right;
@@ -51,18 +78,13 @@ AABB BVHNode::bounding_box() const {
     return m_bounding_box;
 }
 
-bool BVHNode::box_compare(const std::shared_ptr<IHittable>& a, const std::shared_ptr<IHittable>& b, uint32_t axis) {
-    return a->bounding_box().axis(axis).min < b->bounding_box().axis(axis).min;
-}
-
-bool BVHNode::box_x_compare(const std::shared_ptr<IHittable>& a, const std::shared_ptr<IHittable>& b) {
-    return box_compare(a, b, 0);
-}
+void BVHNode::collect_lights(LightList& lights) const {
+    if (m_left == nullptr) {
+        for (const auto& primitive : m_primitives)
+            primitive->collect_lights(lights);
+        return;
+    }
 
-bool BVHNode::box_y_compare(const std::shared_ptr<IHittable>& a, const std::shared_ptr<IHittable>& b) {
-    return box_compare(a, b, 1);
+    m_left->collect_lights(lights);
+    m_right->collect_lights(lights);
 }
-
-bool BVHNode::box_z_compare(const std::shared_ptr<IHittable>& a, const std::shared_ptr<IHittable>& b) {
-    return box_compare(a, b, 2);
-}
\ No newline at end of file
@@ -3,28 +3,36 @@
 #include <vector>
 
 #include "hittable/hittable.h"
+#include "hittable/bvh_builder.h"
 
 // Forward declarations
 class HittableList;
 
 class BVHNode : public IHittable {
   public:
-    explicit BVHNode(const HittableList& list);
-    BVHNode(const std::vector<std::shared_ptr<IHittable>>& objects, std::size_t start, std::size_t end);
-
-    [[nodiscard]] std::optional<HitRecord> hits(const Ray& ray, const interval& ray_t) const override;
+    explicit BVHNode(const HittableList& list, BVHBuilder::Description description = {});
+    explicit BVHNode(const std::vector<std::shared_ptr<IHittable>>& objects, BVHBuilder::Description description = {});
+    BVHNode(const std::vector<std::shared_ptr<IHittable>>& objects,
+            std::size_t start,
+            std::size_t end,
+            BVHBuilder::Description description = {});
+
+    [[nodiscard]] std::optional<Intersection> intersect(const Ray& ray, const interval& ray_t) const override;
     [[nodiscard]] AABB bounding_box() const override;
+    void collect_lights(LightList& lights) const override;
+
+    // Only valid on the root node of the hierarchy
+    [[nodiscard]] const BVHBuilder::Report& report() const { return m_report; }
 
   private:
     std::shared_ptr<IHittable> m_left;
     std::shared_ptr<IHittable> m_right;
 
+    // Only used by leaf nodes
+    std::vector<std::shared_ptr<IHittable>> m_primitives;
+
     AABB m_bounding_box;
+    BVHBuilder::Report m_report{};
 
-    [[nodiscard]] static bool box_compare(const std::shared_ptr<IHittable>& a,
-                                          const std::shared_ptr<IHittable>& b,
-                                          uint32_t axis);
-    [[nodiscard]] static bool box_x_compare(const std::shared_ptr<IHittable>& a, const std::shared_ptr<IHittable>& b);
-    [[nodiscard]] static bool box_y_compare(const std::shared_ptr<IHittable>& a, const std::shared_ptr<IHittable>& b);
-    [[nodiscard]] static bool box_z_compare(const std::shared_ptr<IHittable>& a, const std::shared_ptr<IHittable>& b);
+    BVHNode(const std::vector<std::shared_ptr<IHittable>>& objects, const BVHBuilder::Result& result, uint32_t node);
 };
@@ -0,0 +1,33 @@
+#include "hittable.h"
+
+#include <bit>
+#include <cassert>
+
+#include "interval.h"
+
+HitRecord IHittable::compute_interaction(const Ray& ray, const Intersection& intersection) const {
+    const auto* target = intersection.instance != nullptr ? intersection.instance : intersection.hittable;
+    assert(target != this && "Hittables producing intersections must compute their interaction");
+    return target->compute_interaction(ray, intersection);
+}
+
+std::optional<HitRecord> IHittable::hits(const Ray& ray, const interval& ray_t) const {
+    const auto intersection = intersect(ray, ray_t);
+    if (!intersection.has_value())
+        return {};
+
+    return compute_interaction(ray, *intersection);
+}
+
+void IHittable::intersect_packet(const RayPacket& packet, uint32_t active, PacketHitRecord& record) const {
+    while (active != 0) {
+        const auto lane = static_cast<uint32_t>(std::countr_zero(active));
+        active &= active - 1;
+
+        const auto intersection = intersect(packet.rays[lane], interval(record.t_min, record.t_max[lane]));
+        if (intersection.has_value()) {
+            record.t_max[lane] = intersection->t;
+            record.intersections[lane] = intersection;
+        }
+    }
+}
@@ -5,19 +5,24 @@
 
 #include "vec.h"
 #include "ray.h"
+#include "ray_packet.h"
 #include "aabb.h"
 
 // Forward declarations
+class IHittable;
 class IMaterial;
+class LightList;
 class interval;
 
 struct HitRecord {
     vec3 point;
     vec3 normal;
     vec2 uv;
-    double ts;
+    real ts;
     bool front_face;
-    std::shared_ptr<IMaterial> material;
+    const IMaterial* material = nullptr; // Owned by the scene, see HittableList::add_material
+    real uv_density = 0;                 // Change of the texture coordinates per unit of surface length, 0 if unknown
+    vec3 u_gradient{0}, v_gradient{0};   // Gradients of the texture coordinates along the surface, 0 if unknown
 
     // outward_normal assumed to be normalized
     void set_front_face(const Ray& ray, const vec3& outward_normal) {
@@ -26,10 +31,42 @@ struct HitRecord {
     }
 };
 
+// Result of the intersection query: only what is needed to find the closest hit. The full HitRecord is computed
+// once per ray, from the closest intersection, by IHittable::compute_interaction.
+struct Intersection {
+    real t;
+    real u, v;                           // Barycentric coordinates of the hit on triangles
+    uint32_t primitive;                  // Primitive inside the hittable, e.g. face of a mesh
+    const IHittable* hittable;           // Hittable computing the interaction
+    const IHittable* instance = nullptr; // Instance the hit was found through, moves the interaction to world space
+};
+
+// Closest intersections of the rays of a RayPacket. t_max of every lane shrinks as closer hits are found.
+struct PacketHitRecord {
+    real t_min = RAY_T_MIN;
+    real t_max[RayPacket::MAX_SIZE]{};
+    std::optional<Intersection> intersections[RayPacket::MAX_SIZE];
+};
+
 class IHittable {
   public:
     virtual ~IHittable() = default;
 
-    [[nodiscard]] virtual std::optional<HitRecord> hits(const Ray& ray, const interval& ray_t) const = 0;
+    [[nodiscard]] virtual std::optional<Intersection> intersect(const Ray& ray, const interval& ray_t) const = 0;
     [[nodiscard]] virtual AABB bounding_box() const = 0;
+
+    // Computes point, normal, uv and material of an intersection found by intersect. By default forwards to the
+    // instance or else the hittable of the intersection, so aggregates only need to implement the query.
+    [[nodiscard]] virtual HitRecord compute_interaction(const Ray& ray, const Intersection& intersection) const;
+
+    // Closest intersection and its interaction
+    [[nodiscard]] std::optional<HitRecord> hits(const Ray& ray, const interval& ray_t) const;
+
+    // Intersects the lanes of the packet set in active. By default every lane is traced on its own,
+    // acceleration structures override it to traverse the packet as a whole.
+    virtual void intersect_packet(const RayPacket& packet, uint32_t active, PacketHitRecord& record) const;
+
+    // Adds the emissive primitives to lights. Primitives add themselves if their material emits, aggregates
+    // forward the call to their children.
+    virtual void collect_lights([[maybe_unused]] LightList& lights) const {}
 };
@@ -1,14 +1,14 @@
 #include "hittable_list.h"
 
-std::optional<HitRecord> HittableList::hits(const Ray& ray, const interval& ray_t) const {
-    std::optional<HitRecord> record;
+std::optional<Intersection> HittableList::intersect(const Ray& ray, const interval& ray_t) const {
+    std::optional<Intersection> record;
     auto closest_max_t = ray_t.max;
 
     for (const auto& object : m_objects) {
-        const auto r = object->hits(ray, interval(ray_t.min, closest_max_t));
+        const auto r = object->intersect(ray, interval(ray_t.min, closest_max_t));
         if (r.has_value()) {
             record = r;
-            closest_max_t = record->ts;
+            closest_max_t = record->t;
         }
     }
 
@@ -18,3 +18,8 @@ std::optional<HitRecord> HittableList::hits(const Ray& ray, const interval& ray_
 AABB HittableList::bounding_box() const {
     return m_bounding_box;
 }
+
+void HittableList::collect_lights(LightList& lights) const {
+    for (const auto& object : m_objects)
+        object->collect_lights(lights);
+}
@@ -1,15 +1,21 @@
 #pragma once
 
+#include <memory>
 #include <vector>
 
 #include "hittable/hittable.h"
 #include "aabb.h"
+#include "material.h"
 
 class HittableList : public IHittable {
   public:
     HittableList() = default;
     ~HittableList() override = default;
 
+    // Movable only, the materials are uniquely owned
+    HittableList(HittableList&&) = default;
+    HittableList& operator=(HittableList&&) = default;
+
     template <typename T, typename... Args>
     void add_hittable(Args&&... args) {
         static_assert(std::is_base_of<IHittable, T>(), "Type must be of type IHittable");
@@ -18,12 +24,24 @@ class HittableList : public IHittable {
         m_bounding_box = AABB(m_bounding_box, m_objects.back()->bounding_box());
     }
 
-    [[nodiscard]] std::optional<HitRecord> hits(const Ray& ray, const interval& ray_t) const override;
+    // Materials are owned by the scene, primitives and hit records only reference them. The returned pointer stays
+    // valid for the lifetime of the list, which must outlive any acceleration structure built from it.
+    template <typename T, typename... Args>
+    const IMaterial* add_material(Args&&... args) {
+        static_assert(std::is_base_of<IMaterial, T>(), "Type must be of type IMaterial");
+        m_materials.push_back(std::make_unique<T>(args...));
+
+        return m_materials.back().get();
+    }
+
+    [[nodiscard]] std::optional<Intersection> intersect(const Ray& ray, const interval& ray_t) const override;
     [[nodiscard]] AABB bounding_box() const override;
+    void collect_lights(LightList& lights) const override;
 
     [[nodiscard]] const std::vector<std::shared_ptr<IHittable>>& objects() const { return m_objects; }
 
   private:
     std::vector<std::shared_ptr<IHittable>> m_objects;
+    std::vector<std::unique_ptr<IMaterial>> m_materials;
     AABB m_bounding_box;
 };
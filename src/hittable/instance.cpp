@@ -0,0 +1,116 @@
+#include "instance.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "interval.h"
+#include "ray_packet.h"
+
+static mat4 compose_transform(vec3 translation, vec3 scale, vec3 rotation) {
+    auto transform = mat4(1.0);
+    transform = glm::translate(transform, translation);
+    transform = glm::scale(transform, scale);
+    transform = glm::rotate(transform, rotation.x, vec3(1.0, 0.0, 0.0));
+    transform = glm::rotate(transform, rotation.y, vec3(0.0, 1.0, 0.0));
+    transform = glm::rotate(transform, rotation.z, vec3(0.0, 0.0, 1.0));
+    return transform;
+}
+
+static vec3 transform_point(const mat4& transform, const vec3& point) {
+    const auto transformed = transform * vec4(point, 1.0);
+    return vec3(transformed.x, transformed.y, transformed.z);
+}
+
+static vec3 transform_vector(const mat4& transform, const vec3& vector) {
+    const auto transformed = transform * vec4(vector, 0.0);
+    return vec3(transformed.x, transformed.y, transformed.z);
+}
+
+Instance::Instance(std::shared_ptr<IHittable> object, const mat4& object_to_world)
+      : m_object(std::move(object)),
+        m_object_to_world(object_to_world),
+        m_world_to_object(glm::inverse(object_to_world)),
+        m_normal_to_world(glm::transpose(mat3(m_world_to_object))),
+        m_scale(std::cbrt(std::abs(glm::determinant(mat3(object_to_world))))) {
+    // Bounds of the eight transformed corners of the object bounds
+    const auto object_bounds = m_object->bounding_box();
+    const vec3 corners[2] = {object_bounds.min(), object_bounds.max()};
+
+    auto min = vec3(std::numeric_limits<real>::max());
+    auto max = vec3(std::numeric_limits<real>::lowest());
+
+    for (uint32_t corner = 0; corner < 8; ++corner) {
+        const auto point = vec3(corners[corner & 1].x, corners[(corner >> 1) & 1].y, corners[(corner >> 2) & 1].z);
+        const auto transformed = transform_point(m_object_to_world, point);
+
+        min = glm::min(min, transformed);
+        max = glm::max(max, transformed);
+    }
+
+    m_bounding_box = AABB(min, max);
+}
+
+Instance::Instance(std::shared_ptr<IHittable> object, vec3 translation, vec3 scale, vec3 rotation)
+      : Instance(std::move(object), compose_transform(translation, scale, rotation)) {}
+
+std::optional<Intersection> Instance::intersect(const Ray& ray, const interval& ray_t) const {
+    auto intersection = m_object->intersect(to_object(ray), ray_t);
+    if (!intersection)
+        return std::nullopt;
+
+    assert(intersection->instance == nullptr && "Instances of instances are not supported");
+    intersection->instance = this;
+    return intersection;
+}
+
+AABB Instance::bounding_box() const {
+    return m_bounding_box;
+}
+
+HitRecord Instance::compute_interaction(const Ray& ray, const Intersection& intersection) const {
+    assert(intersection.instance == this);
+
+    auto record = intersection.hittable->compute_interaction(to_object(ray), intersection);
+
+    // The orientation of the normal against the ray is preserved by the transform, front_face stays valid
+    record.point = ray.at(record.ts);
+    record.normal = glm::normalize(m_normal_to_world * record.normal);
+    record.uv_density /= m_scale;
+
+    // Gradients are normals of the planes of constant u and v, they transform like normals without normalization
+    record.u_gradient = m_normal_to_world * record.u_gradient;
+    record.v_gradient = m_normal_to_world * record.v_gradient;
+
+    return record;
+}
+
+void Instance::intersect_packet(const RayPacket& packet, uint32_t active, PacketHitRecord& record) const {
+    RayPacket object_packet;
+    for (uint32_t lane = 0; lane < packet.size; ++lane)
+        object_packet.add(to_object(packet.rays[lane]));
+
+    if (packet.has_bounds)
+        object_packet.compute_bounds();
+
+    real t_max[RayPacket::MAX_SIZE];
+    std::copy(record.t_max, record.t_max + packet.size, t_max);
+
+    m_object->intersect_packet(object_packet, active, record);
+
+    // Lanes whose closest hit moved were hit through this instance
+    for (auto lanes = active; lanes != 0; lanes &= lanes - 1) {
+        const auto lane = static_cast<uint32_t>(std::countr_zero(lanes));
+        if (record.t_max[lane] != t_max[lane])
+            record.intersections[lane]->instance = this;
+    }
+}
+
+Ray Instance::to_object(const Ray& ray) const {
+    return {transform_point(m_world_to_object, ray.origin()),
+            transform_vector(m_world_to_object, ray.direction()),
+            ray.cone()};
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <memory>
+
+#include "hittable/hittable.h"
+
+// Shared hittable, typically a Mesh or Model with its own prebuilt hierarchy, placed in the scene with an affine
+// transform. Rays are moved into object space instead of copying the object with the transform baked in, so an
+// asset placed many times is stored and built once. A WideBVH over the instances forms the top level of the scene.
+//
+// Emissive instances are found by BSDF sampling only, they do not add lights for next event estimation.
+class Instance : public IHittable {
+  public:
+    Instance(std::shared_ptr<IHittable> object, const mat4& object_to_world);
+
+    // Transform built like the import transform of Model: translation * scale * rotations around x, y and z,
+    // in radians
+    Instance(std::shared_ptr<IHittable> object, vec3 translation, vec3 scale, vec3 rotation);
+
+    ~Instance() override = default;
+
+    [[nodiscard]] std::optional<Intersection> intersect(const Ray& ray, const interval& ray_t) const override;
+    [[nodiscard]] AABB bounding_box() const override;
+    [[nodiscard]] HitRecord compute_interaction(const Ray& ray, const Intersection& intersection) const override;
+
+    void intersect_packet(const RayPacket& packet, uint32_t active, PacketHitRecord& record) const override;
+
+  private:
+    std::shared_ptr<IHittable> m_object;
+
+    mat4 m_object_to_world;
+    mat4 m_world_to_object;
+    mat3 m_normal_to_world; // Inverse transpose, keeps normals perpendicular under non uniform scaling
+    real m_scale;           // Average scaling of lengths, as if the scaling was uniform
+    AABB m_bounding_box;
+
+    // The direction is transformed but not normalized, so distances along the ray are the same in both spaces
+    [[nodiscard]] Ray to_object(const Ray& ray) const;
+};
@@ -0,0 +1,143 @@
+#include "linear_bvh.h"
+
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#include "interval.h"
+#include "hittable/hittable_list.h"
+
+LinearBVH::LinearBVH(const HittableList& list, BVHBuilder::Description description)
+      : LinearBVH(list.objects(), description) {}
+
+LinearBVH::LinearBVH(const std::vector<std::shared_ptr<IHittable>>& objects, BVHBuilder::Description description) {
+    if (objects.empty())
+        return;
+
+    std::vector<AABB> bounds;
+    bounds.reserve(objects.size());
+    for (const auto& object : objects)
+        bounds.push_back(object->bounding_box());
+
+    const auto result = BVHBuilder(description).build(bounds);
+    assert(result.report.max_leaf_primitives <= std::numeric_limits<uint16_t>::max());
+
+    m_report = result.report;
+    m_bounding_box = result.nodes.front().bounding_box;
+
+    m_primitives.reserve(objects.size());
+    for (const auto index : result.primitive_indices)
+        m_primitives.push_back(objects[index]);
+
+    // Builder nodes are already in depth-first order, so they map one to one to the linear nodes
+    m_nodes.resize(result.nodes.size());
+    for (std::size_t i = 0; i < result.nodes.size(); ++i) {
+        const auto& build_node = result.nodes[i];
+        auto& node = m_nodes[i];
+
+        for (uint32_t axis = 0; axis < 3; ++axis) {
+            const auto& extent = build_node.bounding_box.axis(axis);
+            node.min[axis] = std::nextafter(static_cast<float>(extent.min), -std::numeric_limits<float>::infinity());
+            node.max[axis] = std::nextafter(static_cast<float>(extent.max), std::numeric_limits<float>::infinity());
+        }
+
+        node.axis = 0;
+        node.second_below = 0;
+
+        if (build_node.is_leaf()) {
+            node.offset = build_node.first_primitive;
+            node.num_primitives = static_cast<uint16_t>(build_node.num_primitives);
+        } else {
+            assert(build_node.left == i + 1);
+            node.offset = build_node.right;
+            node.num_primitives = 0;
+
+            // Pick the axis that best separates the children, used to visit the nearest child first
+            const auto separation = result.nodes[build_node.right].bounding_box.centroid() -
+                                    result.nodes[build_node.left].bounding_box.centroid();
+            const auto distance = glm::abs(separation);
+
+            node.axis = distance.x > distance.y ? (distance.x > distance.z ? 0 : 2) : (distance.y > distance.z ? 1 : 2);
+            node.second_below = separation[node.axis] < 0.0 ? 1 : 0;
+        }
+    }
+}
+
+std::optional<Intersection> LinearBVH::intersect(const Ray& ray, const interval& ray_t) const {
+    if (m_nodes.empty())
+        return {};
+
+    const auto origin = ray.origin();
+    const auto inv_direction = real(1) / ray.direction();
+    const bool direction_negative[3] = {inv_direction.x < 0.0, inv_direction.y < 0.0, inv_direction.z < 0.0};
+
+    const auto hits_node = [&](const Node& node, real t_max) {
+        auto t_min = ray_t.min;
+
+        for (int32_t a = 0; a < 3; ++a) {
+            auto t0 = (static_cast<real>(node.min[a]) - origin[a]) * inv_direction[a];
+            auto t1 = (static_cast<real>(node.max[a]) - origin[a]) * inv_direction[a];
+
+            if (direction_negative[a])
+                std::swap(t0, t1);
+
+            // Written so that NaNs (0 * inf) do not shrink the interval
+            t_min = t0 > t_min ? t0 : t_min;
+            t_max = t1 < t_max ? t1 : t_max;
+
+            if (t_max < t_min)
+                return false;
+        }
+
+        return true;
+    };
+
+    std::optional<Intersection> record;
+    auto closest_max_t = ray_t.max;
+
+    uint32_t stack[BVHBuilder::MAX_DEPTH];
+    uint32_t stack_size = 0;
+    uint32_t current = 0;
+
+    while (true) {
+        const auto& node = m_nodes[current];
+
+        if (hits_node(node, closest_max_t)) {
+            if (node.num_primitives > 0) {
+                for (uint32_t i = node.offset; i < node.offset + node.num_primitives; ++i) {
+                    const auto r = m_primitives[i]->intersect(ray, interval(ray_t.min, closest_max_t));
+                    if (r.has_value()) {
+                        record = r;
+                        closest_max_t = record->t;
+                    }
+                }
+
+                if (stack_size == 0)
+                    break;
+                current = stack[--stack_size];
+            } else if (direction_negative[node.axis] != static_cast<bool>(node.second_below)) {
+                // Second child is nearest along the ray, visit it first
+                stack[stack_size++] = current + 1;
+                current = node.offset;
+            } else {
+                stack[stack_size++] = node.offset;
+                current = current + 1;
+            }
+        } else {
+            if (stack_size == 0)
+                break;
+            current = stack[--stack_size];
+        }
+    }
+
+    return record;
+}
+
+AABB LinearBVH::bounding_box() const {
+    return m_bounding_box;
+}
+
+void LinearBVH::collect_lights(LightList& lights) const {
+    for (const auto& primitive : m_primitives)
+        primitive->collect_lights(lights);
+}
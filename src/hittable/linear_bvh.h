@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+
+#include "hittable/hittable.h"
+#include "hittable/bvh_builder.h"
+
+// Forward declarations
+class HittableList;
+
+// BVH stored as a flat array of nodes in depth-first order. Children and primitives are referenced
+// by offsets instead of pointers and the hierarchy is traversed iteratively with an explicit stack.
+class LinearBVH : public IHittable {
+  public:
+    struct alignas(32) Node {
+        // Bounds are stored in single precision, rounded outwards so they always contain the primitives
+        float min[3];
+        float max[3];
+
+        // Interior nodes: index of the second child (first child is the next node)
+        // Leaf nodes: index of the first primitive
+        uint32_t offset;
+        uint16_t num_primitives; // 0 for interior nodes
+        uint8_t axis;            // Axis along which the children are best separated
+        uint8_t second_below;    // Whether the second child lies below the first one along axis
+    };
+    static_assert(sizeof(Node) == 32);
+
+    explicit LinearBVH(const HittableList& list, BVHBuilder::Description description = {});
+    explicit LinearBVH(const std::vector<std::shared_ptr<IHittable>>& objects,
+                       BVHBuilder::Description description = {});
+    ~LinearBVH() override = default;
+
+    [[nodiscard]] std::optional<Intersection> intersect(const Ray& ray, const interval& ray_t) const override;
+    [[nodiscard]] AABB bounding_box() const override;
+    void collect_lights(LightList& lights) const override;
+
+    [[nodiscard]] const BVHBuilder::Report& report() const { return m_report; }
+    [[nodiscard]] const std::vector<Node>& nodes() const { return m_nodes; }
+
+  private:
+    std::vector<Node> m_nodes;
+    std::vector<std::shared_ptr<IHittable>> m_primitives; // Ordered so that every leaf references a contiguous range
+
+    AABB m_bounding_box;
+    BVHBuilder::Report m_report{};
+};
@@ -1,5 +1,12 @@
 #include "model.h"
 
+#include <bit>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <vector>
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -8,139 +15,411 @@
 #include <assimp/postprocess.h>
 
 #include "material.h"
-#include "hittable/bvh_node.h"
+#include "light_list.h"
+#include "cache_file.h"
+#include "hittable/wide_bvh.h"
+#include "hittable/model_cache.h"
 
 //
 // Mesh
 //
 
+static std::vector<AABB> face_bounds(const std::vector<Triangle::Vertex>& vertices, const std::vector<uvec3>& faces) {
+    std::vector<AABB> bounds;
+    bounds.reserve(faces.size());
+
+    for (const auto& f : faces) {
+        const auto min = glm::min(glm::min(vertices[f.x].pos, vertices[f.y].pos), vertices[f.z].pos);
+        const auto max = glm::max(glm::max(vertices[f.x].pos, vertices[f.y].pos), vertices[f.z].pos);
+        bounds.emplace_back(min, max);
+    }
+
+    return bounds;
+}
+
+// Appends the first vertex and the two edges of a face to intersection arrays of any precision
+template <typename Arrays>
+static void add_face(Arrays& arrays, const vec3& a, const vec3& b, const vec3& c) {
+    using T = typename std::remove_reference_t<decltype(arrays.vertex[0])>::value_type;
+
+    const auto edge_1 = b - a;
+    const auto edge_2 = c - a;
+
+    for (int32_t axis = 0; axis < 3; ++axis) {
+        arrays.vertex[axis].push_back(static_cast<T>(a[axis]));
+        arrays.edge_1[axis].push_back(static_cast<T>(edge_1[axis]));
+        arrays.edge_2[axis].push_back(static_cast<T>(edge_2[axis]));
+    }
+}
+
+template <typename Arrays>
+static void reserve_faces(Arrays& arrays, std::size_t num_faces) {
+    for (uint32_t a = 0; a < 3; ++a) {
+        arrays.vertex[a].reserve(num_faces);
+        arrays.edge_1[a].reserve(num_faces);
+        arrays.edge_2[a].reserve(num_faces);
+    }
+}
+
+template <typename Arrays>
+static vec3 element(const Arrays& arrays, uint32_t face) {
+    return {arrays[0][face], arrays[1][face], arrays[2][face]};
+}
+
+template <typename Arrays>
+static std::pair<vec3, vec3> face_edges(const Arrays& arrays, uint32_t face) {
+    return {element(arrays.edge_1, face), element(arrays.edge_2, face)};
+}
+
+template <typename Arrays>
+static std::size_t arrays_size(const Arrays& arrays) {
+    std::size_t size = 0;
+    for (uint32_t a = 0; a < 3; ++a) {
+        size += arrays.vertex[a].size() * sizeof(arrays.vertex[a][0]);
+        size += arrays.edge_1[a].size() * sizeof(arrays.edge_1[a][0]);
+        size += arrays.edge_2[a].size() * sizeof(arrays.edge_2[a][0]);
+    }
+    return size;
+}
+
+template <typename Arrays>
+static void write_arrays(CacheWriter& writer, const Arrays& arrays) {
+    for (uint32_t a = 0; a < 3; ++a) {
+        writer.write(arrays.vertex[a]);
+        writer.write(arrays.edge_1[a]);
+        writer.write(arrays.edge_2[a]);
+    }
+}
+
+// Reads the arrays written by write_arrays, and checks that there is one entry per face
+template <typename Arrays>
+static bool read_arrays(CacheReader& reader, Arrays& arrays, std::size_t num_faces) {
+    for (uint32_t a = 0; a < 3; ++a) {
+        if (!reader.read(arrays.vertex[a]) || !reader.read(arrays.edge_1[a]) || !reader.read(arrays.edge_2[a]))
+            return false;
+
+        if (arrays.vertex[a].size() != num_faces || arrays.edge_1[a].size() != num_faces ||
+            arrays.edge_2[a].size() != num_faces)
+            return false;
+    }
+    return true;
+}
+
+Mesh::Mesh(const std::vector<Triangle::Vertex>& vertices,
+           const std::vector<uvec3>& faces,
+           const IMaterial* material)
+      : Mesh(vertices, faces, material, Description{}) {}
+
 Mesh::Mesh(const std::vector<Triangle::Vertex>& vertices,
            const std::vector<uvec3>& faces,
-           const std::shared_ptr<IMaterial>& material) {
-    auto max = vec3(std::numeric_limits<double>::min());
-    auto min = vec3(std::numeric_limits<double>::max());
+           const IMaterial* material,
+           Description description)
+      : m_bvh(face_bounds(vertices, faces)), m_description(description), m_material(material) {
+    if (description.float_positions)
+        reserve_faces(m_float_faces, faces.size());
+    else
+        reserve_faces(m_faces, faces.size());
+    m_indices.reserve(faces.size());
+
+    // Faces are stored in leaf order, so every BVH leaf references a contiguous range
+    for (const auto index : m_bvh.primitive_order()) {
+        const auto& face = faces[index];
+        const auto& a = vertices[face.x].pos;
+        const auto& b = vertices[face.y].pos;
+        const auto& c = vertices[face.z].pos;
+
+        if (description.float_positions)
+            add_face(m_float_faces, a, b, c);
+        else
+            add_face(m_faces, a, b, c);
+
+        m_indices.push_back(face);
+    }
 
-    for (const auto f : faces) {
-        const auto v1 = vertices[f.x];
-        const auto v2 = vertices[f.y];
-        const auto v3 = vertices[f.z];
+    if (description.compact_attributes) {
+        m_vertices.packed_uv.reserve(vertices.size());
+        m_vertices.packed_normal.reserve(vertices.size());
 
-        max = glm::max(max, glm::max(glm::max(v1.pos, v2.pos), v3.pos));
-        min = glm::min(min, glm::min(glm::min(v1.pos, v2.pos), v3.pos));
+        for (const auto& vertex : vertices) {
+            m_vertices.packed_uv.push_back(pack_half2(vertex.uv));
+            m_vertices.packed_normal.push_back(pack_octahedral(glm::normalize(vertex.normal)));
+        }
+    } else {
+        m_vertices.uv.reserve(vertices.size());
+        m_vertices.normal.reserve(vertices.size());
 
-        m_faces.emplace_back(v1, v2, v3, material);
+        for (const auto& vertex : vertices) {
+            m_vertices.uv.push_back(vertex.uv);
+            m_vertices.normal.push_back(vertex.normal);
+        }
     }
+}
+
+Mesh::Mesh(WideBVH bvh, const IMaterial* material, Description description)
+      : m_bvh(std::move(bvh)), m_description(description), m_material(material) {}
 
-    m_bounding_box = AABB(min, max);
+std::size_t Mesh::memory_size() const {
+    return arrays_size(m_faces) + arrays_size(m_float_faces) + m_indices.size() * sizeof(uvec3) +
+           m_vertices.uv.size() * sizeof(vec2) + m_vertices.normal.size() * sizeof(vec3) +
+           m_vertices.packed_uv.size() * sizeof(uint32_t) + m_vertices.packed_normal.size() * sizeof(uint32_t) +
+           m_bvh.nodes().size() * sizeof(WideBVH::Node) + m_bvh.primitive_order().size() * sizeof(uint32_t);
 }
 
-std::optional<HitRecord> Mesh::hits(const Ray& ray, const interval& ray_t) const {
-    std::optional<HitRecord> record;
-    auto closest_max_t = ray_t.max;
+void Mesh::save(CacheWriter& writer) const {
+    m_bvh.save(writer);
+    writer.write(m_description);
 
-    for (const auto& face : m_faces) {
-        const auto r = face.hits(ray, interval(ray_t.min, closest_max_t));
-        if (r.has_value()) {
-            record = r;
-            closest_max_t = record->ts;
-        }
+    if (m_description.float_positions)
+        write_arrays(writer, m_float_faces);
+    else
+        write_arrays(writer, m_faces);
+
+    writer.write(m_indices);
+
+    if (m_description.compact_attributes) {
+        writer.write(m_vertices.packed_uv);
+        writer.write(m_vertices.packed_normal);
+    } else {
+        writer.write(m_vertices.uv);
+        writer.write(m_vertices.normal);
     }
+}
 
-    return record;
+std::shared_ptr<Mesh> Mesh::load(CacheReader& reader, const IMaterial* material) {
+    auto bvh = WideBVH::load(reader);
+    if (!bvh)
+        return nullptr;
+
+    Description description;
+    if (!reader.read(description))
+        return nullptr;
+
+    // Constructor is private, std::make_shared cannot call it
+    std::shared_ptr<Mesh> mesh(new Mesh(std::move(*bvh), material, description));
+
+    const auto num_faces = mesh->m_bvh.primitive_order().size();
+    const auto faces_read = description.float_positions ? read_arrays(reader, mesh->m_float_faces, num_faces)
+                                                        : read_arrays(reader, mesh->m_faces, num_faces);
+    if (!faces_read || !reader.read(mesh->m_indices) || mesh->m_indices.size() != num_faces)
+        return nullptr;
+
+    auto& vertices = mesh->m_vertices;
+    const auto vertices_read = description.compact_attributes
+                                   ? reader.read(vertices.packed_uv) && reader.read(vertices.packed_normal) &&
+                                         vertices.packed_uv.size() == vertices.packed_normal.size()
+                                   : reader.read(vertices.uv) && reader.read(vertices.normal) &&
+                                         vertices.uv.size() == vertices.normal.size();
+    if (!vertices_read)
+        return nullptr;
+
+    // Indices out of the vertex buffer would be read on every hit
+    const auto num_vertices = description.compact_attributes ? vertices.packed_uv.size() : vertices.uv.size();
+    for (const auto& face : mesh->m_indices) {
+        if (face.x >= num_vertices || face.y >= num_vertices || face.z >= num_vertices)
+            return nullptr;
+    }
+
+    return mesh;
+}
+
+std::optional<Intersection> Mesh::intersect(const Ray& ray, const interval& ray_t) const {
+    std::optional<Intersection> closest;
+
+    m_bvh.traverse(ray, ray_t, [&](uint32_t first, uint32_t count, real t_max) {
+        return intersect_faces(ray, first, count, ray_t.min, t_max, closest);
+    });
+
+    return closest;
 }
 
 AABB Mesh::bounding_box() const {
-    return m_bounding_box;
+    return m_bvh.bounding_box();
 }
 
-//
-// Model
-//
+void Mesh::intersect_packet(const RayPacket& packet, uint32_t active, PacketHitRecord& record) const {
+    const auto intersect_leaf = [&](uint32_t first, uint32_t count, uint32_t lanes) {
+        for (; lanes != 0; lanes &= lanes - 1) {
+            const auto lane = static_cast<uint32_t>(std::countr_zero(lanes));
+            record.t_max[lane] = intersect_faces(
+                packet.rays[lane], first, count, record.t_min, record.t_max[lane], record.intersections[lane]);
+        }
+    };
 
-Model::Model(const std::filesystem::path& path) : Model(path, vec3(0.0), vec3(1.0), vec3(0.0)) {}
+    m_bvh.traverse_packet(packet, active, record.t_min, record.t_max, intersect_leaf);
+}
 
-Model::Model(const std::filesystem::path& path, vec3 translation, vec3 scale, vec3 rotation) {
-    auto transform = glm::dmat4(1.0);
-    transform = glm::translate(transform, translation);
-    transform = glm::scale(transform, scale);
-    transform = glm::rotate(transform, rotation.x, vec3(1.0, 0.0, 0.0));
-    transform = glm::rotate(transform, rotation.y, vec3(0.0, 1.0, 0.0));
-    transform = glm::rotate(transform, rotation.z, vec3(0.0, 0.0, 1.0));
+void Mesh::collect_lights(LightList& lights) const {
+    if (m_material == nullptr || !m_material->is_emissive())
+        return;
+
+    // Faces are added in leaf order, the order of Intersection::primitive
+    const auto add_faces = [&](const auto& arrays) {
+        for (uint32_t face = 0; face < num_faces(); ++face) {
+            lights.add_triangle(this,
+                                face,
+                                element(arrays.vertex, face),
+                                element(arrays.edge_1, face),
+                                element(arrays.edge_2, face));
+        }
+    };
 
-    Assimp::Importer importer;
+    if (m_description.float_positions)
+        add_faces(m_float_faces);
+    else
+        add_faces(m_faces);
+}
 
-    constexpr uint32_t flags = aiProcess_Triangulate | aiProcess_OptimizeMeshes | aiProcess_OptimizeGraph;
-    const auto scene = importer.ReadFile(path.c_str(), flags);
-    assert(scene); // TODO: UGLY
+real Mesh::intersect_faces(const Ray& ray,
+                           uint32_t first,
+                           uint32_t count,
+                           real t_min,
+                           real t_max,
+                           std::optional<Intersection>& closest) const {
+    if (m_description.float_positions)
+        return intersect_faces(m_float_faces, ray, first, count, t_min, t_max, closest);
 
-    auto max = vec3(std::numeric_limits<double>::min());
-    auto min = vec3(std::numeric_limits<double>::max());
+    return intersect_faces(m_faces, ray, first, count, t_min, t_max, closest);
+}
 
-    for (std::size_t i = 0; i < scene->mNumMeshes; ++i) {
-        const auto mesh = scene->mMeshes[i];
-        if (mesh->mNumVertices == 0)
+template <typename T>
+real Mesh::intersect_faces(const FaceArrays<T>& arrays,
+                           const Ray& ray,
+                           uint32_t first,
+                           uint32_t count,
+                           real t_min,
+                           real t_max,
+                           std::optional<Intersection>& closest) const {
+    // Möller–Trumbore intersection algorithm, with the edges precomputed:
+    // https://en.wikipedia.org/wiki/M%C3%B6ller%E2%80%93Trumbore_intersection_algorithm
+
+    const auto origin = ray.origin();
+    const auto direction = ray.direction();
+
+    const auto& [vertex_x, vertex_y, vertex_z] = arrays.vertex;
+    const auto& [edge_1_x, edge_1_y, edge_1_z] = arrays.edge_1;
+    const auto& [edge_2_x, edge_2_y, edge_2_z] = arrays.edge_2;
+
+    for (auto face = first; face < first + count; ++face) {
+        const auto edge_1 = vec3(edge_1_x[face], edge_1_y[face], edge_1_z[face]);
+        const auto edge_2 = vec3(edge_2_x[face], edge_2_y[face], edge_2_z[face]);
+
+        const auto ray_cross_e2 = glm::cross(direction, edge_2);
+        const auto det = glm::dot(edge_1, ray_cross_e2);
+        const auto inv_det = real(1) / det;
+
+        // Ray parallel to the triangle. det scales with the area of the face, so small faces are not rejected.
+        if (!std::isfinite(inv_det))
             continue;
 
-        load_mesh(mesh, transform);
-
-        max = glm::max(m_meshes.back()->bounding_box().max(), max);
-        min = glm::min(m_meshes.back()->bounding_box().min(), min);
-    }
+        const auto s = origin - vec3(vertex_x[face], vertex_y[face], vertex_z[face]);
+        const auto u = inv_det * glm::dot(s, ray_cross_e2);
 
-    m_meshes.clear();
+        if (u < 0 || u > 1)
+            continue;
 
-    // Normalize
-    auto size = max - min;
-    auto center = (max + min) * 0.5;
+        const auto s_cross_e1 = glm::cross(s, edge_1);
+        const auto v = inv_det * glm::dot(direction, s_cross_e1);
 
-    transform = glm::scale(glm::dmat4(1.0), vec3(2.0 / glm::max(size.x, glm::max(size.y, size.z)))) *
-                glm::translate(glm::dmat4(1.0), -center);
+        if (v < 0 || u + v > 1)
+            continue;
 
-    for (std::size_t i = 0; i < scene->mNumMeshes; ++i) {
-        const auto mesh = scene->mMeshes[i];
-        if (mesh->mNumVertices == 0)
+        const auto t = inv_det * glm::dot(edge_2, s_cross_e1);
+        if (t <= t_min || t >= t_max)
             continue;
 
-        load_mesh(mesh, transform);
+        closest = Intersection{.t = t, .u = u, .v = v, .primitive = face, .hittable = this};
+        t_max = t;
     }
 
-    // Create BVH from meshes
-    m_root = std::make_unique<BVHNode>(m_meshes, 0, m_meshes.size());
+    return t_max;
 }
 
-std::optional<HitRecord> Model::hits(const Ray& ray, const interval& ray_t) const {
-    return m_root->hits(ray, ray_t);
+vec2 Mesh::uv(uint32_t vertex) const {
+    if (m_description.compact_attributes)
+        return unpack_half2(m_vertices.packed_uv[vertex]);
+
+    return m_vertices.uv[vertex];
 }
 
-AABB Model::bounding_box() const {
-    return m_root->bounding_box();
+vec3 Mesh::normal(uint32_t vertex) const {
+    if (m_description.compact_attributes)
+        return unpack_octahedral(m_vertices.packed_normal[vertex]);
+
+    return m_vertices.normal[vertex];
+}
+
+HitRecord Mesh::compute_interaction(const Ray& ray, const Intersection& intersection) const {
+    const auto& face = m_indices[intersection.primitive];
+    const auto u = intersection.u;
+    const auto v = intersection.v;
+    const auto w = real(1) - u - v;
+
+    const auto uv_a = uv(face.x);
+    const auto uv_b = uv(face.y);
+    const auto uv_c = uv(face.z);
+
+    const auto [edge_1, edge_2] = m_description.float_positions ? face_edges(m_float_faces, intersection.primitive)
+                                                                : face_edges(m_faces, intersection.primitive);
+
+    HitRecord record{};
+    record.ts = intersection.t;
+    record.point = ray.at(record.ts);
+    record.uv = w * uv_a + u * uv_b + v * uv_c;
+    record.material = m_material;
+    record.uv_density = Triangle::uv_density(edge_1, edge_2, uv_b - uv_a, uv_c - uv_a);
+    std::tie(record.u_gradient, record.v_gradient) = Triangle::uv_gradients(edge_1, edge_2, uv_b - uv_a, uv_c - uv_a);
+
+    const auto outward_normal = w * normal(face.x) + u * normal(face.y) + v * normal(face.z);
+    record.set_front_face(ray, outward_normal);
+
+    return record;
 }
 
-static std::shared_ptr<IMaterial> s_sample_material = std::make_shared<Lambertian>(vec3(0.18));
+//
+// Model
+//
+
+static vec3 transform_point(const mat4& transform, const aiVector3D& point) {
+    const auto transformed = transform * vec4(point.x, point.y, point.z, 1.0);
+    return vec3(transformed.x, transformed.y, transformed.z) / transformed.w;
+}
+
+static AABB mesh_bounds(const aiMesh* mesh, const mat4& transform) {
+    auto max = vec3(std::numeric_limits<real>::lowest());
+    auto min = vec3(std::numeric_limits<real>::max());
+
+    for (std::size_t v = 0; v < mesh->mNumVertices; ++v) {
+        const auto pos = transform_point(transform, mesh->mVertices[v]);
+        max = glm::max(pos, max);
+        min = glm::min(pos, min);
+    }
 
-void Model::load_mesh(const aiMesh* mesh, const glm::dmat4& transform) {
+    return {min, max};
+}
+
+static std::shared_ptr<Mesh> load_mesh(const aiMesh* mesh, const mat4& transform, const IMaterial* material) {
     assert(mesh->HasTextureCoords(0));
 
-    // Load mesh info
+    // Normals are transformed by the inverse transpose, so they stay perpendicular under non uniform scaling
+    const auto normal_transform = glm::transpose(glm::inverse(mat3(transform)));
+
     std::vector<Triangle::Vertex> vertices;
-    std::vector<uvec3> face_indices;
+    vertices.reserve(mesh->mNumVertices);
 
     for (std::size_t v = 0; v < mesh->mNumVertices; ++v) {
-        const auto& vertex = mesh->mVertices[v];
         const auto& uv = mesh->mTextureCoords[0][v];
-
-        const auto tpos = transform * vec4(vertex.x, vertex.y, vertex.z, 1.0);
-        const auto pos = vec3(tpos.x, tpos.y, tpos.z) / tpos.w;
-
-        const auto normal = mesh->mNormals[v].Normalize();
+        const auto& normal = mesh->mNormals[v];
 
         vertices.push_back({
-            .pos = pos,
-            .uv = vec2(uv.x, 1.0 - uv.y),
-            .normal = vec3(normal.x, normal.y, normal.z),
+            .pos = transform_point(transform, mesh->mVertices[v]),
+            .uv = vec2(uv.x, 1.0f - uv.y),
+            .normal = glm::normalize(normal_transform * vec3(normal.x, normal.y, normal.z)),
         });
     }
 
+    std::vector<uvec3> face_indices;
+    face_indices.reserve(mesh->mNumFaces);
+
     for (std::size_t f = 0; f < mesh->mNumFaces; ++f) {
         const auto& face = mesh->mFaces[f];
         assert(face.mNumIndices == 3);
@@ -148,5 +427,105 @@ void Model::load_mesh(const aiMesh* mesh, const glm::dmat4& transform) {
         face_indices.emplace_back(face.mIndices[0], face.mIndices[1], face.mIndices[2]);
     }
 
-    m_meshes.push_back(std::make_shared<Mesh>(vertices, face_indices, s_sample_material));
-}
\ No newline at end of file
+    // Imported models are usually large, so positions are kept in float and the shading attributes quantized
+    const Mesh::Description description{.float_positions = true, .compact_attributes = true};
+    return std::make_shared<Mesh>(vertices, face_indices, material, description);
+}
+
+// Imports the meshes of the file with Assimp, transformed and then normalized to fit in [-1, 1]. Bounds are taken
+// from the raw vertex arrays, so every mesh is converted and has its hierarchy built only once, and independent
+// meshes are converted in parallel.
+static std::vector<std::shared_ptr<Mesh>> import_meshes(const std::filesystem::path& path,
+                                                        vec3 translation,
+                                                        vec3 scale,
+                                                        vec3 rotation,
+                                                        const IMaterial* material) {
+    auto transform = mat4(1.0);
+    transform = glm::translate(transform, translation);
+    transform = glm::scale(transform, scale);
+    transform = glm::rotate(transform, rotation.x, vec3(1.0, 0.0, 0.0));
+    transform = glm::rotate(transform, rotation.y, vec3(0.0, 1.0, 0.0));
+    transform = glm::rotate(transform, rotation.z, vec3(0.0, 0.0, 1.0));
+
+    Assimp::Importer importer;
+
+    constexpr uint32_t flags = aiProcess_Triangulate | aiProcess_OptimizeMeshes | aiProcess_OptimizeGraph;
+    const auto scene = importer.ReadFile(path.c_str(), flags);
+    assert(scene); // TODO: UGLY
+
+    const auto num_meshes = static_cast<int64_t>(scene->mNumMeshes);
+
+    std::vector<AABB> bounds(scene->mNumMeshes);
+    #pragma omp parallel for schedule(dynamic)
+    for (int64_t i = 0; i < num_meshes; ++i)
+        bounds[static_cast<std::size_t>(i)] = mesh_bounds(scene->mMeshes[i], transform);
+
+    auto max = vec3(std::numeric_limits<real>::lowest());
+    auto min = vec3(std::numeric_limits<real>::max());
+
+    for (std::size_t i = 0; i < scene->mNumMeshes; ++i) {
+        if (scene->mMeshes[i]->mNumVertices == 0)
+            continue;
+
+        max = glm::max(bounds[i].max(), max);
+        min = glm::min(bounds[i].min(), min);
+    }
+
+    // Normalize
+    auto size = max - min;
+    auto center = (max + min) * real(0.5);
+
+    transform = glm::scale(mat4(1.0), vec3(real(2) / glm::max(size.x, glm::max(size.y, size.z)))) *
+                glm::translate(mat4(1.0), -center) * transform;
+
+    // Meshes differ a lot in size, dynamic scheduling keeps the threads busy
+    std::vector<std::shared_ptr<Mesh>> meshes(scene->mNumMeshes);
+    #pragma omp parallel for schedule(dynamic)
+    for (int64_t i = 0; i < num_meshes; ++i) {
+        if (scene->mMeshes[i]->mNumVertices > 0)
+            meshes[static_cast<std::size_t>(i)] = load_mesh(scene->mMeshes[i], transform, material);
+    }
+
+    std::erase(meshes, nullptr);
+    return meshes;
+}
+
+Model::Model(const std::filesystem::path& path, const IMaterial* material)
+      : Model(path, vec3(0.0), vec3(1.0), vec3(0.0), material) {}
+
+Model::Model(const std::filesystem::path& path,
+             vec3 translation,
+             vec3 scale,
+             vec3 rotation,
+             const IMaterial* material) {
+    // Importing and building the hierarchies of every mesh is only done once per source file and transform
+    const auto key = ModelCache::key(path, translation, scale, rotation);
+    auto meshes = key ? ModelCache::load(*key, material) : std::nullopt;
+
+    if (!meshes) {
+        meshes = import_meshes(path, translation, scale, rotation, material);
+
+        if (key && !ModelCache::save(*key, *meshes))
+            std::cout << "Could not write the model cache " << ModelCache::path(*key) << "\n";
+    }
+
+    // Create BVH from meshes
+    m_meshes.assign(meshes->begin(), meshes->end());
+    m_root = std::make_unique<WideBVH>(m_meshes);
+}
+
+std::optional<Intersection> Model::intersect(const Ray& ray, const interval& ray_t) const {
+    return m_root->intersect(ray, ray_t);
+}
+
+AABB Model::bounding_box() const {
+    return m_root->bounding_box();
+}
+
+void Model::intersect_packet(const RayPacket& packet, uint32_t active, PacketHitRecord& record) const {
+    m_root->intersect_packet(packet, active, record);
+}
+
+void Model::collect_lights(LightList& lights) const {
+    m_root->collect_lights(lights);
+}
@@ -1,43 +1,121 @@
 #pragma once
 
+#include <memory>
 #include <vector>
 #include <filesystem>
 
 #include "hittable/hittable.h"
 #include "hittable/triangle.h"
+#include "hittable/wide_bvh.h"
 
 // Forward declarations
-struct aiMesh;
-struct aiScene;
+class CacheWriter;
+class CacheReader;
 
+// Triangle mesh sharing a single material. Face data is split by how often it is read: the intersection data
+// is stored as structure of arrays in BVH leaf order and read for every candidate face, while the shading
+// attributes are only fetched once the closest hit of a ray is known. Shading attributes stay in a shared vertex
+// buffer indexed by the faces, so a vertex used by several faces is stored once.
 class Mesh : public IHittable {
   public:
+    // Compact storage for large meshes, trading a little precision for memory
+    struct Description {
+        bool float_positions = false;    // Intersection data in single precision, whatever the precision of the build
+        bool compact_attributes = false; // Octahedral normals and half precision UVs, 4 bytes each per vertex
+    };
+
+    Mesh(const std::vector<Triangle::Vertex>& vertices,
+         const std::vector<uvec3>& faces,
+         const IMaterial* material);
     Mesh(const std::vector<Triangle::Vertex>& vertices,
          const std::vector<uvec3>& faces,
-         const std::shared_ptr<IMaterial>& material);
+         const IMaterial* material,
+         Description description);
     ~Mesh() override = default;
 
-    [[nodiscard]] std::optional<HitRecord> hits(const Ray& ray, const interval& ray_t) const override;
+    // Stores the face data and hierarchy as laid out in memory, and restores them without building anything.
+    // load returns nullptr if the data is truncated.
+    void save(CacheWriter& writer) const;
+    [[nodiscard]] static std::shared_ptr<Mesh> load(CacheReader& reader, const IMaterial* material);
+
+    [[nodiscard]] std::optional<Intersection> intersect(const Ray& ray, const interval& ray_t) const override;
     [[nodiscard]] AABB bounding_box() const override;
+    [[nodiscard]] HitRecord compute_interaction(const Ray& ray, const Intersection& intersection) const override;
+
+    void intersect_packet(const RayPacket& packet, uint32_t active, PacketHitRecord& record) const override;
+    void collect_lights(LightList& lights) const override;
+
+    [[nodiscard]] uint32_t num_faces() const { return static_cast<uint32_t>(m_indices.size()); }
+
+    // Bytes used by the face data, vertex buffer and hierarchy
+    [[nodiscard]] std::size_t memory_size() const;
 
   private:
-    std::vector<Triangle> m_faces;
-    AABB m_bounding_box;
+    // Precomputed intersection data: first vertex of every face and the two edges leaving it
+    template <typename T>
+    struct FaceArrays {
+        std::vector<T> vertex[3];
+        std::vector<T> edge_1[3];
+        std::vector<T> edge_2[3];
+    };
+
+    // Shading attributes of every vertex. Only the full precision or the packed arrays are filled.
+    struct VertexAttributes {
+        std::vector<vec2> uv;
+        std::vector<vec3> normal;
+        std::vector<uint32_t> packed_uv;     // See pack_half2
+        std::vector<uint32_t> packed_normal; // See pack_octahedral
+    };
+
+    WideBVH m_bvh;
+    Description m_description;
+    FaceArrays<real> m_faces;        // Unless float_positions
+    FaceArrays<float> m_float_faces; // With float_positions
+    std::vector<uvec3> m_indices;    // Vertices of every face, in leaf order
+    VertexAttributes m_vertices;
+    const IMaterial* m_material;
+
+    Mesh(WideBVH bvh, const IMaterial* material, Description description);
+
+    // Closest hit among faces [first, first + count) inside (t_min, t_max). Updates closest and returns its distance
+    // when one is found, otherwise returns t_max. Intersection::primitive is the position of the face in leaf order.
+    real intersect_faces(const Ray& ray,
+                         uint32_t first,
+                         uint32_t count,
+                         real t_min,
+                         real t_max,
+                         std::optional<Intersection>& closest) const;
+
+    template <typename T>
+    real intersect_faces(const FaceArrays<T>& arrays,
+                         const Ray& ray,
+                         uint32_t first,
+                         uint32_t count,
+                         real t_min,
+                         real t_max,
+                         std::optional<Intersection>& closest) const;
+
+    [[nodiscard]] vec2 uv(uint32_t vertex) const;
+    [[nodiscard]] vec3 normal(uint32_t vertex) const;
 };
 
+// Model imported with Assimp. The imported meshes are cached on disk, see ModelCache, so only the first load of a
+// file with a given transform pays for the import and the hierarchy builds.
 class Model : public IHittable {
   public:
-    explicit Model(const std::filesystem::path& path);
-    Model(const std::filesystem::path& path, vec3 translation, vec3 scale, vec3 rotation);
+    // Every mesh of the file is shaded with material, owned by the scene like the materials of the other hittables
+    Model(const std::filesystem::path& path, const IMaterial* material);
+    Model(const std::filesystem::path& path, vec3 translation, vec3 scale, vec3 rotation, const IMaterial* material);
 
     ~Model() override = default;
 
-    [[nodiscard]] std::optional<HitRecord> hits(const Ray& ray, const interval& ray_t) const override;
+    [[nodiscard]] std::optional<Intersection> intersect(const Ray& ray, const interval& ray_t) const override;
     [[nodiscard]] AABB bounding_box() const override;
 
+    void intersect_packet(const RayPacket& packet, uint32_t active, PacketHitRecord& record) const override;
+    void collect_lights(LightList& lights) const override;
+
   private:
     std::vector<std::shared_ptr<IHittable>> m_meshes;
     std::unique_ptr<IHittable> m_root;
-
-    void load_mesh(const aiMesh* mesh, const glm::dmat4& transform);
 };
\ No newline at end of file
@@ -0,0 +1,163 @@
+#include "model_cache.h"
+
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "cache_file.h"
+#include "hittable/model.h"
+
+// Cache layout, in native byte order: magic, version, size of real, key, number of meshes, then every mesh as
+// written by Mesh::save. Bump the version whenever the layout of Mesh or WideBVH, or the import itself, changes.
+static constexpr std::array<char, 4> CACHE_MAGIC = {'R', 'T', 'M', 'C'};
+static constexpr uint32_t CACHE_VERSION = 3;
+
+static std::mutex s_directory_mutex;
+static std::optional<std::filesystem::path> s_directory;
+
+static std::filesystem::path default_directory() {
+    if (const auto* directory = std::getenv("RAY_TRACER_CACHE_DIR"); directory != nullptr && *directory != '\0')
+        return directory;
+
+    // Falls back to the working directory if the system has no temporary directory
+    std::error_code error;
+    const auto temporary = std::filesystem::temp_directory_path(error);
+    return error ? std::filesystem::path("ray_tracer_cache") : temporary / "ray_tracer_cache";
+}
+
+// Import transform as doubles, whatever the precision of the build
+static std::array<double, 9> transform_values(const ModelCache::Key& key) {
+    return {key.translation.x, key.translation.y, key.translation.z, key.scale.x, key.scale.y,
+            key.scale.z,       key.rotation.x,    key.rotation.y,    key.rotation.z};
+}
+
+static std::vector<char> source_characters(const ModelCache::Key& key) {
+    const auto source = key.source.string();
+    return {source.begin(), source.end()};
+}
+
+static void write_header(CacheWriter& writer, const ModelCache::Key& key) {
+    writer.write(CACHE_MAGIC);
+    writer.write(CACHE_VERSION);
+    writer.write(static_cast<uint32_t>(sizeof(real)));
+    writer.write(source_characters(key));
+    writer.write(key.modified);
+    writer.write(transform_values(key));
+}
+
+static bool read_header(CacheReader& reader, const ModelCache::Key& key) {
+    std::array<char, 4> magic{};
+    uint32_t version = 0, real_size = 0;
+    std::vector<char> source;
+    int64_t modified = 0;
+    std::array<double, 9> transform{};
+
+    return reader.read(magic) && magic == CACHE_MAGIC && reader.read(version) && version == CACHE_VERSION &&
+           reader.read(real_size) && real_size == sizeof(real) && reader.read(source) &&
+           source == source_characters(key) && reader.read(modified) && modified == key.modified &&
+           reader.read(transform) && transform == transform_values(key);
+}
+
+std::optional<ModelCache::Key> ModelCache::key(const std::filesystem::path& source,
+                                               vec3 translation,
+                                               vec3 scale,
+                                               vec3 rotation) {
+    std::error_code error;
+    const auto absolute = std::filesystem::weakly_canonical(source, error);
+    if (error)
+        return std::nullopt;
+
+    const auto modified = std::filesystem::last_write_time(absolute, error);
+    if (error)
+        return std::nullopt;
+
+    return Key{
+        .source = absolute,
+        .modified = static_cast<int64_t>(modified.time_since_epoch().count()),
+        .translation = translation,
+        .scale = scale,
+        .rotation = rotation,
+    };
+}
+
+std::filesystem::path ModelCache::directory() {
+    const std::lock_guard lock(s_directory_mutex);
+    if (!s_directory)
+        s_directory = default_directory();
+
+    return *s_directory;
+}
+
+void ModelCache::set_directory(std::filesystem::path directory) {
+    const std::lock_guard lock(s_directory_mutex);
+    s_directory = std::move(directory);
+}
+
+std::filesystem::path ModelCache::path(const Key& key) {
+    // FNV-1a of everything that selects a cache, except the modification time: an edited source overwrites the
+    // cache it replaces instead of leaving it behind
+    uint64_t hash = 14695981039346656037ull;
+    const auto mix = [&hash](const void* data, std::size_t size) {
+        for (std::size_t i = 0; i < size; ++i) {
+            hash ^= static_cast<const uint8_t*>(data)[i];
+            hash *= 1099511628211ull;
+        }
+    };
+
+    const auto source = source_characters(key);
+    const auto transform = transform_values(key);
+    const auto real_size = static_cast<uint32_t>(sizeof(real));
+    mix(source.data(), source.size());
+    mix(transform.data(), sizeof(transform));
+    mix(&real_size, sizeof(real_size));
+
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(hash));
+
+    // The source name is kept to tell the caches apart
+    return directory() / (key.source.filename().string() + "." + name + ".rtcache");
+}
+
+std::optional<std::vector<std::shared_ptr<Mesh>>> ModelCache::load(const Key& key, const IMaterial* material) {
+    const auto file = MappedFile::open(path(key));
+    if (!file)
+        return std::nullopt;
+
+    CacheReader reader(file->bytes());
+
+    uint64_t num_meshes = 0;
+    if (!read_header(reader, key) || !reader.read(num_meshes))
+        return std::nullopt;
+
+    std::vector<std::shared_ptr<Mesh>> meshes;
+    for (uint64_t i = 0; i < num_meshes; ++i) {
+        auto mesh = Mesh::load(reader, material);
+        if (!mesh)
+            return std::nullopt;
+
+        meshes.push_back(std::move(mesh));
+    }
+
+    return meshes;
+}
+
+bool ModelCache::save(const Key& key, const std::vector<std::shared_ptr<Mesh>>& meshes) {
+    CacheWriter writer;
+    write_header(writer, key);
+
+    writer.write(static_cast<uint64_t>(meshes.size()));
+    for (const auto& mesh : meshes)
+        mesh->save(writer);
+
+    const auto file = path(key);
+
+    std::error_code error;
+    std::filesystem::create_directories(file.parent_path(), error);
+    if (error)
+        return false;
+
+    return writer.save(file);
+}
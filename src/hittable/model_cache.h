@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "vec.h"
+
+// Forward declarations
+class IMaterial;
+class Mesh;
+
+// On-disk cache of the meshes imported by a Model, storing their transformed face data and hierarchies exactly as
+// laid out in memory. Loading maps the file and copies the arrays in bulk, nothing is parsed or built.
+// The cache is copy-on-load: meshes own their arrays and the mapping is released once they are loaded, so a cached
+// model takes as much memory as an imported one and is not shared between processes through the page cache.
+// A cache is keyed by the source file, its modification time and the import transform. It lives in the cache
+// directory under a name hashed from the path, transform and precision of the build, and its header is checked
+// against the key, so a cache is simply rewritten when the source changes.
+class ModelCache {
+  public:
+    struct Key {
+        std::filesystem::path source; // Absolute
+        int64_t modified;             // Modification time of the source, in file clock ticks
+        vec3 translation, scale, rotation;
+    };
+
+    // std::nullopt if the source does not exist
+    [[nodiscard]] static std::optional<Key> key(const std::filesystem::path& source,
+                                                vec3 translation,
+                                                vec3 scale,
+                                                vec3 rotation);
+
+    // Directory of the caches, created when a cache is saved. Defaults to the RAY_TRACER_CACHE_DIR environment
+    // variable, or to ray_tracer_cache in the temporary directory, so read only model directories still get a cache.
+    [[nodiscard]] static std::filesystem::path directory();
+    static void set_directory(std::filesystem::path directory);
+
+    [[nodiscard]] static std::filesystem::path path(const Key& key);
+
+    // Meshes stored for key, with the given material. std::nullopt if the cache is missing, stale or not valid.
+    [[nodiscard]] static std::optional<std::vector<std::shared_ptr<Mesh>>> load(const Key& key,
+                                                                                 const IMaterial* material);
+
+    // Returns false if the cache could not be written
+    [[nodiscard]] static bool save(const Key& key, const std::vector<std::shared_ptr<Mesh>>& meshes);
+};
@@ -1,47 +1,75 @@
 #include "sphere.h"
 
+#include <algorithm>
+#include <cmath>
+
 #include "material.h"
 #include "interval.h"
+#include "light_list.h"
 
-Sphere::Sphere(vec3 position, double radius, std::shared_ptr<IMaterial> material)
-      : m_position(position), m_radius(radius), m_material(std::move(material)) {
+Sphere::Sphere(vec3 position, real radius, const IMaterial* material)
+      : m_position(position), m_radius(radius), m_material(material) {
     const auto rvec3 = vec3(radius);
     m_bounding_box = AABB(m_position - rvec3, m_position + rvec3);
 }
 
-std::optional<HitRecord> Sphere::hits(const Ray& ray, const interval& ray_t) const {
+std::optional<Intersection> Sphere::intersect(const Ray& ray, const interval& ray_t) const {
     const auto oc = ray.origin() - m_position;
 
     const auto a = glm::dot(ray.direction(), ray.direction());
-    const auto b = 2.0f * glm::dot(ray.direction(), oc);
+    const auto half_b = glm::dot(ray.direction(), oc);
     const auto c = glm::dot(oc, oc) - m_radius * m_radius;
 
-    const auto discriminant = b * b - 4.0f * a * c;
-    if (discriminant < 0.0f)
+    // The discriminant is computed from the distance between the center and the ray line instead of b^2 - 4ac,
+    // which loses all precision in single precision for large or distant spheres (Ray Tracing Gems, chapter 7)
+    const auto closest = oc - (half_b / a) * ray.direction();
+    const auto discriminant = a * (m_radius * m_radius - glm::dot(closest, closest));
+    if (discriminant < 0)
         return {};
 
-    auto root = (-b - glm::sqrt(discriminant)) / (2.0f * a);
+    // Both roots computed without subtracting numbers of similar magnitude
+    const auto q = -(half_b + std::copysign(glm::sqrt(discriminant), half_b));
+    const auto t0 = c / q;
+    const auto t1 = q / a;
+
+    auto root = std::min(t0, t1);
     if (!ray_t.surrounds(root)) {
-        root = (-b + glm::sqrt(discriminant)) / (2.0f * a);
+        root = std::max(t0, t1);
 
         if (!ray_t.surrounds(root)) {
             return {};
         }
     }
 
-    // Compute texture uv
-    const auto uv_point = ray.at(root);
-    const auto uv_direction = glm::normalize(m_position - uv_point);
-
-    const auto longitude = 0.5 + atan2(uv_direction.z, uv_direction.x) / (2.0 * M_PI);
-    const auto latitude = 0.5 + asin(uv_direction.y) / M_PI;
+    return Intersection{.t = root, .u = 0, .v = 0, .primitive = 0, .hittable = this};
+}
 
+HitRecord Sphere::compute_interaction(const Ray& ray, const Intersection& intersection) const {
     HitRecord record{};
-    record.ts = root;
+    record.ts = intersection.t;
     record.point = ray.at(record.ts);
-    record.uv = vec2(longitude, latitude);
     record.material = m_material;
 
+    // Compute texture uv
+    const auto uv_direction = glm::normalize(m_position - record.point);
+    const auto pi = static_cast<real>(M_PI);
+
+    const auto longitude = real(0.5) + std::atan2(uv_direction.z, uv_direction.x) / (2 * pi);
+    const auto latitude = real(0.5) + std::asin(uv_direction.y) / pi;
+    record.uv = vec2(longitude, latitude);
+
+    // 1 / (2 pi r) along the longitude and 1 / (pi r) along the latitude, ignoring the stretching near the poles
+    record.uv_density = 1 / (pi * std::sqrt(real(2))) / std::abs(m_radius);
+
+    // Derivatives of the longitude and latitude above along the sphere, undefined at the poles
+    const auto offset = record.point - m_position;
+    const auto distance_to_axis = std::sqrt(offset.x * offset.x + offset.z * offset.z);
+    if (distance_to_axis > real(1e-6) * std::abs(m_radius)) {
+        const auto n = offset / glm::length(offset);
+        record.u_gradient = vec3(-offset.z, 0.0, offset.x) / (2 * pi * distance_to_axis * distance_to_axis);
+        record.v_gradient = (n.y * n - vec3(0.0, 1.0, 0.0)) / (pi * distance_to_axis);
+    }
+
     const auto outward_normal = (record.point - m_position) / m_radius;
     record.set_front_face(ray, outward_normal);
 
@@ -51,3 +79,8 @@ std::optional<HitRecord> Sphere::hits(const Ray& ray, const interval& ray_t) con
 AABB Sphere::bounding_box() const {
     return m_bounding_box;
 }
+
+void Sphere::collect_lights(LightList& lights) const {
+    if (m_material != nullptr && m_material->is_emissive())
+        lights.add_sphere(this, m_position, m_radius);
+}
@@ -4,15 +4,17 @@
 
 class Sphere : public IHittable {
   public:
-    Sphere(vec3 position, double radius, std::shared_ptr<IMaterial> material);
+    Sphere(vec3 position, real radius, const IMaterial* material);
     ~Sphere() override = default;
 
-    [[nodiscard]] std::optional<HitRecord> hits(const Ray& ray, const interval& ray_t) const override;
+    [[nodiscard]] std::optional<Intersection> intersect(const Ray& ray, const interval& ray_t) const override;
     [[nodiscard]] AABB bounding_box() const override;
+    void collect_lights(LightList& lights) const override;
+    [[nodiscard]] HitRecord compute_interaction(const Ray& ray, const Intersection& intersection) const override;
 
   private:
     vec3 m_position;
-    double m_radius;
-    std::shared_ptr<IMaterial> m_material;
+    real m_radius;
+    const IMaterial* m_material;
     AABB m_bounding_box;
 };
\ No newline at end of file
@@ -1,7 +1,13 @@
 #include "triangle.h"
 
-Triangle::Triangle(Vertex a, Vertex b, Vertex c, std::shared_ptr<IMaterial> material)
-      : m_a(a), m_b(b), m_c(c), m_material(std::move(material)) {
+#include <cmath>
+#include <tuple>
+
+#include "material.h"
+#include "light_list.h"
+
+Triangle::Triangle(Vertex a, Vertex b, Vertex c, const IMaterial* material)
+      : m_a(a), m_b(b), m_c(c), m_edge_1(b.pos - a.pos), m_edge_2(c.pos - a.pos), m_material(material) {
     const auto min = glm::min(glm::min(m_a.pos, m_b.pos), m_c.pos);
     const auto max = glm::max(glm::max(m_a.pos, m_b.pos), m_c.pos);
 
@@ -9,24 +15,22 @@ Triangle::Triangle(Vertex a, Vertex b, Vertex c, std::shared_ptr<IMaterial> mate
     // m_normal = glm::normalize(glm::cross(m_b.pos - m_a.pos, m_c.pos - m_a.pos));
 }
 
-std::optional<HitRecord> Triangle::hits(const Ray& ray, const interval& ray_t) const {
+std::optional<Intersection> Triangle::intersect(const Ray& ray, const interval& ray_t) const {
     // Möller–Trumbore intersection algorithm:
     // https://en.wikipedia.org/wiki/M%C3%B6ller%E2%80%93Trumbore_intersection_algorithm
 
-    constexpr auto epsilon = std::numeric_limits<double>::epsilon();
-
-    const auto edge_1 = m_b.pos - m_a.pos;
-    const auto edge_2 = m_c.pos - m_a.pos;
+    const auto& edge_1 = m_edge_1;
+    const auto& edge_2 = m_edge_2;
 
     const auto ray_cross_e2 = glm::cross(ray.direction(), edge_2);
     const auto det = glm::dot(edge_1, ray_cross_e2);
+    const auto inv_det = real(1) / det;
 
-    if (det > -epsilon && det < epsilon) {
-        // Ray is parallel to triangle
+    // det scales with the area of the triangle, so it is not compared against a fixed epsilon, which would hide
+    // small faces in single precision. Only rays exactly parallel to the triangle are rejected.
+    if (!std::isfinite(inv_det))
         return {};
-    }
 
-    const auto inv_det = 1.0 / det;
     const auto s = ray.origin() - m_a.pos;
     const auto u = inv_det * glm::dot(s, ray_cross_e2);
 
@@ -42,23 +46,32 @@ std::optional<HitRecord> Triangle::hits(const Ray& ray, const interval& ray_t) c
     // Find intersection point in triangle
     const auto t = inv_det * glm::dot(edge_2, s_cross_e1);
 
-    if (t <= epsilon || !ray_t.surrounds(t)) {
-        // Line intersection but not ray intersection, or t is not inside ray_t limits
+    if (!ray_t.surrounds(t)) {
+        // Line intersection outside ray_t, whose minimum keeps rays from hitting the surface they leave
         return {};
     }
 
+    return Intersection{.t = t, .u = u, .v = v, .primitive = 0, .hittable = this};
+}
+
+HitRecord Triangle::compute_interaction(const Ray& ray, const Intersection& intersection) const {
+    const auto u = intersection.u;
+    const auto v = intersection.v;
+    const auto w = real(1) - u - v;
+
     // Compute texture uv
-    const auto w = 1.0 - u - v;
     const auto texture_uv = w * m_a.uv + u * m_b.uv + v * m_c.uv;
 
     // Compute normal
     const auto outward_normal = w * m_a.normal + u * m_b.normal + v * m_c.normal;
 
     HitRecord record{};
-    record.ts = t;
+    record.ts = intersection.t;
     record.point = ray.at(record.ts);
     record.uv = texture_uv;
     record.material = m_material;
+    record.uv_density = uv_density(m_edge_1, m_edge_2, m_b.uv - m_a.uv, m_c.uv - m_a.uv);
+    std::tie(record.u_gradient, record.v_gradient) = uv_gradients(m_edge_1, m_edge_2, m_b.uv - m_a.uv, m_c.uv - m_a.uv);
 
     record.set_front_face(ray, outward_normal);
 
@@ -68,3 +81,33 @@ std::optional<HitRecord> Triangle::hits(const Ray& ray, const interval& ray_t) c
 AABB Triangle::bounding_box() const {
     return m_bounding_box;
 }
+
+void Triangle::collect_lights(LightList& lights) const {
+    if (m_material != nullptr && m_material->is_emissive())
+        lights.add_triangle(this, 0, m_a.pos, m_edge_1, m_edge_2);
+}
+
+real Triangle::uv_density(const vec3& edge_1, const vec3& edge_2, vec2 uv_edge_1, vec2 uv_edge_2) {
+    const auto area = glm::length(glm::cross(edge_1, edge_2));
+    const auto uv_area = std::abs(uv_edge_1.x * uv_edge_2.y - uv_edge_1.y * uv_edge_2.x);
+
+    return area > 0 ? std::sqrt(uv_area / area) : real(0);
+}
+
+std::pair<vec3, vec3> Triangle::uv_gradients(const vec3& edge_1, const vec3& edge_2, vec2 uv_edge_1, vec2 uv_edge_2) {
+    const auto e11 = glm::dot(edge_1, edge_1);
+    const auto e12 = glm::dot(edge_1, edge_2);
+    const auto e22 = glm::dot(edge_2, edge_2);
+    const auto determinant = e11 * e22 - e12 * e12;
+    if (!(determinant > 0))
+        return {vec3(0.0), vec3(0.0)};
+
+    // A gradient in the plane is a e1 + b e2, and its dot products with the edges are the changes along them
+    const auto gradient = [&](real change_1, real change_2) {
+        const auto a = (e22 * change_1 - e12 * change_2) / determinant;
+        const auto b = (e11 * change_2 - e12 * change_1) / determinant;
+        return a * edge_1 + b * edge_2;
+    };
+
+    return {gradient(uv_edge_1.x, uv_edge_2.x), gradient(uv_edge_1.y, uv_edge_2.y)};
+}
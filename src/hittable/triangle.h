@@ -1,5 +1,7 @@
 #pragma once
 
+#include <utility>
+
 #include "hittable/hittable.h"
 
 class Triangle : public IHittable {
@@ -10,14 +12,28 @@ class Triangle : public IHittable {
         vec3 normal{};
     };
 
-    Triangle(Vertex a, Vertex b, Vertex c, std::shared_ptr<IMaterial> material);
+    Triangle(Vertex a, Vertex b, Vertex c, const IMaterial* material);
     ~Triangle() override = default;
 
-    [[nodiscard]] std::optional<HitRecord> hits(const Ray& ray, const interval& ray_t) const override;
+    [[nodiscard]] std::optional<Intersection> intersect(const Ray& ray, const interval& ray_t) const override;
     [[nodiscard]] AABB bounding_box() const override;
+    void collect_lights(LightList& lights) const override;
+    [[nodiscard]] HitRecord compute_interaction(const Ray& ray, const Intersection& intersection) const override;
+
+    // Square root of the ratio between the texture and surface areas of a triangle with the given position and
+    // texture coordinate edges, see HitRecord::uv_density
+    [[nodiscard]] static real uv_density(const vec3& edge_1, const vec3& edge_2, vec2 uv_edge_1, vec2 uv_edge_2);
+
+    // Gradients of u and v in the plane of a triangle with the given position and texture coordinate edges, see
+    // HitRecord::u_gradient. Both are 0 for degenerate triangles.
+    [[nodiscard]] static std::pair<vec3, vec3> uv_gradients(const vec3& edge_1,
+                                                            const vec3& edge_2,
+                                                            vec2 uv_edge_1,
+                                                            vec2 uv_edge_2);
 
   private:
     Vertex m_a, m_b, m_c;
-    std::shared_ptr<IMaterial> m_material;
+    vec3 m_edge_1{}, m_edge_2{}; // Precomputed b - a and c - a
+    const IMaterial* m_material;
     AABB m_bounding_box{};
 };
@@ -0,0 +1,352 @@
+#include "wide_bvh.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define WIDE_BVH_SSE
+#endif
+
+#include "interval.h"
+#include "cache_file.h"
+#include "hittable/hittable_list.h"
+
+WideBVH::WideBVH(const HittableList& list, BVHBuilder::Description description)
+      : WideBVH(list.objects(), description) {}
+
+WideBVH::WideBVH(const std::vector<std::shared_ptr<IHittable>>& objects, BVHBuilder::Description description) {
+    std::vector<AABB> bounds;
+    bounds.reserve(objects.size());
+    for (const auto& object : objects)
+        bounds.push_back(object->bounding_box());
+
+    build(bounds, description);
+
+    m_primitives.reserve(objects.size());
+    for (const auto index : m_primitive_order)
+        m_primitives.push_back(objects[index]);
+}
+
+WideBVH::WideBVH(const std::vector<AABB>& primitive_bounds, BVHBuilder::Description description) {
+    build(primitive_bounds, description);
+}
+
+void WideBVH::save(CacheWriter& writer) const {
+    assert(m_primitives.empty() && "only hierarchies built from primitive bounds can be stored");
+
+    writer.write(m_nodes);
+    writer.write(m_primitive_order);
+    writer.write(m_bounding_box);
+    writer.write(m_report);
+}
+
+std::optional<WideBVH> WideBVH::load(CacheReader& reader) {
+    WideBVH bvh;
+    if (!reader.read(bvh.m_nodes) || !reader.read(bvh.m_primitive_order) || !reader.read(bvh.m_bounding_box) ||
+        !reader.read(bvh.m_report) || !bvh.is_valid())
+        return std::nullopt;
+
+    return bvh;
+}
+
+bool WideBVH::is_valid() const {
+    const auto num_primitives = m_primitive_order.size();
+    if (m_nodes.empty())
+        return num_primitives == 0;
+
+    // Every primitive is stored exactly once
+    std::vector<bool> stored(num_primitives, false);
+    for (const auto index : m_primitive_order) {
+        if (index >= num_primitives || stored[index])
+            return false;
+        stored[index] = true;
+    }
+
+    // Nodes are stored before their children, so a single pass finds the depth of every node, and a node
+    // referenced twice or before its parent would make the hierarchy a graph
+    std::vector<uint32_t> depth(m_nodes.size(), 0);
+    std::vector<bool> referenced(m_nodes.size(), false);
+    referenced[0] = true;
+
+    for (uint32_t index = 0; index < m_nodes.size(); ++index) {
+        if (!referenced[index] || depth[index] >= BVHBuilder::MAX_DEPTH)
+            return false;
+
+        const auto& node = m_nodes[index];
+        for (uint32_t i = 0; i < WIDTH; ++i) {
+            const auto child = node.child[i];
+
+            if (node.num_primitives[i] > 0) {
+                if (child > num_primitives || node.num_primitives[i] > num_primitives - child)
+                    return false;
+            } else if (child == INVALID_CHILD) {
+                // Only inverted bounds keep empty slots from being traversed
+                if (!(node.min_x[i] > node.max_x[i]))
+                    return false;
+            } else {
+                if (child <= index || child >= m_nodes.size() || referenced[child])
+                    return false;
+                referenced[child] = true;
+                depth[child] = depth[index] + 1;
+            }
+        }
+    }
+
+    return true;
+}
+
+void WideBVH::build(const std::vector<AABB>& primitive_bounds, BVHBuilder::Description description) {
+    if (primitive_bounds.empty())
+        return;
+
+    auto result = BVHBuilder(description).build(primitive_bounds);
+    assert(result.report.max_leaf_primitives <= std::numeric_limits<uint16_t>::max());
+
+    m_report = result.report;
+    m_bounding_box = result.nodes.front().bounding_box;
+
+    m_nodes.reserve(result.nodes.size() / 2 + 1);
+    collapse(result, 0);
+
+    m_primitive_order = std::move(result.primitive_indices);
+}
+
+uint32_t WideBVH::collapse(const BVHBuilder::Result& result, uint32_t binary_node) {
+    // Gather up to WIDTH binary nodes, opening the interior node with the largest surface area each time
+    std::vector<uint32_t> slots;
+    if (result.nodes[binary_node].is_leaf()) {
+        slots.push_back(binary_node);
+    } else {
+        slots = {result.nodes[binary_node].left, result.nodes[binary_node].right};
+    }
+
+    while (slots.size() < WIDTH) {
+        auto largest = slots.end();
+        auto largest_area = -1.0;
+
+        for (auto it = slots.begin(); it != slots.end(); ++it) {
+            const auto& node = result.nodes[*it];
+            if (!node.is_leaf() && node.bounding_box.surface_area() > largest_area) {
+                largest = it;
+                largest_area = node.bounding_box.surface_area();
+            }
+        }
+
+        if (largest == slots.end())
+            break;
+
+        const auto opened = *largest;
+        *largest = result.nodes[opened].left;
+        slots.push_back(result.nodes[opened].right);
+    }
+
+    const auto node_index = static_cast<uint32_t>(m_nodes.size());
+    m_nodes.emplace_back();
+
+    constexpr auto infinity = std::numeric_limits<float>::infinity();
+
+    for (uint32_t i = 0; i < WIDTH; ++i) {
+        if (i >= slots.size()) {
+            auto& node = m_nodes[node_index];
+            node.min_x[i] = node.min_y[i] = node.min_z[i] = infinity;
+            node.max_x[i] = node.max_y[i] = node.max_z[i] = -infinity;
+            node.child[i] = INVALID_CHILD;
+            node.num_primitives[i] = 0;
+            continue;
+        }
+
+        const auto& binary = result.nodes[slots[i]];
+
+        uint32_t child;
+        uint16_t num_primitives;
+        if (binary.is_leaf()) {
+            child = binary.first_primitive;
+            num_primitives = static_cast<uint16_t>(binary.num_primitives);
+        } else {
+            child = collapse(result, slots[i]);
+            num_primitives = 0;
+        }
+
+        // Recursion may have reallocated the node list, get the reference afterwards
+        auto& node = m_nodes[node_index];
+        node.child[i] = child;
+        node.num_primitives[i] = num_primitives;
+
+        const auto& bbox = binary.bounding_box;
+        node.min_x[i] = std::nextafter(static_cast<float>(bbox.axis(0).min), -infinity);
+        node.min_y[i] = std::nextafter(static_cast<float>(bbox.axis(1).min), -infinity);
+        node.min_z[i] = std::nextafter(static_cast<float>(bbox.axis(2).min), -infinity);
+        node.max_x[i] = std::nextafter(static_cast<float>(bbox.axis(0).max), infinity);
+        node.max_y[i] = std::nextafter(static_cast<float>(bbox.axis(1).max), infinity);
+        node.max_z[i] = std::nextafter(static_cast<float>(bbox.axis(2).max), infinity);
+    }
+
+    return node_index;
+}
+
+uint32_t WideBVH::intersect_node(const Node& node, const NodeRay& ray, float t_min, float t_max, float t_near[WIDTH]) {
+    // Near and far planes depend on the sign of the direction
+    const float* near_x = ray.direction_negative[0] ? node.max_x : node.min_x;
+    const float* far_x = ray.direction_negative[0] ? node.min_x : node.max_x;
+    const float* near_y = ray.direction_negative[1] ? node.max_y : node.min_y;
+    const float* far_y = ray.direction_negative[1] ? node.min_y : node.max_y;
+    const float* near_z = ray.direction_negative[2] ? node.max_z : node.min_z;
+    const float* far_z = ray.direction_negative[2] ? node.min_z : node.max_z;
+
+#ifdef WIDE_BVH_SSE
+    const auto origin_x = _mm_set1_ps(ray.origin[0]);
+    const auto origin_y = _mm_set1_ps(ray.origin[1]);
+    const auto origin_z = _mm_set1_ps(ray.origin[2]);
+    const auto inv_direction_x = _mm_set1_ps(ray.inv_direction[0]);
+    const auto inv_direction_y = _mm_set1_ps(ray.inv_direction[1]);
+    const auto inv_direction_z = _mm_set1_ps(ray.inv_direction[2]);
+
+    // _mm_max_ps / _mm_min_ps return the second operand when the first one is NaN, so the running
+    // interval is always passed second to ignore 0 * inf from rays parallel to a slab
+    auto entry = _mm_set1_ps(t_min);
+    auto exit = _mm_set1_ps(t_max);
+
+    entry = _mm_max_ps(_mm_mul_ps(_mm_sub_ps(_mm_load_ps(near_x), origin_x), inv_direction_x), entry);
+    entry = _mm_max_ps(_mm_mul_ps(_mm_sub_ps(_mm_load_ps(near_y), origin_y), inv_direction_y), entry);
+    entry = _mm_max_ps(_mm_mul_ps(_mm_sub_ps(_mm_load_ps(near_z), origin_z), inv_direction_z), entry);
+
+    exit = _mm_min_ps(_mm_mul_ps(_mm_sub_ps(_mm_load_ps(far_x), origin_x), inv_direction_x), exit);
+    exit = _mm_min_ps(_mm_mul_ps(_mm_sub_ps(_mm_load_ps(far_y), origin_y), inv_direction_y), exit);
+    exit = _mm_min_ps(_mm_mul_ps(_mm_sub_ps(_mm_load_ps(far_z), origin_z), inv_direction_z), exit);
+
+    _mm_storeu_ps(t_near, entry);
+    return static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(entry, exit)));
+#else
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < WIDTH; ++i) {
+        auto entry = t_min;
+        auto exit = t_max;
+
+        const float near[3] = {near_x[i], near_y[i], near_z[i]};
+        const float far[3] = {far_x[i], far_y[i], far_z[i]};
+
+        for (uint32_t a = 0; a < 3; ++a) {
+            const auto t0 = (near[a] - ray.origin[a]) * ray.inv_direction[a];
+            const auto t1 = (far[a] - ray.origin[a]) * ray.inv_direction[a];
+            entry = t0 > entry ? t0 : entry;
+            exit = t1 < exit ? t1 : exit;
+        }
+
+        t_near[i] = entry;
+        mask |= (entry <= exit ? 1u : 0u) << i;
+    }
+    return mask;
+#endif
+}
+
+std::optional<Intersection> WideBVH::intersect(const Ray& ray, const interval& ray_t) const {
+    std::optional<Intersection> record;
+
+    traverse(ray, ray_t, [&](uint32_t first, uint32_t count, real t_max) {
+        for (uint32_t i = first; i < first + count; ++i) {
+            const auto r = m_primitives[i]->intersect(ray, interval(ray_t.min, t_max));
+            if (r.has_value()) {
+                record = r;
+                t_max = record->t;
+            }
+        }
+        return t_max;
+    });
+
+    return record;
+}
+
+uint32_t WideBVH::intersect_child_packet(const Node& node,
+                                         uint32_t child,
+                                         const RayPacket& packet,
+                                         uint32_t active,
+                                         float t_min,
+                                         const float t_max[RayPacket::MAX_SIZE],
+                                         float& t_near) {
+    static_assert(RayPacket::MAX_SIZE % 4 == 0);
+
+    const float box_min[3] = {node.min_x[child], node.min_y[child], node.min_z[child]};
+    const float box_max[3] = {node.max_x[child], node.max_y[child], node.max_z[child]};
+
+    uint32_t mask = 0;
+    t_near = std::numeric_limits<float>::infinity();
+
+    // Lanes are processed in groups of four, one ray per SIMD lane
+    for (uint32_t base = 0; base < packet.size; base += 4) {
+        const auto group_active = (active >> base) & 0xfu;
+        if (group_active == 0)
+            continue;
+
+#ifdef WIDE_BVH_SSE
+        auto entry = _mm_set1_ps(t_min);
+        auto exit = _mm_loadu_ps(&t_max[base]);
+
+        for (uint32_t a = 0; a < 3; ++a) {
+            const auto origin = _mm_load_ps(&packet.origin[a][base]);
+            const auto inv_direction = _mm_load_ps(&packet.inv_direction[a][base]);
+
+            const auto t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box_min[a]), origin), inv_direction);
+            const auto t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box_max[a]), origin), inv_direction);
+
+            // Running interval passed second, so NaNs from 0 * inf are ignored
+            entry = _mm_max_ps(_mm_min_ps(t0, t1), entry);
+            exit = _mm_min_ps(_mm_max_ps(t0, t1), exit);
+        }
+
+        const auto group_mask = static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(entry, exit))) & group_active;
+
+        alignas(16) float entries[4];
+        _mm_store_ps(entries, entry);
+#else
+        uint32_t group_mask = 0;
+        float entries[4];
+
+        for (uint32_t i = 0; i < 4; ++i) {
+            const auto lane = base + i;
+            auto entry_lane = t_min;
+            auto exit_lane = t_max[lane];
+
+            for (uint32_t a = 0; a < 3; ++a) {
+                const auto t0 = (box_min[a] - packet.origin[a][lane]) * packet.inv_direction[a][lane];
+                const auto t1 = (box_max[a] - packet.origin[a][lane]) * packet.inv_direction[a][lane];
+                entry_lane = std::max(std::min(t0, t1), entry_lane);
+                exit_lane = std::min(std::max(t0, t1), exit_lane);
+            }
+
+            entries[i] = entry_lane;
+            group_mask |= (entry_lane <= exit_lane ? 1u : 0u) << i;
+        }
+        group_mask &= group_active;
+#endif
+
+        for (uint32_t i = 0; i < 4; ++i) {
+            if ((group_mask >> i) & 1u)
+                t_near = std::min(t_near, entries[i]);
+        }
+
+        mask |= group_mask << base;
+    }
+
+    return mask;
+}
+
+void WideBVH::intersect_packet(const RayPacket& packet, uint32_t active, PacketHitRecord& record) const {
+    traverse_packet(packet, active, record.t_min, record.t_max, [&](uint32_t first, uint32_t count, uint32_t lanes) {
+        for (uint32_t i = first; i < first + count; ++i)
+            m_primitives[i]->intersect_packet(packet, lanes, record);
+    });
+}
+
+AABB WideBVH::bounding_box() const {
+    return m_bounding_box;
+}
+
+void WideBVH::collect_lights(LightList& lights) const {
+    for (const auto& primitive : m_primitives)
+        primitive->collect_lights(lights);
+}
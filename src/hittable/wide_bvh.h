@@ -0,0 +1,297 @@
+#pragma once
+
+#include <bit>
+#include <cassert>
+#include <limits>
+#include <optional>
+#include <vector>
+
+#include "interval.h"
+#include "hittable/hittable.h"
+#include "hittable/bvh_builder.h"
+
+// Forward declarations
+class HittableList;
+class CacheWriter;
+class CacheReader;
+
+// 4-wide BVH obtained by collapsing a binary BVH. Every node stores the bounds of its children in SoA
+// layout, so a single SIMD slab test checks the ray against all four children at once.
+class WideBVH : public IHittable {
+  public:
+    static constexpr uint32_t WIDTH = 4;
+    static constexpr uint32_t INVALID_CHILD = ~0u;
+
+    struct alignas(64) Node {
+        float min_x[WIDTH], min_y[WIDTH], min_z[WIDTH];
+        float max_x[WIDTH], max_y[WIDTH], max_z[WIDTH];
+
+        // Interior children (num_primitives == 0): index of the child node
+        // Leaf children: index of the first primitive
+        // Empty slots: INVALID_CHILD, with inverted (empty) bounds so they are never hit
+        uint32_t child[WIDTH];
+        uint16_t num_primitives[WIDTH];
+    };
+    static_assert(sizeof(Node) == 128);
+
+    explicit WideBVH(const HittableList& list, BVHBuilder::Description description = {});
+    explicit WideBVH(const std::vector<std::shared_ptr<IHittable>>& objects, BVHBuilder::Description description = {});
+
+    // Builds only the hierarchy, for owners that store and intersect their primitives themselves through
+    // traverse(). Leaves reference primitives in primitive_order(), not in the order of primitive_bounds.
+    explicit WideBVH(const std::vector<AABB>& primitive_bounds, BVHBuilder::Description description = {});
+    WideBVH(WideBVH&&) noexcept = default;
+    WideBVH& operator=(WideBVH&&) noexcept = default;
+    ~WideBVH() override = default;
+
+    // Stores a hierarchy built from primitive bounds, and restores it without building it again. load returns
+    // std::nullopt if the data is truncated or does not describe a valid hierarchy.
+    void save(CacheWriter& writer) const;
+    [[nodiscard]] static std::optional<WideBVH> load(CacheReader& reader);
+
+    [[nodiscard]] std::optional<Intersection> intersect(const Ray& ray, const interval& ray_t) const override;
+    [[nodiscard]] AABB bounding_box() const override;
+    void collect_lights(LightList& lights) const override;
+
+    void intersect_packet(const RayPacket& packet, uint32_t active, PacketHitRecord& record) const override;
+
+    [[nodiscard]] const BVHBuilder::Report& report() const { return m_report; }
+    [[nodiscard]] const std::vector<Node>& nodes() const { return m_nodes; }
+
+    // primitive_order()[i] is the index of the primitive stored at position i in leaf order
+    [[nodiscard]] const std::vector<uint32_t>& primitive_order() const { return m_primitive_order; }
+
+    // Visits the leaves hit by the ray, nearest first. intersect_leaf(first, count, t_max) tests the primitives
+    // [first, first + count) of the leaf and returns the distance of the closest hit so far (t_max if none).
+    template <typename IntersectLeaf>
+    void traverse(const Ray& ray, const interval& ray_t, IntersectLeaf&& intersect_leaf) const;
+
+    // Visits the leaves hit by any active lane of the packet. intersect_leaf(first, count, active) tests the
+    // primitives of the leaf for the given lanes and shrinks t_max of the lanes that hit something.
+    template <typename IntersectLeaf>
+    void traverse_packet(const RayPacket& packet,
+                         uint32_t active,
+                         real t_min,
+                         const real t_max[RayPacket::MAX_SIZE],
+                         IntersectLeaf&& intersect_leaf) const;
+
+    // Precomputed single precision ray used by the node test
+    struct NodeRay {
+        float origin[3];
+        float inv_direction[3];
+        bool direction_negative[3];
+    };
+
+    // Returns a bitmask with the children of node hit by the ray inside [t_min, t_max],
+    // and writes the entry distance of every child into t_near
+    [[nodiscard]] static uint32_t intersect_node(const Node& node,
+                                                 const NodeRay& ray,
+                                                 float t_min,
+                                                 float t_max,
+                                                 float t_near[WIDTH]);
+
+    // Returns a bitmask with the active lanes of the packet that hit child of node inside [t_min, t_max[lane]],
+    // and writes the smallest entry distance of those lanes into t_near
+    [[nodiscard]] static uint32_t intersect_child_packet(const Node& node,
+                                                         uint32_t child,
+                                                         const RayPacket& packet,
+                                                         uint32_t active,
+                                                         float t_min,
+                                                         const float t_max[RayPacket::MAX_SIZE],
+                                                         float& t_near);
+
+  private:
+    WideBVH() = default;
+
+    std::vector<Node> m_nodes;
+    std::vector<std::shared_ptr<IHittable>> m_primitives; // Ordered so that every leaf references a contiguous range
+    std::vector<uint32_t> m_primitive_order;
+
+    AABB m_bounding_box;
+    BVHBuilder::Report m_report{};
+
+    void build(const std::vector<AABB>& primitive_bounds, BVHBuilder::Description description);
+    uint32_t collapse(const BVHBuilder::Result& result, uint32_t binary_node);
+
+    // Whether the nodes form a tree traversable within the stack capacity, with leaves inside the primitive order
+    // and the primitive order a permutation of the primitives. Loaded data is checked before it is trusted.
+    [[nodiscard]] bool is_valid() const;
+
+    // Every level adds at most WIDTH - 1 entries to the stack
+    static constexpr uint32_t STACK_CAPACITY = (WIDTH - 1) * BVHBuilder::MAX_DEPTH + 1;
+
+    // Node tests run in single precision, the interval is widened slightly to account for the rounding of the ray
+    static constexpr float WIDEN = 4.0f * std::numeric_limits<float>::epsilon();
+    [[nodiscard]] static float widen_near(real t) { return static_cast<float>(t) * (1.0f - WIDEN); }
+    [[nodiscard]] static float widen_far(real t) { return static_cast<float>(t) * (1.0f + WIDEN); }
+};
+
+template <typename IntersectLeaf>
+void WideBVH::traverse(const Ray& ray, const interval& ray_t, IntersectLeaf&& intersect_leaf) const {
+    if (m_nodes.empty())
+        return;
+
+    const auto direction = ray.direction();
+
+    NodeRay node_ray{};
+    for (int32_t a = 0; a < 3; ++a) {
+        node_ray.origin[a] = static_cast<float>(ray.origin()[a]);
+        node_ray.inv_direction[a] = static_cast<float>(1.0 / direction[a]);
+        node_ray.direction_negative[a] = node_ray.inv_direction[a] < 0.0f;
+    }
+
+    const auto t_min = widen_near(ray_t.min);
+
+    struct StackEntry {
+        uint32_t child;
+        uint32_t num_primitives;
+        float t_near;
+    };
+
+    StackEntry stack[STACK_CAPACITY];
+    uint32_t stack_size = 0;
+
+    stack[stack_size++] = {.child = 0, .num_primitives = 0, .t_near = t_min};
+
+    auto closest_max_t = ray_t.max;
+
+    while (stack_size > 0) {
+        const auto entry = stack[--stack_size];
+        if (entry.t_near > widen_far(closest_max_t))
+            continue;
+
+        if (entry.num_primitives > 0) {
+            closest_max_t = intersect_leaf(entry.child, entry.num_primitives, closest_max_t);
+            continue;
+        }
+
+        const auto& node = m_nodes[entry.child];
+
+        alignas(16) float t_near[WIDTH];
+        auto mask = intersect_node(node, node_ray, t_min, widen_far(closest_max_t), t_near);
+
+        // Push the hit children from farthest to nearest, so the nearest one is popped first
+        uint32_t order[WIDTH];
+        uint32_t num_hit = 0;
+        while (mask != 0) {
+            const auto i = static_cast<uint32_t>(std::countr_zero(mask));
+            mask &= mask - 1;
+
+            auto position = num_hit++;
+            while (position > 0 && t_near[order[position - 1]] < t_near[i]) {
+                order[position] = order[position - 1];
+                position--;
+            }
+            order[position] = i;
+        }
+
+        assert(stack_size + num_hit <= STACK_CAPACITY);
+        for (uint32_t k = 0; k < num_hit; ++k) {
+            const auto i = order[k];
+            stack[stack_size++] = {
+                .child = node.child[i],
+                .num_primitives = node.num_primitives[i],
+                .t_near = t_near[i],
+            };
+        }
+    }
+}
+
+template <typename IntersectLeaf>
+void WideBVH::traverse_packet(const RayPacket& packet,
+                              uint32_t active,
+                              real t_min,
+                              const real t_max[RayPacket::MAX_SIZE],
+                              IntersectLeaf&& intersect_leaf) const {
+    if (m_nodes.empty() || active == 0)
+        return;
+
+    const auto node_t_min = widen_near(t_min);
+
+    alignas(16) float node_t_max[RayPacket::MAX_SIZE];
+    const auto update_t_max = [&]() {
+        for (uint32_t lane = 0; lane < packet.size; ++lane)
+            node_t_max[lane] = widen_far(t_max[lane]);
+    };
+    update_t_max();
+
+    struct StackEntry {
+        uint32_t child;
+        uint32_t num_primitives;
+        uint32_t active;
+        float t_near; // Smallest entry distance of the active lanes
+    };
+
+    StackEntry stack[STACK_CAPACITY];
+    uint32_t stack_size = 0;
+
+    stack[stack_size++] = {.child = 0, .num_primitives = 0, .active = active, .t_near = node_t_min};
+
+    while (stack_size > 0) {
+        const auto entry = stack[--stack_size];
+
+        // Drop the lanes that found a hit closer than the entry since it was pushed, and keep track of the
+        // farthest remaining lane for the packet wide culling test
+        auto entry_active = 0u;
+        auto packet_t_max = node_t_min;
+        for (auto lanes = entry.active; lanes != 0; lanes &= lanes - 1) {
+            const auto lane = static_cast<uint32_t>(std::countr_zero(lanes));
+            if (node_t_max[lane] >= entry.t_near) {
+                entry_active |= 1u << lane;
+                packet_t_max = std::max(packet_t_max, node_t_max[lane]);
+            }
+        }
+
+        if (entry_active == 0)
+            continue;
+
+        if (entry.num_primitives > 0) {
+            intersect_leaf(entry.child, entry.num_primitives, entry_active);
+            update_t_max();
+            continue;
+        }
+
+        const auto& node = m_nodes[entry.child];
+
+        // With only a few lanes left the per-lane test is cheaper than the packet wide one
+        const auto cull_packet = std::popcount(entry_active) > 4;
+
+        uint32_t order[WIDTH];
+        float t_near[WIDTH];
+        uint32_t masks[WIDTH];
+        uint32_t num_hit = 0;
+
+        for (uint32_t i = 0; i < WIDTH; ++i) {
+            if (node.child[i] == INVALID_CHILD)
+                continue;
+
+            const float box_min[3] = {node.min_x[i], node.min_y[i], node.min_z[i]};
+            const float box_max[3] = {node.max_x[i], node.max_y[i], node.max_z[i]};
+            if (cull_packet && !packet.may_hit(box_min, box_max, node_t_min, packet_t_max))
+                continue;
+
+            masks[i] = intersect_child_packet(node, i, packet, entry_active, node_t_min, node_t_max, t_near[i]);
+            if (masks[i] == 0)
+                continue;
+
+            // Keep hit children sorted from farthest to nearest
+            auto position = num_hit++;
+            while (position > 0 && t_near[order[position - 1]] < t_near[i]) {
+                order[position] = order[position - 1];
+                position--;
+            }
+            order[position] = i;
+        }
+
+        assert(stack_size + num_hit <= STACK_CAPACITY);
+        for (uint32_t k = 0; k < num_hit; ++k) {
+            const auto i = order[k];
+            stack[stack_size++] = {
+                .child = node.child[i],
+                .num_primitives = node.num_primitives[i],
+                .active = masks[i],
+                .t_near = t_near[i],
+            };
+        }
+    }
+}
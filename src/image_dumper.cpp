@@ -1,43 +1,115 @@
 #include "image_dumper.h"
 
+#include <algorithm>
+#include <bit>
+#include <charconv>
 #include <fstream>
+#include <new>
+#include <string>
+#include <vector>
 
-#include "interval.h"
+// Encoding of the pixels with transfer, clamped to 8 bits. Every pixel is independent, so they are split between
+// threads.
+static std::vector<uint8_t> quantize(std::span<const IImageDumper::Pixel> pixels, IImageDumper::Transfer transfer) {
+    std::vector<uint8_t> bytes(pixels.size() * 3);
 
-PPMImageDumper::PPMImageDumper(uint32_t width, uint32_t height) : m_width(width), m_height(height) {
-    m_data = {m_height, std::vector<vec3>(m_width, vec3(0.0))};
+    #pragma omp parallel for schedule(static)
+    for (std::size_t i = 0; i < pixels.size(); ++i) {
+        for (int channel = 0; channel < 3; ++channel) {
+            // Written so that NaN is clamped to 0 as well, converting it to an integer is undefined
+            auto value = pixels[i][channel] > 0.0f ? pixels[i][channel] : 0.0f;
+            if (transfer == IImageDumper::Transfer::Gamma)
+                value = glm::sqrt(value);
+
+            bytes[3 * i + static_cast<std::size_t>(channel)] = static_cast<uint8_t>(std::min(value, 0.999f) * 256.0f);
+        }
+    }
+
+    return bytes;
+}
+
+// Writes the header and then the data in a single call
+static void write_file(const std::filesystem::path& path,
+                       const std::string& header,
+                       const void* data,
+                       std::size_t size) {
+    std::ofstream file(path, std::ios::binary);
+    file.write(header.data(), static_cast<std::streamsize>(header.size()));
+    file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+}
+
+IImageDumper::IImageDumper(uint32_t width, uint32_t height) : m_width(width), m_height(height) {
+    // Pixel is trivially copyable, the raw allocation only needs its values set
+    auto* pixels = static_cast<Pixel*>(::operator new[](size() * sizeof(Pixel), std::align_val_t(ALIGNMENT)));
+    std::uninitialized_fill_n(pixels, size(), Pixel(0.0f));
+    m_pixels.reset(pixels);
+}
+
+void IImageDumper::AlignedDelete::operator()(Pixel* pixels) const {
+    ::operator delete[](pixels, std::align_val_t(ALIGNMENT));
 }
 
-std::vector<vec3>& PPMImageDumper::operator[](std::size_t row) {
-    assert(row < m_height);
-    return m_data[row];
+IImageDumper::View<IImageDumper::Pixel> IImageDumper::view(uint32_t row,
+                                                         uint32_t col,
+                                                         uint32_t height,
+                                                         uint32_t width) {
+    assert(row + height <= m_height && col + width <= m_width);
+    return {m_pixels.get() + row * stride() + col, width, height, stride()};
 }
 
-const std::vector<vec3>& PPMImageDumper::operator[](std::size_t row) const {
-    assert(row < m_height);
-    return m_data[row];
+IImageDumper::View<const IImageDumper::Pixel> IImageDumper::view(uint32_t row,
+                                                               uint32_t col,
+                                                               uint32_t height,
+                                                               uint32_t width) const {
+    assert(row + height <= m_height && col + width <= m_width);
+    return {m_pixels.get() + row * stride() + col, width, height, stride()};
 }
 
+PPMImageDumper::PPMImageDumper(uint32_t width, uint32_t height, Transfer transfer)
+      : IImageDumper(width, height), m_transfer(transfer) {}
+
 void PPMImageDumper::dump(const std::filesystem::path& path) const {
-    std::ofstream file(path);
+    const auto bytes = quantize(pixels(), m_transfer);
 
-    file << "P3\n" << m_width << " " << m_height << "\n255\n";
+    // At most "255 255 255\n" per pixel
+    std::string text(bytes.size() * 4, '\0');
+    auto* cursor = text.data();
 
-    constexpr interval intensity(0.0, 0.999);
+    for (std::size_t i = 0; i < bytes.size(); ++i) {
+        cursor = std::to_chars(cursor, text.data() + text.size(), bytes[i]).ptr;
+        *cursor++ = i % 3 == 2 ? '\n' : ' ';
+    }
 
-    for (std::size_t row = 0; row < m_height; ++row) {
-        for (std::size_t col = 0; col < m_width; ++col) {
-            const auto& color = m_data[row][col];
+    const auto header = "P3\n" + std::to_string(width()) + " " + std::to_string(height()) + "\n255\n";
+    write_file(path, header, text.data(), static_cast<std::size_t>(cursor - text.data()));
+}
 
-            const auto r = color.r;
-            const auto g = color.g;
-            const auto b = color.b;
+P6ImageDumper::P6ImageDumper(uint32_t width, uint32_t height, Transfer transfer)
+      : IImageDumper(width, height), m_transfer(transfer) {}
 
-            file << static_cast<int>(intensity.clamp(r) * 256.0) << " ";
-            file << static_cast<int>(intensity.clamp(g) * 256.0) << " ";
-            file << static_cast<int>(intensity.clamp(b) * 256.0) << "\n";
-        }
+void P6ImageDumper::dump(const std::filesystem::path& path) const {
+    const auto bytes = quantize(pixels(), m_transfer);
+
+    const auto header = "P6\n" + std::to_string(width()) + " " + std::to_string(height()) + "\n255\n";
+    write_file(path, header, bytes.data(), bytes.size());
+}
+
+PFMImageDumper::PFMImageDumper(uint32_t width, uint32_t height) : IImageDumper(width, height) {}
+
+void PFMImageDumper::dump(const std::filesystem::path& path) const {
+    // Rows are stored from the bottom of the image to the top
+    std::vector<Pixel> flipped(pixels().size());
+
+    #pragma omp parallel for schedule(static)
+    for (uint32_t row = 0; row < height(); ++row) {
+        const auto source = pixels().subspan(row * stride(), width());
+        std::copy(source.begin(), source.end(), flipped.begin() + (height() - 1 - row) * stride());
     }
 
-    file.close();
+    // The sign of the scale gives the byte order of the floats
+    const auto scale = std::endian::native == std::endian::little ? "-1.0" : "1.0";
+    const auto header = "PF\n" + std::to_string(width()) + " " + std::to_string(height()) + "\n" + scale + "\n";
+
+    static_assert(sizeof(Pixel) == 3 * sizeof(float), "PFM pixels are three packed floats");
+    write_file(path, header, flipped.data(), flipped.size() * sizeof(Pixel));
 }
@@ -1,38 +1,120 @@
 #pragma once
 
+#include <cassert>
 #include <cstdint>
 #include <filesystem>
-#include <vector>
+#include <memory>
+#include <span>
 
 #include "vec.h"
 
+// Framebuffer of linear RGB radiance, stored row after row in a single cache line aligned allocation. Pixels are
+// written without virtual calls, only dump depends on the image format. 8 bit formats encode the pixels with their
+// transfer function and clamp them when dumping, HDR formats keep them as they are.
 class IImageDumper {
   public:
+    // Single precision whatever the precision of the build, half the memory of a double vec3
+    using Pixel = glm::vec3;
+
+    // Encoding of the pixels in 8 bit formats
+    enum class Transfer {
+        Gamma,  // Gamma 2, for radiance
+        Linear, // Proportional to the pixel value, for data such as sample counts
+    };
+
+    static constexpr std::size_t ALIGNMENT = 64;
+
+    // Rectangle of pixels of the image, e.g. a tile, addressed from its top left corner. Rows are stride pixels
+    // apart in memory.
+    template <typename T>
+    class View {
+      public:
+        View(T* first, uint32_t width, uint32_t height, std::size_t stride)
+              : m_first(first), m_width(width), m_height(height), m_stride(stride) {}
+
+        [[nodiscard]] uint32_t width() const { return m_width; }
+        [[nodiscard]] uint32_t height() const { return m_height; }
+        [[nodiscard]] std::size_t stride() const { return m_stride; }
+
+        [[nodiscard]] T& operator()(std::size_t row, std::size_t col) const {
+            assert(row < m_height && col < m_width);
+            return m_first[row * m_stride + col];
+        }
+
+        [[nodiscard]] std::span<T> row(std::size_t row) const {
+            assert(row < m_height);
+            return {m_first + row * m_stride, m_width};
+        }
+
+      private:
+        T* m_first;
+        uint32_t m_width, m_height;
+        std::size_t m_stride;
+    };
+
+    IImageDumper(uint32_t width, uint32_t height);
     virtual ~IImageDumper() = default;
 
-    [[nodiscard]] virtual uint32_t width() const = 0;
-    [[nodiscard]] virtual uint32_t height() const = 0;
+    [[nodiscard]] uint32_t width() const { return m_width; }
+    [[nodiscard]] uint32_t height() const { return m_height; }
+    [[nodiscard]] std::size_t stride() const { return m_width; }
+
+    void set_pixel(std::size_t row, std::size_t col, const vec3& color) { m_pixels[index(row, col)] = Pixel(color); }
+    [[nodiscard]] vec3 pixel(std::size_t row, std::size_t col) const { return vec3(m_pixels[index(row, col)]); }
 
-    [[nodiscard]] virtual std::vector<vec3>& operator[](std::size_t row) = 0;
-    [[nodiscard]] virtual const std::vector<vec3>& operator[](std::size_t row) const = 0;
+    [[nodiscard]] std::span<Pixel> pixels() { return {m_pixels.get(), size()}; }
+    [[nodiscard]] std::span<const Pixel> pixels() const { return {m_pixels.get(), size()}; }
+
+    [[nodiscard]] View<Pixel> view(uint32_t row, uint32_t col, uint32_t height, uint32_t width);
+    [[nodiscard]] View<const Pixel> view(uint32_t row, uint32_t col, uint32_t height, uint32_t width) const;
 
     virtual void dump(const std::filesystem::path& path) const = 0;
+
+  private:
+    struct AlignedDelete {
+        void operator()(Pixel* pixels) const;
+    };
+
+    uint32_t m_width, m_height;
+    std::unique_ptr<Pixel[], AlignedDelete> m_pixels;
+
+    [[nodiscard]] std::size_t size() const { return static_cast<std::size_t>(m_width) * m_height; }
+
+    [[nodiscard]] std::size_t index(std::size_t row, std::size_t col) const {
+        assert(row < m_height && col < m_width);
+        return row * stride() + col;
+    }
 };
 
+// ASCII PPM (P3)
 class PPMImageDumper : public IImageDumper {
   public:
-    PPMImageDumper(uint32_t width, uint32_t height);
+    PPMImageDumper(uint32_t width, uint32_t height, Transfer transfer = Transfer::Gamma);
     ~PPMImageDumper() override = default;
 
-    [[nodiscard]] uint32_t width() const override { return m_width; }
-    [[nodiscard]] uint32_t height() const override { return m_height; }
+    void dump(const std::filesystem::path& path) const override;
 
-    [[nodiscard]] std::vector<vec3>& operator[](std::size_t row) override;
-    [[nodiscard]] const std::vector<vec3>& operator[](std::size_t row) const override;
+  private:
+    Transfer m_transfer;
+};
+
+// Binary PPM (P6), a third of the size of P3 and written in a single block
+class P6ImageDumper : public IImageDumper {
+  public:
+    P6ImageDumper(uint32_t width, uint32_t height, Transfer transfer = Transfer::Gamma);
+    ~P6ImageDumper() override = default;
 
     void dump(const std::filesystem::path& path) const override;
 
   private:
-    std::vector<std::vector<vec3>> m_data;
-    uint32_t m_width, m_height;
-};
\ No newline at end of file
+    Transfer m_transfer;
+};
+
+// Portable float map (PF), linear 32 bit floats in native byte order, without clamping
+class PFMImageDumper : public IImageDumper {
+  public:
+    PFMImageDumper(uint32_t width, uint32_t height);
+    ~PFMImageDumper() override = default;
+
+    void dump(const std::filesystem::path& path) const override;
+};
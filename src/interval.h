@@ -3,27 +3,30 @@
 #include <limits>
 #include <cmath>
 
+#include "vec.h"
+
 class interval {
   public:
-    double min;
-    double max;
+    real min;
+    real max;
 
-    static constexpr double infinity = std::numeric_limits<double>::infinity();
+    static constexpr real infinity = std::numeric_limits<real>::infinity();
 
     constexpr interval() : min(-infinity), max(infinity) {}
-    constexpr interval(double min_, double max_) : min(min_), max(max_) {}
-    constexpr interval(const interval& a, const interval& b) : min(fmin(a.min, b.min)), max(fmax(a.max, b.max)) {}
+    constexpr interval(real min_, real max_) : min(min_), max(max_) {}
+    constexpr interval(const interval& a, const interval& b)
+        : min(std::fmin(a.min, b.min)), max(std::fmax(a.max, b.max)) {}
 
-    [[nodiscard]] inline bool contains(double x) const { return min <= x && x <= max; }
+    [[nodiscard]] inline bool contains(real x) const { return min <= x && x <= max; }
 
-    [[nodiscard]] inline bool surrounds(double x) const { return min < x && x < max; }
+    [[nodiscard]] inline bool surrounds(real x) const { return min < x && x < max; }
 
-    [[nodiscard]] interval expand(double delta) {
-        const auto padding = delta / 2.0;
+    [[nodiscard]] interval expand(real delta) {
+        const auto padding = delta / real(2);
         return {min - padding, max + padding};
     }
 
-    [[nodiscard]] inline double clamp(double x) const {
+    [[nodiscard]] inline real clamp(real x) const {
         if (x < min)
             return min;
         if (x > max)
@@ -0,0 +1,203 @@
+#include "light_list.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "onb.h"
+#include "sampler.h"
+#include "interval.h"
+#include "material.h"
+#include "hittable/hittable.h"
+
+// Power heuristic with exponent 2, weight of the strategy with density pdf against the other one
+static real power_heuristic(real pdf, real other_pdf) {
+    const auto pdf2 = pdf * pdf;
+    const auto other_pdf2 = other_pdf * other_pdf;
+    return pdf2 + other_pdf2 > 0 ? pdf2 / (pdf2 + other_pdf2) : real(0);
+}
+
+// 1 - cos(theta_max) of the cone subtended by a sphere, written without cancellation for small or distant spheres
+static real cone_extent(real radius, real distance_squared) {
+    const auto sin2_theta_max = radius * radius / distance_squared;
+    const auto cos_theta_max = glm::sqrt(std::max(real(1) - sin2_theta_max, real(0)));
+    return sin2_theta_max / (real(1) + cos_theta_max);
+}
+
+LightList::LightList(const IHittable& scene) {
+    scene.collect_lights(*this);
+}
+
+void LightList::add_sphere(const IHittable* hittable, vec3 center, real radius) {
+    add({
+        .shape = Shape::Sphere,
+        .hittable = hittable,
+        .primitive = 0,
+        .position = center,
+        .radius = radius,
+        .edge_1 = vec3(0.0),
+        .edge_2 = vec3(0.0),
+        .normal = vec3(0.0),
+        .area = real(4) * glm::pi<real>() * radius * radius,
+    });
+}
+
+void LightList::add_triangle(const IHittable* hittable, uint32_t primitive, vec3 vertex, vec3 edge_1, vec3 edge_2) {
+    const auto cross = glm::cross(edge_1, edge_2);
+    const auto double_area = glm::length(cross);
+
+    // Degenerate triangles never receive shadow rays, but keep the indices of the hittable consecutive
+    add({
+        .shape = Shape::Triangle,
+        .hittable = hittable,
+        .primitive = primitive,
+        .position = vertex,
+        .radius = 0,
+        .edge_1 = edge_1,
+        .edge_2 = edge_2,
+        .normal = double_area > 0 ? cross / double_area : vec3(0.0),
+        .area = real(0.5) * double_area,
+    });
+}
+
+void LightList::add(const Light& light) {
+    [[maybe_unused]] const auto first = m_first_light.try_emplace(light.hittable, size()).first;
+    assert(first->second + light.primitive == size() && "Primitives of a hittable must be added in order");
+
+    m_lights.push_back(light);
+}
+
+std::optional<LightList::Connection> LightList::connect(const Ray& ray,
+                                                        const HitRecord& record,
+                                                        Sampler& sampler) const {
+    if (m_lights.empty())
+        return {};
+
+    const auto index = std::min(static_cast<uint32_t>(sampler.next_real() * static_cast<real>(size())), size() - 1);
+    const auto& light = m_lights[index];
+
+    const auto light_sample = sample(light, record.point, sampler);
+    if (!light_sample)
+        return {};
+
+    const auto evaluation = record.material->evaluate(ray, record, light_sample->direction);
+    if (!evaluation || evaluation->pdf <= 0)
+        return {};
+
+    const auto light_pdf = light_sample->pdf / static_cast<real>(size());
+    const auto weight = power_heuristic(light_pdf, evaluation->pdf);
+
+    return Connection{
+        .shadow_ray = Ray(record.point, light_sample->direction),
+        .light = index,
+        .weight = evaluation->value * (weight / light_pdf),
+    };
+}
+
+vec3 LightList::connection_radiance(const Connection& connection, const IHittable& scene) const {
+    const auto& ray = connection.shadow_ray;
+
+    const auto intersection = scene.intersect(ray, interval(RAY_T_MIN, interval::infinity));
+    if (!intersection || find(*intersection) != &m_lights[connection.light])
+        return vec3(0.0);
+
+    const auto record = scene.compute_interaction(ray, *intersection);
+    const auto emission = record.material->emitted(record.uv.x, record.uv.y);
+
+    return emission ? connection.weight * *emission : vec3(0.0);
+}
+
+real LightList::emission_weight(const vec3& point,
+                                real scatter_pdf,
+                                const Intersection& intersection,
+                                const HitRecord& record) const {
+    const auto light = find(intersection);
+    if (light == nullptr)
+        return 1;
+
+    const auto light_pdf = pdf(*light, point, record.point) / static_cast<real>(size());
+    return power_heuristic(scatter_pdf, light_pdf);
+}
+
+std::optional<LightList::LightSample> LightList::sample(const Light& light,
+                                                        const vec3& point,
+                                                        Sampler& sampler) {
+    const auto u1 = sampler.next_real();
+    const auto u2 = sampler.next_real();
+
+    if (light.shape == Shape::Sphere) {
+        const auto to_center = light.position - point;
+        const auto distance_squared = glm::dot(to_center, to_center);
+
+        // Points inside the sphere are not lit from outside
+        if (distance_squared <= light.radius * light.radius)
+            return {};
+
+        // Uniform direction inside the cone subtended by the sphere
+        const auto extent = cone_extent(light.radius, distance_squared);
+        const auto cos_theta = real(1) - u1 * extent;
+        const auto sin_theta = glm::sqrt(std::max(real(1) - cos_theta * cos_theta, real(0)));
+        const auto phi = real(2) * glm::pi<real>() * u2;
+
+        ONB uvw{};
+        uvw.build_from_w(to_center);
+
+        return LightSample{
+            .direction = glm::normalize(uvw.local(glm::cos(phi) * sin_theta, glm::sin(phi) * sin_theta, cos_theta)),
+            .pdf = real(1) / (real(2) * glm::pi<real>() * extent),
+        };
+    }
+
+    if (light.area <= 0)
+        return {};
+
+    // Uniform point on the triangle
+    const auto su1 = glm::sqrt(u1);
+    const auto b1 = real(1) - su1;
+    const auto b2 = u2 * su1;
+    const auto light_point = light.position + b1 * light.edge_1 + b2 * light.edge_2;
+
+    const auto light_pdf = pdf(light, point, light_point);
+    if (light_pdf <= 0)
+        return {};
+
+    return LightSample{
+        .direction = glm::normalize(light_point - point),
+        .pdf = light_pdf,
+    };
+}
+
+real LightList::pdf(const Light& light, const vec3& point, const vec3& light_point) {
+    if (light.shape == Shape::Sphere) {
+        const auto to_center = light.position - point;
+        const auto distance_squared = glm::dot(to_center, to_center);
+        if (distance_squared <= light.radius * light.radius)
+            return 0;
+
+        return real(1) / (real(2) * glm::pi<real>() * cone_extent(light.radius, distance_squared));
+    }
+
+    // Area density converted to solid angle, emission is two sided
+    const auto to_light = light_point - point;
+    const auto distance_squared = glm::dot(to_light, to_light);
+    const auto cosine = glm::abs(glm::dot(light.normal, to_light)) / glm::sqrt(distance_squared);
+    if (light.area <= 0 || cosine <= 0)
+        return 0;
+
+    return distance_squared / (cosine * light.area);
+}
+
+const LightList::Light* LightList::find(const Intersection& intersection) const {
+    // Lights are stored in world space, the primitives of an instance are not among them
+    if (intersection.instance != nullptr)
+        return nullptr;
+
+    const auto first = m_first_light.find(intersection.hittable);
+    if (first == m_first_light.end())
+        return nullptr;
+
+    const auto index = first->second + intersection.primitive;
+    if (index >= size() || m_lights[index].hittable != intersection.hittable)
+        return nullptr;
+
+    return &m_lights[index];
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "vec.h"
+#include "ray.h"
+
+// Forward declarations
+class IHittable;
+class Sampler;
+struct HitRecord;
+struct Intersection;
+
+// Emissive primitives of a scene, sampled for next event estimation. At every non specular path vertex a light is
+// chosen uniformly and a direction towards it is sampled (spheres by the solid angle they subtend, triangles by
+// area). The shadow ray and the BSDF sampled ray are combined by multiple importance sampling with the power
+// heuristic, so both strategies can be used together without counting the emission twice.
+class LightList {
+  public:
+    // Shadow ray from a shading point towards a light. If the first thing it hits is that light, the radiance
+    // reaching the path is weight times the emission at the hit point.
+    struct Connection {
+        Ray shadow_ray;
+        uint32_t light;
+        vec3 weight; // Path throughput not included
+    };
+
+    // Empty list, which disables next event estimation
+    LightList() = default;
+
+    // Collects the lights of scene, see IHittable::collect_lights
+    explicit LightList(const IHittable& scene);
+
+    // Primitives of the same hittable must be added consecutively and in increasing primitive order
+    void add_sphere(const IHittable* hittable, vec3 center, real radius);
+    void add_triangle(const IHittable* hittable, uint32_t primitive, vec3 vertex, vec3 edge_1, vec3 edge_2);
+
+    [[nodiscard]] bool empty() const { return m_lights.empty(); }
+    [[nodiscard]] uint32_t size() const { return static_cast<uint32_t>(m_lights.size()); }
+
+    // Samples a light for the shading point of record. Returns std::nullopt for specular materials, or when the
+    // sampled direction cannot receive light.
+    [[nodiscard]] std::optional<Connection> connect(const Ray& ray, const HitRecord& record, Sampler& sampler) const;
+
+    // Radiance brought by a connection, zero if the shadow ray is blocked
+    [[nodiscard]] vec3 connection_radiance(const Connection& connection, const IHittable& scene) const;
+
+    // Weight of the emission found by a ray sampled with scatter_pdf from point, against the probability that
+    // connect would have sampled the same direction
+    [[nodiscard]] real emission_weight(const vec3& point,
+                                       real scatter_pdf,
+                                       const Intersection& intersection,
+                                       const HitRecord& record) const;
+
+  private:
+    enum class Shape {
+        Sphere,
+        Triangle,
+    };
+
+    struct Light {
+        Shape shape;
+        const IHittable* hittable;
+        uint32_t primitive;
+
+        vec3 position; // Center of spheres, first vertex of triangles
+        real radius;
+        vec3 edge_1, edge_2;
+        vec3 normal;
+        real area;
+    };
+
+    std::vector<Light> m_lights;
+    std::unordered_map<const IHittable*, uint32_t> m_first_light;
+
+    struct LightSample {
+        vec3 direction; // Unit vector
+        real pdf;       // Solid angle density, not including the choice of the light
+    };
+
+    [[nodiscard]] static std::optional<LightSample> sample(const Light& light, const vec3& point, Sampler& sampler);
+    [[nodiscard]] static real pdf(const Light& light, const vec3& point, const vec3& light_point);
+
+    [[nodiscard]] const Light* find(const Intersection& intersection) const;
+
+    void add(const Light& light);
+};
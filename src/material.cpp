@@ -1,10 +1,43 @@
 #include "material.h"
 
-#include "rand.h"
+#include <algorithm>
+#include <cmath>
+
+#include "sampler.h"
 #include "texture.h"
 #include "onb.h"
 #include "hittable/hittable.h"
 
+// Cone of rays scattered at the hit, it keeps the spread of the incoming ray from the width it reached
+static RayCone scattered_cone(const Ray& ray, const HitRecord& record) {
+    return {.width = ray.footprint(record.ts), .spread = ray.cone().spread};
+}
+
+// Footprint of the incoming cone on the surface, in texture coordinates. Grazing rays stretch it by 1 / cos along
+// their direction on the surface, clamped so that it does not blur the whole texture. Without texture coordinate
+// gradients only its size is known, and it is treated as round.
+static Texture::Footprint texture_footprint(const Ray& ray, const HitRecord& record) {
+    const auto direction = glm::normalize(ray.direction());
+    const auto cosine = std::abs(glm::dot(direction, record.normal));
+    const auto width = ray.footprint(record.ts);
+    const auto stretched_width = width / std::max(cosine, real(0.1));
+
+    const auto along = direction - glm::dot(direction, record.normal) * record.normal;
+    const auto along_length = glm::length(along);
+    const auto has_gradients = record.u_gradient != vec3(0.0) || record.v_gradient != vec3(0.0);
+    if (!has_gradients || !(along_length > 0))
+        return {.width = stretched_width * record.uv_density};
+
+    const auto to_texture = [&record](const vec3& extent) {
+        return vec2(glm::dot(record.u_gradient, extent), glm::dot(record.v_gradient, extent));
+    };
+
+    const auto major = along * (stretched_width / along_length);
+    const auto minor = glm::cross(record.normal, along) * (width / along_length);
+
+    return {.width = glm::length(to_texture(minor)), .major_axis = to_texture(major)};
+}
+
 //
 // Lambertian
 //
@@ -13,36 +46,59 @@ Lambertian::Lambertian(vec3 albedo) : m_albedo(albedo) {}
 
 Lambertian::Lambertian(std::shared_ptr<Texture> texture) : m_texture(std::move(texture)) {}
 
-std::optional<MaterialHit> Lambertian::scatter([[maybe_unused]] const Ray& ray, const HitRecord& record) const {
+std::optional<MaterialHit> Lambertian::scatter(const Ray& ray,
+                                               const HitRecord& record,
+                                               Sampler& sampler) const {
     ONB uvw{};
     uvw.build_from_w(record.normal);
 
-    const auto scatter_direction = uvw.local(random_cosine_direction());
+    const auto scatter_direction = uvw.local(random_cosine_direction(sampler));
 
     return MaterialHit{
-        .scatter = Ray(record.point, scatter_direction),
-        .attenuation = m_texture != nullptr ? m_texture->sample(record.uv.x, record.uv.y) : m_albedo,
-        .pdf = glm::dot(record.normal, scatter_direction) / glm::pi<double>(),
+        .scatter = Ray(record.point, scatter_direction, scattered_cone(ray, record)),
+        .attenuation = albedo(ray, record),
+        .pdf = glm::dot(record.normal, scatter_direction) / glm::pi<real>(),
     };
 }
 
-double Lambertian::scattering_prob([[maybe_unused]] const Ray& incoming,
+real Lambertian::scattering_prob([[maybe_unused]] const Ray& incoming,
                                   const HitRecord& record,
                                   const Ray& outgoing) const {
     const auto cosine = glm::dot(record.normal, outgoing.direction());
-    return cosine < 0.0 ? 0.0 : cosine / glm::pi<double>();
+    return cosine < 0.0 ? real(0) : cosine / glm::pi<real>();
+}
+
+std::optional<MaterialEval> Lambertian::evaluate(const Ray& incoming,
+                                                 const HitRecord& record,
+                                                 const vec3& direction) const {
+    const auto cosine = glm::dot(record.normal, direction);
+    if (cosine <= 0.0)
+        return MaterialEval{.value = vec3(0.0), .pdf = 0.0};
+
+    return MaterialEval{
+        .value = albedo(incoming, record) * (cosine / glm::pi<real>()),
+        .pdf = cosine / glm::pi<real>(),
+    };
+}
+
+vec3 Lambertian::albedo(const Ray& ray, const HitRecord& record) const {
+    if (m_texture == nullptr)
+        return m_albedo;
+
+    return m_texture->sample(record.uv.x, record.uv.y, texture_footprint(ray, record));
 }
 
 //
 // Metal
 //
 
-Metal::Metal(vec3 albedo, double fuzz) : m_albedo(albedo), m_fuzz(std::min(fuzz, 1.0)) {}
+Metal::Metal(vec3 albedo, real fuzz) : m_albedo(albedo), m_fuzz(std::min(fuzz, real(1))) {}
 
-std::optional<MaterialHit> Metal::scatter(const Ray& ray, const HitRecord& record) const {
+std::optional<MaterialHit> Metal::scatter(const Ray& ray, const HitRecord& record, Sampler& sampler) const {
     const auto reflected = glm::reflect(glm::normalize(ray.direction()), record.normal);
 
-    const auto reflected_ray = Ray(record.point, reflected + m_fuzz * vec3_random_unit());
+    const auto reflected_ray =
+        Ray(record.point, reflected + m_fuzz * vec3_random_unit(sampler), scattered_cone(ray, record));
     const auto material_hit = MaterialHit{
         .scatter = reflected_ray,
         .attenuation = m_albedo,
@@ -52,7 +108,7 @@ std::optional<MaterialHit> Metal::scatter(const Ray& ray, const HitRecord& recor
     return glm::dot(reflected_ray.direction(), record.normal) > 0.0 ? material_hit : std::optional<MaterialHit>{};
 }
 
-double Metal::scattering_prob([[maybe_unused]] const Ray& incoming, const HitRecord& record, const Ray& outgoing) const {
+real Metal::scattering_prob([[maybe_unused]] const Ray& incoming, const HitRecord& record, const Ray& outgoing) const {
     // Just make sure the outgoing ray is in the same hemisphere as the normal
     return glm::dot(record.normal, outgoing.direction()) < 0.0 ? 0.0 : 1.0;
 }
@@ -61,40 +117,40 @@ double Metal::scattering_prob([[maybe_unused]] const Ray& incoming, const HitRec
 // Dielectric
 //
 
-Dielectric::Dielectric(double refraction_index) : m_refraction_index(refraction_index) {}
+Dielectric::Dielectric(real refraction_index) : m_refraction_index(refraction_index) {}
 
-std::optional<MaterialHit> Dielectric::scatter(const Ray& ray, const HitRecord& record) const {
-    const double refraction_ratio = record.front_face ? 1.0 / m_refraction_index : m_refraction_index;
+std::optional<MaterialHit> Dielectric::scatter(const Ray& ray, const HitRecord& record, Sampler& sampler) const {
+    const real refraction_ratio = record.front_face ? real(1) / m_refraction_index : m_refraction_index;
 
     // const auto refracted = vec3_refract(glm::normalize(ray.direction()), record.normal, refraction_ratio);
 
     const auto direction_normalized = glm::normalize(ray.direction());
 
-    const double cos_theta = fmin(glm::dot(-direction_normalized, record.normal), 1.0);
-    const double sin_theta = glm::sqrt(1.0 - cos_theta * cos_theta);
+    const real cos_theta = std::fmin(glm::dot(-direction_normalized, record.normal), real(1));
+    const real sin_theta = glm::sqrt(real(1) - cos_theta * cos_theta);
 
     const bool cannot_refract = refraction_ratio * sin_theta > 1.0;
 
     vec3 scatter_direction;
-    if (cannot_refract || reflectance(cos_theta, refraction_ratio) > random_double())
+    if (cannot_refract || reflectance(cos_theta, refraction_ratio) > sampler.next_real())
         scatter_direction = glm::reflect(direction_normalized, record.normal);
     else
         scatter_direction = glm::refract(direction_normalized, record.normal, refraction_ratio);
 
     return MaterialHit{
-        .scatter = Ray(record.point, scatter_direction),
+        .scatter = Ray(record.point, scatter_direction, scattered_cone(ray, record)),
         .attenuation = vec3(1.0),
         .pdf = 1.0,
     };
 }
 
-double Dielectric::scattering_prob([[maybe_unused]] const Ray& incoming,
+real Dielectric::scattering_prob([[maybe_unused]] const Ray& incoming,
                                   [[maybe_unused]] const HitRecord& record,
                                   [[maybe_unused]] const Ray& outgoing) const {
     return 1.0;
 }
 
-double Dielectric::reflectance(double cosine, double ref_idx) {
+real Dielectric::reflectance(real cosine, real ref_idx) {
     // Use Schlick's approximation for reflectance.
     auto r0 = (1 - ref_idx) / (1 + ref_idx);
     r0 = r0 * r0;
@@ -105,18 +161,19 @@ double Dielectric::reflectance(double cosine, double ref_idx) {
 // DiffuseEmissive
 //
 
-DiffuseEmissive::DiffuseEmissive(vec3 emission_color, double intensity) : m_color(emission_color * intensity) {}
+DiffuseEmissive::DiffuseEmissive(vec3 emission_color, real intensity) : m_color(emission_color * intensity) {}
 
 std::optional<MaterialHit> DiffuseEmissive::scatter([[maybe_unused]] const Ray& ray,
-                                                    [[maybe_unused]] const HitRecord& record) const {
+                                                    [[maybe_unused]] const HitRecord& record,
+                                                    [[maybe_unused]] Sampler& sampler) const {
     return {};
 }
 
-std::optional<vec3> DiffuseEmissive::emitted([[maybe_unused]] double u, [[maybe_unused]] double v) const {
+std::optional<vec3> DiffuseEmissive::emitted([[maybe_unused]] real u, [[maybe_unused]] real v) const {
     return m_color;
 }
 
-double DiffuseEmissive::scattering_prob([[maybe_unused]] const Ray& incoming,
+real DiffuseEmissive::scattering_prob([[maybe_unused]] const Ray& incoming,
                                        [[maybe_unused]] const HitRecord& record,
                                        [[maybe_unused]] const Ray& outgoing) const {
     return 0.0;
@@ -8,25 +8,43 @@
 
 // Forward declarations
 struct HitRecord;
+class Sampler;
 
 struct MaterialHit {
     Ray scatter;
     vec3 attenuation;
-    double pdf;
+    real pdf;
+};
+
+// Material response for a given pair of directions
+struct MaterialEval {
+    vec3 value; // BSDF times the cosine with the normal, i.e. attenuation * scattering_prob for scattered rays
+    real pdf;   // Solid angle density with which scatter samples the direction
 };
 
 class IMaterial {
   public:
     virtual ~IMaterial() = default;
 
-    [[nodiscard]] virtual std::optional<MaterialHit> scatter(const Ray& ray, const HitRecord& record) const = 0;
-    [[nodiscard]] virtual std::optional<vec3> emitted([[maybe_unused]] double u, [[maybe_unused]] double v) const {
+    [[nodiscard]] virtual std::optional<MaterialHit> scatter(const Ray& ray,
+                                                             const HitRecord& record,
+                                                             Sampler& sampler) const = 0;
+    [[nodiscard]] virtual std::optional<vec3> emitted([[maybe_unused]] real u, [[maybe_unused]] real v) const {
         return {};
     }
+    [[nodiscard]] virtual bool is_emissive() const { return false; }
 
-    [[nodiscard]] virtual double scattering_prob(const Ray& incoming,
+    [[nodiscard]] virtual real scattering_prob(const Ray& incoming,
                                                 const HitRecord& record,
                                                 const Ray& outgoing) const = 0;
+
+    // Evaluates the material towards a unit direction chosen by someone else, e.g. a light sample. Specular
+    // materials can only scatter in the directions they sample, they return std::nullopt.
+    [[nodiscard]] virtual std::optional<MaterialEval> evaluate([[maybe_unused]] const Ray& incoming,
+                                                               [[maybe_unused]] const HitRecord& record,
+                                                               [[maybe_unused]] const vec3& direction) const {
+        return {};
+    }
 };
 
 class Lambertian : public IMaterial {
@@ -35,55 +53,70 @@ class Lambertian : public IMaterial {
     explicit Lambertian(std::shared_ptr<Texture> texture);
     ~Lambertian() override = default;
 
-    [[nodiscard]] std::optional<MaterialHit> scatter(const Ray& ray, const HitRecord& record) const override;
-    [[nodiscard]] double scattering_prob(const Ray& incoming,
+    [[nodiscard]] std::optional<MaterialHit> scatter(const Ray& ray,
+                                                     const HitRecord& record,
+                                                     Sampler& sampler) const override;
+    [[nodiscard]] real scattering_prob(const Ray& incoming,
                                         const HitRecord& record,
                                         const Ray& outgoing) const override;
+    [[nodiscard]] std::optional<MaterialEval> evaluate(const Ray& incoming,
+                                                       const HitRecord& record,
+                                                       const vec3& direction) const override;
 
   private:
     vec3 m_albedo{};
     std::shared_ptr<Texture> m_texture = nullptr;
+
+    // Texture filtered over the footprint of the ray, or the constant albedo
+    [[nodiscard]] vec3 albedo(const Ray& ray, const HitRecord& record) const;
 };
 
 class Metal : public IMaterial {
   public:
-    explicit Metal(vec3 albedo, double fuzz);
+    explicit Metal(vec3 albedo, real fuzz);
     ~Metal() override = default;
 
-    [[nodiscard]] std::optional<MaterialHit> scatter(const Ray& ray, const HitRecord& record) const override;
-    [[nodiscard]] double scattering_prob(const Ray& incoming,
+    [[nodiscard]] std::optional<MaterialHit> scatter(const Ray& ray,
+                                                     const HitRecord& record,
+                                                     Sampler& sampler) const override;
+    [[nodiscard]] real scattering_prob(const Ray& incoming,
                                         const HitRecord& record,
                                         const Ray& outgoing) const override;
 
   private:
     vec3 m_albedo;
-    double m_fuzz;
+    real m_fuzz;
 };
 
 class Dielectric : public IMaterial {
   public:
-    explicit Dielectric(double refraction_index);
+    explicit Dielectric(real refraction_index);
     ~Dielectric() override = default;
 
-    [[nodiscard]] std::optional<MaterialHit> scatter(const Ray& ray, const HitRecord& record) const override;
-    [[nodiscard]] double scattering_prob(const Ray& incoming,
+    [[nodiscard]] std::optional<MaterialHit> scatter(const Ray& ray,
+                                                     const HitRecord& record,
+                                                     Sampler& sampler) const override;
+    [[nodiscard]] real scattering_prob(const Ray& incoming,
                                         const HitRecord& record,
                                         const Ray& outgoing) const override;
 
   private:
-    double m_refraction_index;
+    real m_refraction_index;
 
-    [[nodiscard]] static double reflectance(double cosine, double ref_idx);
+    [[nodiscard]] static real reflectance(real cosine, real ref_idx);
 };
 
 class DiffuseEmissive : public IMaterial {
   public:
-    explicit DiffuseEmissive(vec3 emission_color, double intensity);
+    explicit DiffuseEmissive(vec3 emission_color, real intensity);
 
-    [[nodiscard]] std::optional<MaterialHit> scatter(const Ray& ray, const HitRecord& record) const override;
-    [[nodiscard]] std::optional<vec3> emitted(double u, double v) const override;
+    [[nodiscard]] std::optional<MaterialHit> scatter(const Ray& ray,
+                                                     const HitRecord& record,
+                                                     Sampler& sampler) const override;
+    [[nodiscard]] std::optional<vec3> emitted(real u, real v) const override;
+    [[nodiscard]] bool is_emissive() const override { return true; }
 
-    [[nodiscard]] double scattering_prob(const Ray& incoming,
+    [[nodiscard]] real scattering_prob(const Ray& incoming,
                                         const HitRecord& record,
                                         const Ray& outgoing) const override;
 
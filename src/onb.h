@@ -13,7 +13,7 @@ class ONB {
     [[nodiscard]] vec3 v() const { return axis[1]; }
     [[nodiscard]] vec3 w() const { return axis[2]; }
 
-    [[nodiscard]] vec3 local(double a, double b, double c) const { return a * u() + b * v() + c * w(); }
+    [[nodiscard]] vec3 local(real a, real b, real c) const { return a * u() + b * v() + c * w(); }
 
     [[nodiscard]] vec3 local(const vec3& a) const { return a.x * u() + a.y * v() + a.z * w(); }
 
@@ -1,8 +0,0 @@
-#pragma once
-
-#include <cstdint>
-
-double random_double();
-double random_double(double min, double max);
-
-int32_t random_int(int32_t min, int32_t max);
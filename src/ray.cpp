@@ -2,6 +2,13 @@
 
 Ray::Ray(vec3 origin, vec3 direction) : m_origin(origin), m_direction(direction) {}
 
-vec3 Ray::at(double ts) const {
+Ray::Ray(vec3 origin, vec3 direction, RayCone cone) : m_origin(origin), m_direction(direction), m_cone(cone) {}
+
+vec3 Ray::at(real ts) const {
     return m_origin + m_direction * ts;
 }
+
+real Ray::footprint(real ts) const {
+    // The direction is not normalized, ts is not a distance
+    return m_cone.width + m_cone.spread * ts * glm::length(m_direction);
+}
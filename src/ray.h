@@ -2,15 +2,34 @@
 
 #include "vec.h"
 
+// Hits closer than this to the origin of a ray are ignored, so that scattered rays do not hit again the
+// surface they start from. It must stay well above the rounding error of hit points, which in single
+// precision is around 1e-7 times the distance to the world origin.
+constexpr real RAY_T_MIN = real(0.001);
+
+// Cone around a ray covering the footprint of the pixel it was traced for, a cheap isotropic form of ray
+// differentials used to pick the mip level of textures. Rays without a cone have a zero footprint.
+struct RayCone {
+    real width = 0;  // Width at the origin of the ray
+    real spread = 0; // Angle the width grows by per unit of distance, in radians
+};
+
 class Ray {
   public:
+    Ray() = default;
     Ray(vec3 origin, vec3 direction);
+    Ray(vec3 origin, vec3 direction, RayCone cone);
 
-    [[nodiscard]] vec3 at(double ts) const;
+    [[nodiscard]] vec3 at(real ts) const;
 
     [[nodiscard]] vec3 origin() const { return m_origin; }
     [[nodiscard]] vec3 direction() const { return m_direction; }
+    [[nodiscard]] RayCone cone() const { return m_cone; }
+
+    // Width of the cone at at(ts)
+    [[nodiscard]] real footprint(real ts) const;
 
   private:
-    vec3 m_origin, m_direction;
+    vec3 m_origin{}, m_direction{};
+    RayCone m_cone{};
 };
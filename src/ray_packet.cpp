@@ -0,0 +1,71 @@
+#include "ray_packet.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+void RayPacket::add(const Ray& ray) {
+    assert(size < MAX_SIZE);
+
+    const auto lane = size++;
+    rays[lane] = ray;
+
+    for (int32_t a = 0; a < 3; ++a) {
+        origin[a][lane] = static_cast<float>(ray.origin()[a]);
+        inv_direction[a][lane] = static_cast<float>(1.0 / ray.direction()[a]);
+    }
+}
+
+void RayPacket::compute_bounds() {
+    has_bounds = size > 0;
+
+    for (uint32_t a = 0; a < 3 && has_bounds; ++a) {
+        const auto inv_begin = inv_direction[a];
+        const auto inv_end = inv_direction[a] + size;
+
+        const auto [inv_min, inv_max] = std::minmax_element(inv_begin, inv_end);
+        const auto [o_min, o_max] = std::minmax_element(origin[a], origin[a] + size);
+
+        // Interval arithmetic is only meaningful if the sign of the direction is shared and finite
+        const auto same_sign = (*inv_min > 0.0f) == (*inv_max > 0.0f);
+        has_bounds = same_sign && std::isfinite(*inv_min) && std::isfinite(*inv_max);
+
+        inv_direction_min[a] = *inv_min;
+        inv_direction_max[a] = *inv_max;
+        origin_min[a] = *o_min;
+        origin_max[a] = *o_max;
+    }
+}
+
+bool RayPacket::may_hit(const float box_min[3], const float box_max[3], float t_min, float t_max) const {
+    if (!has_bounds)
+        return true;
+
+    auto entry = t_min;
+    auto exit = t_max;
+
+    for (uint32_t a = 0; a < 3; ++a) {
+        const auto positive = inv_direction_min[a] > 0.0f;
+        const auto near = positive ? box_min[a] : box_max[a];
+        const auto far = positive ? box_max[a] : box_min[a];
+
+        // Product of intervals [plane - origin_max, plane - origin_min] * [inv_min, inv_max]
+        const auto near_a = (near - origin_max[a]) * inv_direction_min[a];
+        const auto near_b = (near - origin_max[a]) * inv_direction_max[a];
+        const auto near_c = (near - origin_min[a]) * inv_direction_min[a];
+        const auto near_d = (near - origin_min[a]) * inv_direction_max[a];
+
+        const auto far_a = (far - origin_max[a]) * inv_direction_min[a];
+        const auto far_b = (far - origin_max[a]) * inv_direction_max[a];
+        const auto far_c = (far - origin_min[a]) * inv_direction_min[a];
+        const auto far_d = (far - origin_min[a]) * inv_direction_max[a];
+
+        entry = std::max(entry, std::min(std::min(near_a, near_b), std::min(near_c, near_d)));
+        exit = std::min(exit, std::max(std::max(far_a, far_b), std::max(far_c, far_d)));
+
+        if (exit < entry)
+            return false;
+    }
+
+    return true;
+}
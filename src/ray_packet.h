@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+
+#include "ray.h"
+
+// Group of coherent rays (e.g. camera rays of neighbouring pixels) traced together through the scene.
+// Besides the rays themselves, it stores single precision SoA copies used by the SIMD box tests and
+// conservative bounds of the whole packet, used to cull boxes for all rays at once.
+struct RayPacket {
+    static constexpr uint32_t MAX_SIZE = 16;
+
+    uint32_t size = 0;
+    Ray rays[MAX_SIZE];
+
+    alignas(64) float origin[3][MAX_SIZE]{};
+    alignas(64) float inv_direction[3][MAX_SIZE]{};
+
+    // Interval bounds of the origins and inverse directions of all rays. Only valid when every axis has
+    // the same direction sign in all rays (always the case for small camera packets).
+    bool has_bounds = false;
+    float origin_min[3]{}, origin_max[3]{};
+    float inv_direction_min[3]{}, inv_direction_max[3]{};
+
+    void add(const Ray& ray);
+    void compute_bounds();
+
+    [[nodiscard]] uint32_t all_lanes() const { return (1u << size) - 1u; }
+
+    // Conservative test of the whole packet against a box, false only if no ray can hit it in [t_min, t_max]
+    [[nodiscard]] bool may_hit(const float box_min[3], const float box_max[3], float t_min, float t_max) const;
+};
@@ -1,62 +1,208 @@
 #include "ray_tracer.h"
 
+#include <algorithm>
+#include <atomic>
+#include <bit>
 #include <cassert>
+#include <numeric>
 #include <iostream>
 #include <chrono>
+#include <string>
+#include <vector>
 #include <omp.h>
 
+#include "accumulation_buffer.h"
+#include "adaptive_sampling.h"
 #include "camera.h"
 #include "image_dumper.h"
 #include "ray.h"
-#include "rand.h"
+#include "ray_packet.h"
+#include "sampler.h"
+#include "wavefront.h"
 #include "interval.h"
 #include "material.h"
+#include "light_list.h"
 #include "hittable/hittable.h"
 
-RayTracer::RayTracer(Description description) : m_desc(description) {
+RayTracer::RayTracer(Description description)
+      : m_desc(description), m_russian_roulette(description.russian_roulette_depth) {
     if (m_desc.num_threads == 0)
         m_desc.num_threads = 1;
 
     m_desc.num_threads = std::min(m_desc.num_threads, max_num_threads());
-    m_desc.percentage_update_progress = interval(0.01, 1.0).clamp(m_desc.percentage_update_progress);
+    m_desc.percentage_update_progress = std::clamp(m_desc.percentage_update_progress, 0.01, 1.0);
+
+    // Packets must be a power of two so they can be laid out as a rectangle of pixels
+    m_desc.packet_size = std::bit_floor(std::clamp(m_desc.packet_size, 1u, RayPacket::MAX_SIZE));
 }
 
 uint32_t RayTracer::max_num_threads() {
     return static_cast<uint32_t>(omp_get_max_threads());
 }
 
-void RayTracer::render(const Camera& camera, const IHittable& scene, IImageDumper& image) const {
+void RayTracer::render(const Camera& camera,
+                       const IHittable& scene,
+                       IImageDumper& image,
+                       IImageDumper* sample_counts) const {
     assert(camera.width() == image.width() && camera.height() == image.height());
+    assert(!sample_counts || (sample_counts->width() == image.width() && sample_counts->height() == image.height()));
 
-    const auto scale = 1.0 / m_desc.samples_per_pixel;
-    const auto& [delta_u, delta_v] = camera.deltas();
-    const auto& pixel00_loc = camera.pixel00_location();
+    omp_set_num_threads(static_cast<int>(m_desc.num_threads));
+
+    TileScheduler scheduler(camera.width(), camera.height(), m_desc.tile_size, m_desc.tile_order, m_desc.num_threads);
+
+    // An empty list disables next event estimation
+    const auto lights = m_desc.next_event_estimation ? LightList(scene) : LightList();
+
+    log_information(camera, scheduler, lights);
+    std::cout << "\n";
+
+    auto rendering_info = create_rendering_info(camera, image, lights);
+    rendering_info.sample_counts = sample_counts;
+
+    render_tiles(scheduler, scene, rendering_info);
+
+    if (sample_counts) {
+        auto max_count = 0.0f;
+        for (const auto& count : sample_counts->pixels())
+            max_count = std::max(max_count, count.x);
+
+        for (auto& count : sample_counts->pixels())
+            count /= std::max(max_count, 1.0f);
+
+        std::cout << "Sample counts: max " << max_count << " samples per pixel\n";
+    }
+}
+
+bool RayTracer::render_progressive(const Camera& camera,
+                                   const IHittable& scene,
+                                   AccumulationBuffer& accumulation,
+                                   IImageDumper& image) const {
+    assert(camera.width() == image.width() && camera.height() == image.height());
+
+    if (accumulation.width() != camera.width() || accumulation.height() != camera.height()) {
+        std::cout << "Accumulation buffer is " << accumulation.width() << "x" << accumulation.height()
+                  << ", the camera renders " << camera.width() << "x" << camera.height() << "\n";
+        return false;
+    }
+
+    // A different seed would repeat the random streams of the samples already taken
+    if (accumulation.seed() != m_desc.seed) {
+        std::cout << "Accumulation buffer was rendered with seed " << accumulation.seed() << ", not " << m_desc.seed
+                  << "\n";
+        return false;
+    }
+
+    if (accumulation.width() == 0 || accumulation.height() == 0) {
+        std::cout << "Accumulation buffer is empty\n";
+        return false;
+    }
+
+    // Passes add the same samples to every pixel, so the buffer is uniform unless it was modified elsewhere
+    const auto first_sample = accumulation.num_samples(0, 0);
+    for (std::size_t row = 0; row < accumulation.height(); ++row) {
+        for (std::size_t col = 0; col < accumulation.width(); ++col) {
+            if (accumulation.num_samples(row, col) != first_sample) {
+                std::cout << "Accumulation buffer pixels have different sample counts\n";
+                return false;
+            }
+        }
+    }
+
+    omp_set_num_threads(static_cast<int>(m_desc.num_threads));
+
+    const auto lights = m_desc.next_event_estimation ? LightList(scene) : LightList();
+
+    const auto samples_per_pass = std::max(m_desc.samples_per_pass, 1u);
+    const auto log_scheduler =
+        TileScheduler(camera.width(), camera.height(), m_desc.tile_size, m_desc.tile_order, m_desc.num_threads);
+
+    log_information(camera, log_scheduler, lights);
+    std::cout << "    Samples per pass: " << samples_per_pass << "\n";
+    std::cout << "    Samples already taken: " << first_sample << "\n";
+    std::cout << "    Checkpoint: " << (m_desc.checkpoint_path.empty() ? "None" : m_desc.checkpoint_path.string())
+              << "\n";
+    std::cout << "\n";
+
+    auto rendering_info = create_rendering_info(camera, image, lights);
+    rendering_info.accumulation = &accumulation;
+
+    for (auto sample = first_sample; sample < m_desc.samples_per_pixel; sample += samples_per_pass) {
+        rendering_info.first_sample = sample;
+        rendering_info.num_samples = std::min(samples_per_pass, m_desc.samples_per_pixel - sample);
+
+        std::cout << "Pass: samples " << sample << " to " << sample + rendering_info.num_samples << "\n";
+
+        // Schedulers hand out every tile once, each pass needs its own
+        TileScheduler scheduler(
+            camera.width(), camera.height(), m_desc.tile_size, m_desc.tile_order, m_desc.num_threads);
+        render_tiles(scheduler, scene, rendering_info);
+
+        if (!m_desc.checkpoint_path.empty() && !accumulation.save(m_desc.checkpoint_path))
+            std::cout << "Could not write checkpoint in path: " << m_desc.checkpoint_path << "\n";
+
+        std::cout << "\n";
+    }
+
+    for (std::size_t row = 0; row < image.height(); ++row)
+        for (std::size_t col = 0; col < image.width(); ++col)
+            image.set_pixel(row, col, average(accumulation.sum(row, col), accumulation.num_samples(row, col)));
+
+    return true;
+}
 
-    // Log information
+void RayTracer::log_information(const Camera& camera, const TileScheduler& scheduler, const LightList& lights) const {
     std::cout << "RayTracer information:\n";
     std::cout << "    Width: " << camera.width() << "\n";
     std::cout << "    Height: " << camera.height() << "\n";
     std::cout << "    Samples per pixel: " << m_desc.samples_per_pixel << "\n";
+    if (m_desc.adaptive_sampling) {
+        std::cout << "    Adaptive sampling: min " << m_desc.min_samples_per_pixel << " samples, threshold "
+                  << m_desc.adaptive_threshold << "\n";
+    }
     std::cout << "    Max Depth: " << m_desc.max_depth << "\n";
+    std::cout << "    Russian roulette depth: " << m_desc.russian_roulette_depth << "\n";
+    std::cout << "    Next event estimation: " << (m_desc.next_event_estimation ? "On" : "Off") << "\n";
     std::cout << "    Num Threads: " << m_desc.num_threads << "\n";
-    std::cout << "\n";
-
-    omp_set_num_threads(static_cast<int>(m_desc.num_threads));
-
-    const auto start = std::chrono::high_resolution_clock::now();
-    uint32_t progress = 0;
+    std::cout << "    Seed: " << m_desc.seed << "\n";
+    std::cout << "    Integrator: " << (m_desc.integrator == Integrator::Wavefront ? "Wavefront" : "Iterative") << "\n";
+    std::cout << "    Packet size: " << m_desc.packet_size << "\n";
+
+    const auto& tiles = scheduler.tiles();
+    std::cout << "    Tiles: " << tiles.size() << " (" << scheduler.tile_size() << "x" << scheduler.tile_size()
+              << ")\n";
+    std::cout << "    Lights: " << lights.size() << "\n";
+}
 
-    const auto dimension = camera.height() * camera.width();
-    const auto update_progress_every = static_cast<uint32_t>(dimension * m_desc.percentage_update_progress);
+RayTracer::RenderingInfo RayTracer::create_rendering_info(const Camera& camera,
+                                                          IImageDumper& image,
+                                                          const LightList& lights) const {
+    const auto& [delta_u, delta_v] = camera.deltas();
 
-    const auto rendering_info = RenderingInfo{
+    return {
         .camera_center = camera.center(),
-        .pixel00_loc = pixel00_loc,
+        .pixel00_loc = camera.pixel00_location(),
         .delta_u = delta_u,
         .delta_v = delta_v,
-        .scale = scale,
+        .pixel_spread = camera.pixel_spread(),
         .image = image,
+        .sample_counts = nullptr,
+        .lights = lights,
+        .accumulation = nullptr,
+        .first_sample = 0,
+        .num_samples = m_desc.samples_per_pixel,
     };
+}
+
+void RayTracer::render_tiles(TileScheduler& scheduler, const IHittable& scene, const RenderingInfo& info) const {
+    const auto& tiles = scheduler.tiles();
+
+    const auto start = std::chrono::high_resolution_clock::now();
+    std::atomic<uint32_t> progress = 0;
+
+    const auto dimension = info.image.height() * info.image.width();
+    const auto update_progress_every =
+        std::max(static_cast<uint32_t>(dimension * m_desc.percentage_update_progress), 1u);
 
     const auto get_elapsed_time = [&start]() {
         const auto end = std::chrono::high_resolution_clock::now();
@@ -64,98 +210,442 @@ void RayTracer::render(const Camera& camera, const IHittable& scene, IImageDumpe
         return duration.count();
     };
 
+    // Every tile is written by a single thread, no synchronization needed
+    std::vector<double> tile_times_ms(tiles.size(), 0.0);
+
+    WavefrontIntegrator::Statistics wavefront_statistics;
+
     #pragma omp parallel
-    #pragma omp single
-    #pragma omp taskgroup
-    for (std::size_t row = 0; row < camera.height(); ++row) {
-        for (std::size_t col = 0; col < camera.width(); ++col) {
-            #pragma omp task
-            {
-                render_pixel({row, col}, scene, rendering_info);
-
-                #pragma omp atomic
-                progress++;
-
-                if (progress % update_progress_every == 0) {
-                    const auto progress_perc = static_cast<uint32_t>(progress / static_cast<double>(dimension) * 100.0);
-                    const auto elapsed = get_elapsed_time();
-                    std::cout << "[Progress]: " << progress_perc << "% - Elapsed: " << elapsed << "s\n";
-                }
+    {
+        const auto thread = static_cast<uint32_t>(omp_get_thread_num());
+
+        // Path buffers are reused by all the tiles rendered by this thread
+        WavefrontIntegrator wavefront(m_desc.max_depth, m_desc.russian_roulette_depth);
+
+        while (const auto tile = scheduler.next(thread)) {
+            const auto tile_start = std::chrono::high_resolution_clock::now();
+            render_tile(*tile, scene, info, wavefront);
+            const auto tile_end = std::chrono::high_resolution_clock::now();
+
+            tile_times_ms[tile->index] = std::chrono::duration<double, std::milli>(tile_end - tile_start).count();
+
+            const auto tile_pixels = tile->width * tile->height;
+            const auto previous = progress.fetch_add(tile_pixels, std::memory_order_relaxed);
+
+            if (previous / update_progress_every != (previous + tile_pixels) / update_progress_every) {
+                const auto progress_perc =
+                    static_cast<uint32_t>((previous + tile_pixels) / static_cast<double>(dimension) * 100.0);
+                const auto elapsed = get_elapsed_time();
+
+                #pragma omp critical
+                std::cout << "[Progress]: " << progress_perc << "% - Elapsed: " << elapsed << "s\n";
             }
         }
+
+        #pragma omp critical
+        wavefront_statistics += wavefront.statistics();
     }
 
     std::cout << "\n";
     std::cout << "Execution time: " << get_elapsed_time() << "s\n";
+
+    // Tile timing report
+    const auto [fastest, slowest] = std::minmax_element(tile_times_ms.begin(), tile_times_ms.end());
+    const auto total_ms = std::accumulate(tile_times_ms.begin(), tile_times_ms.end(), 0.0);
+    const auto& slowest_tile = tiles[static_cast<std::size_t>(slowest - tile_times_ms.begin())];
+
+    std::cout << "Tile times: min " << *fastest << "ms, avg " << total_ms / static_cast<double>(tiles.size())
+              << "ms, max " << *slowest << "ms (tile at row " << slowest_tile.row << ", col " << slowest_tile.col
+              << ")\n";
+
+    if (m_desc.integrator == Integrator::Wavefront)
+        std::cout << wavefront_statistics;
 }
 
-void RayTracer::render_pixel(Position pixel, const IHittable& scene, const RenderingInfo& info) const {
-    const auto& [row, col] = pixel;
+void RayTracer::render_tile(const TileScheduler::Tile& tile,
+                            const IHittable& scene,
+                            const RenderingInfo& info,
+                            WavefrontIntegrator& wavefront) const {
+    TileTarget target = {
+        .origin = {tile.row, tile.col},
+        .image = info.image.view(tile.row, tile.col, tile.height, tile.width),
+        .sample_counts = std::nullopt,
+    };
+    if (info.sample_counts)
+        target.sample_counts = info.sample_counts->view(tile.row, tile.col, tile.height, tile.width);
+
+    if (m_desc.adaptive_sampling && !info.accumulation) {
+        render_tile_adaptive(tile, target, scene, info, wavefront);
+        return;
+    }
 
-    const auto drow = static_cast<double>(row);
-    const auto dcol = static_cast<double>(col);
+    if (m_desc.integrator == Integrator::Wavefront) {
+        render_tile_wavefront(tile, target, scene, info, wavefront);
+        return;
+    }
 
-    const auto pixel_center = info.pixel00_loc + info.delta_u * dcol + info.delta_v * drow;
+    if (m_desc.packet_size == 1) {
+        for (std::size_t row = tile.row; row < tile.row + tile.height; ++row) {
+            for (std::size_t col = tile.col; col < tile.col + tile.width; ++col) {
+                render_pixel({row, col}, target, scene, info);
+            }
+        }
+        return;
+    }
 
-    vec3 color{0.0};
-    for (std::size_t s = 0; s < m_desc.samples_per_pixel; ++s) {
-        const auto pixel_sample = pixel_center + pixel_sample_square(info.delta_u, info.delta_v);
-        const auto direction = pixel_sample - info.camera_center;
+    const auto [packet_width, packet_height] = packet_dimensions(m_desc.packet_size);
 
-        const auto ray = Ray(info.camera_center, direction);
-        color += ray_color_r(ray, scene, m_desc.max_depth);
+    for (auto row = tile.row; row < tile.row + tile.height; row += packet_height) {
+        for (auto col = tile.col; col < tile.col + tile.width; col += packet_width) {
+            const auto width = std::min(packet_width, tile.col + tile.width - col);
+            const auto height = std::min(packet_height, tile.row + tile.height - row);
+
+            render_packet({row, col}, width, height, target, scene, info);
+        }
     }
+}
 
-    color *= info.scale;
+void RayTracer::render_tile_wavefront(const TileScheduler::Tile& tile,
+                                      const TileTarget& target,
+                                      const IHittable& scene,
+                                      const RenderingInfo& info,
+                                      WavefrontIntegrator& wavefront) const {
+    wavefront.clear();
+
+    // Generate: the samples of a pixel are consecutive paths, in the same order as the iterative integrator
+    for (auto row = tile.row; row < tile.row + tile.height; ++row) {
+        for (auto col = tile.col; col < tile.col + tile.width; ++col) {
+            const auto pixel_index = row * info.image.width() + col;
+
+            for (auto s = info.first_sample; s < info.first_sample + info.num_samples; ++s) {
+                Sampler sampler(m_desc.seed, pixel_index, s);
+                const auto ray = camera_ray({row, col}, info, sampler);
+                wavefront.add_path(ray, sampler);
+            }
+        }
+    }
 
-    auto r = linear_to_gamma(color.r);
-    auto g = linear_to_gamma(color.g);
-    auto b = linear_to_gamma(color.b);
+    wavefront.trace(scene, info.lights);
 
-    assert(!std::isnan(r) && !std::isnan(g) && !std::isnan(b));
+    uint32_t path = 0;
+    for (auto row = tile.row; row < tile.row + tile.height; ++row) {
+        for (auto col = tile.col; col < tile.col + tile.width; ++col) {
+            vec3 color{0.0};
+            for (uint32_t s = 0; s < info.num_samples; ++s)
+                color += wavefront.radiance(path++);
 
-    info.image[row][col] = vec3(r, g, b);
+            write_pixel({row, col}, color, info.num_samples, target, info);
+        }
+    }
 }
 
-vec3 RayTracer::ray_color_r(const Ray& ray, const IHittable& scene, uint32_t depth) {
-    if (depth == 0)
-        return vec3{0.0};
+void RayTracer::render_tile_adaptive(const TileScheduler::Tile& tile,
+                                     const TileTarget& target,
+                                     const IHittable& scene,
+                                     const RenderingInfo& info,
+                                     WavefrontIntegrator& wavefront) const {
+    const auto num_pixels = tile.width * tile.height;
+    const auto budget = static_cast<uint64_t>(m_desc.samples_per_pixel) * num_pixels;
+
+    // Neighbours in other tiles are not known yet, so convergence is decided inside the tile
+
+    AdaptiveSampling adaptive(
+        {
+            .min_samples = m_desc.min_samples_per_pixel,
+            .batch_size = m_desc.min_samples_per_pixel,
+            .threshold = m_desc.adaptive_threshold,
+        },
+        tile.width,
+        tile.height,
+        budget);
+
+    const auto position = [&tile](uint32_t pixel) {
+        return Position{tile.row + pixel / tile.width, tile.col + pixel % tile.width};
+    };
+
+    // Sample indices continue between rounds, so every sample keeps its own random stream and both integrators
+    // still produce the same image
+    while (true) {
+        const auto& round = adaptive.next_round();
+        if (round.empty())
+            break;
 
-    const auto record = scene.hits(ray, interval(0.001, interval::infinity));
-    if (record) {
-        auto color_scatter = vec3{0.0};
-        auto color_emission = vec3{0.0};
+        if (m_desc.integrator == Integrator::Wavefront)
+            wavefront.clear();
 
-        const auto material_hit = record->material->scatter(ray, *record);
-        if (material_hit) {
-            const auto scattering_prob = record->material->scattering_prob(ray, *record, material_hit->scatter);
+        for (const auto& request : round) {
+            const auto pixel = position(request.pixel);
+            const auto pixel_index = pixel.first * info.image.width() + pixel.second;
 
-            const auto color =
-                material_hit->attenuation * scattering_prob * ray_color_r(material_hit->scatter, scene, depth - 1);
-            color_scatter += color / material_hit->pdf;
+            for (auto s = request.first_sample; s < request.first_sample + request.num_samples; ++s) {
+                Sampler sampler(m_desc.seed, pixel_index, s);
+                const auto ray = camera_ray(pixel, info, sampler);
+
+                if (m_desc.integrator == Integrator::Wavefront)
+                    wavefront.add_path(ray, sampler);
+                else
+                    adaptive.add_sample(request.pixel, path_radiance(ray, scene, info.lights, sampler));
+            }
         }
 
-        const auto emission_color = record->material->emitted(record->uv.x, record->uv.y);
-        if (emission_color) {
-            color_emission += *emission_color;
+        if (m_desc.integrator == Integrator::Wavefront) {
+            wavefront.trace(scene, info.lights);
+
+            uint32_t path = 0;
+            for (const auto& request : round)
+                for (uint32_t s = 0; s < request.num_samples; ++s)
+                    adaptive.add_sample(request.pixel, wavefront.radiance(path++));
         }
+    }
 
-        return color_scatter + color_emission;
+    for (uint32_t pixel = 0; pixel < num_pixels; ++pixel)
+        write_pixel(position(pixel), adaptive.sum(pixel), adaptive.num_samples(pixel), target, info);
+}
+
+void RayTracer::render_pixel(Position pixel,
+                             const TileTarget& target,
+                             const IHittable& scene,
+                             const RenderingInfo& info) const {
+    const auto& [row, col] = pixel;
+    const auto pixel_index = row * info.image.width() + col;
+
+    vec3 color{0.0};
+    for (auto s = info.first_sample; s < info.first_sample + info.num_samples; ++s) {
+        // Each sample has its own random stream, so the result does not depend on the thread rendering it
+        Sampler sampler(m_desc.seed, pixel_index, s);
+
+        const auto ray = camera_ray(pixel, info, sampler);
+        color += path_radiance(ray, scene, info.lights, sampler);
     }
 
-    // Sky
-    // const vec3 unit_direction = glm::normalize(ray.direction());
-    // const auto a = 0.5 * (unit_direction.y + 1.0);
-    // return (1.0 - a) * vec3(1.0) + a * vec3(0.5f, 0.7f, 1.0f);
-    return vec3{0.0};
+    write_pixel(pixel, color, info.num_samples, target, info);
 }
 
-vec3 RayTracer::pixel_sample_square(const vec3& delta_u, const vec3& delta_v) {
-    const auto px = -0.5 + random_double();
-    const auto py = -0.5 + random_double();
-    return (px * delta_u) + (py * delta_v);
+void RayTracer::render_packet(Position first_pixel,
+                              uint32_t width,
+                              uint32_t height,
+                              const TileTarget& target,
+                              const IHittable& scene,
+                              const RenderingInfo& info) const {
+    const auto& [first_row, first_col] = first_pixel;
+    const auto size = width * height;
+    assert(size <= RayPacket::MAX_SIZE);
+
+    Position pixels[RayPacket::MAX_SIZE];
+    vec3 colors[RayPacket::MAX_SIZE];
+
+    for (uint32_t lane = 0; lane < size; ++lane) {
+        pixels[lane] = {first_row + lane / width, first_col + lane % width};
+        colors[lane] = vec3(0.0);
+    }
+
+    std::vector<Sampler> samplers;
+    samplers.reserve(size);
+
+    for (auto s = info.first_sample; s < info.first_sample + info.num_samples; ++s) {
+        RayPacket packet;
+        samplers.clear();
+
+        // Same random streams as the single ray path, so both produce the same image
+        for (uint32_t lane = 0; lane < size; ++lane) {
+            const auto& [row, col] = pixels[lane];
+            samplers.emplace_back(m_desc.seed, row * info.image.width() + col, s);
+            packet.add(camera_ray(pixels[lane], info, samplers.back()));
+        }
+        packet.compute_bounds();
+
+        if (m_desc.max_depth == 0)
+            continue;
+
+        PacketHitRecord record;
+        std::fill(std::begin(record.t_max), std::end(record.t_max), interval::infinity);
+        scene.intersect_packet(packet, packet.all_lanes(), record);
+
+        // Secondary bounces are incoherent, continue every path on its own
+        for (uint32_t lane = 0; lane < size; ++lane) {
+            const auto& ray = packet.rays[lane];
+            colors[lane] += path_radiance(ray, record.intersections[lane], scene, info.lights, samplers[lane]);
+        }
+    }
+
+    for (uint32_t lane = 0; lane < size; ++lane)
+        write_pixel(pixels[lane], colors[lane], info.num_samples, target, info);
+}
+
+void RayTracer::write_pixel(Position pixel,
+                            vec3 color,
+                            uint32_t num_samples,
+                            const TileTarget& target,
+                            const RenderingInfo& info) const {
+    // Progressive passes only accumulate, the image is resolved once all of them are done
+    if (info.accumulation) {
+        info.accumulation->add(pixel.first, pixel.second, color, num_samples);
+        return;
+    }
+
+    const auto row = pixel.first - target.origin.first;
+    const auto col = pixel.second - target.origin.second;
+
+    if (target.sample_counts)
+        (*target.sample_counts)(row, col) = IImageDumper::Pixel(static_cast<float>(num_samples));
+
+    target.image(row, col) = IImageDumper::Pixel(average(color, num_samples));
+}
+
+vec3 RayTracer::average(vec3 color, uint32_t num_samples) {
+    color /= static_cast<real>(std::max(num_samples, 1u));
+
+    assert(!std::isnan(color.r) && !std::isnan(color.g) && !std::isnan(color.b));
+
+    return color;
 }
 
-double RayTracer::linear_to_gamma(double val) {
-    return glm::sqrt(val);
+void RayTracer::benchmark_primary_rays(const Camera& camera, const IHittable& scene) const {
+    const auto& [delta_u, delta_v] = camera.deltas();
+
+    // Rays through the pixel centers, no random sampling needed
+    const auto primary_ray = [&](uint32_t row, uint32_t col) {
+        const auto pixel_center = camera.pixel00_location() + delta_u * static_cast<real>(col) +
+                                  delta_v * static_cast<real>(row);
+        return Ray(camera.center(), pixel_center - camera.center());
+    };
+
+    const auto num_rays = static_cast<double>(camera.width()) * static_cast<double>(camera.height());
+
+    const auto log_throughput = [&](const std::string& name, auto&& trace) {
+        const auto start = std::chrono::high_resolution_clock::now();
+        const auto num_hits = trace();
+        const auto end = std::chrono::high_resolution_clock::now();
+
+        const auto seconds = std::chrono::duration<double>(end - start).count();
+        std::cout << "    " << name << ": " << num_rays / seconds / 1e6 << " Mrays/s (" << num_hits << " hits)\n";
+    };
+
+    std::cout << "Primary ray throughput:\n";
+
+    log_throughput("Single ray", [&]() {
+        uint32_t num_hits = 0;
+        for (uint32_t row = 0; row < camera.height(); ++row) {
+            for (uint32_t col = 0; col < camera.width(); ++col) {
+                if (scene.intersect(primary_ray(row, col), interval(RAY_T_MIN, interval::infinity)))
+                    num_hits++;
+            }
+        }
+        return num_hits;
+    });
+
+    for (const auto packet_size : {4u, 8u, 16u}) {
+        const auto [packet_width, packet_height] = packet_dimensions(packet_size);
+
+        log_throughput("Packet " + std::to_string(packet_size), [&]() {
+            uint32_t num_hits = 0;
+            for (uint32_t row = 0; row < camera.height(); row += packet_height) {
+                for (uint32_t col = 0; col < camera.width(); col += packet_width) {
+                    RayPacket packet;
+                    for (auto r = row; r < std::min(row + packet_height, camera.height()); ++r) {
+                        for (auto c = col; c < std::min(col + packet_width, camera.width()); ++c)
+                            packet.add(primary_ray(r, c));
+                    }
+                    packet.compute_bounds();
+
+                    PacketHitRecord record;
+                    std::fill(std::begin(record.t_max), std::end(record.t_max), interval::infinity);
+                    scene.intersect_packet(packet, packet.all_lanes(), record);
+
+                    for (uint32_t lane = 0; lane < packet.size; ++lane)
+                        num_hits += record.intersections[lane].has_value() ? 1 : 0;
+                }
+            }
+            return num_hits;
+        });
+    }
+}
+
+std::pair<uint32_t, uint32_t> RayTracer::packet_dimensions(uint32_t packet_size) {
+    // As square as possible, wider than taller: 4 -> 2x2, 8 -> 4x2, 16 -> 4x4
+    const auto width = 1u << (std::bit_width(packet_size) / 2);
+    return {width, packet_size / width};
+}
+
+Ray RayTracer::camera_ray(Position pixel, const RenderingInfo& info, Sampler& sampler) {
+    const auto& [row, col] = pixel;
+
+    const auto pixel_center =
+        info.pixel00_loc + info.delta_u * static_cast<real>(col) + info.delta_v * static_cast<real>(row);
+    const auto pixel_sample = pixel_center + pixel_sample_square(info.delta_u, info.delta_v, sampler);
+
+    return {info.camera_center, pixel_sample - info.camera_center, RayCone{.width = 0, .spread = info.pixel_spread}};
+}
+
+vec3 RayTracer::path_radiance(const Ray& ray,
+                              const IHittable& scene,
+                              const LightList& lights,
+                              Sampler& sampler) const {
+    if (m_desc.max_depth == 0)
+        return vec3{0.0};
+
+    return path_radiance(ray, scene.intersect(ray, interval(RAY_T_MIN, interval::infinity)), scene, lights, sampler);
+}
+
+vec3 RayTracer::path_radiance(Ray ray,
+                              std::optional<Intersection> intersection,
+                              const IHittable& scene,
+                              const LightList& lights,
+                              Sampler& sampler) const {
+    auto radiance = vec3{0.0};
+    auto throughput = vec3{1.0};
+
+    // Vertex that scattered ray, and the density it was sampled with. Zero for camera rays and specular
+    // scattering, whose emission can only be found by following the path.
+    auto scatter_point = vec3{0.0};
+    auto scatter_pdf = real(0);
+
+    for (uint32_t depth = 0; depth < m_desc.max_depth; ++depth) {
+        if (depth > 0) {
+            if (!m_russian_roulette.survives(depth, throughput, sampler))
+                break;
+
+            intersection = scene.intersect(ray, interval(RAY_T_MIN, interval::infinity));
+        }
+
+        // Paths escaping the scene terminate, the sky does not emit
+        if (!intersection)
+            break;
+
+        const auto hit = scene.compute_interaction(ray, *intersection);
+        const auto& material = *hit.material;
+
+        if (const auto emission = material.emitted(hit.uv.x, hit.uv.y)) {
+            const auto weight = scatter_pdf > 0 ? lights.emission_weight(scatter_point, scatter_pdf, *intersection, hit)
+                                                : real(1);
+            radiance += throughput * weight * *emission;
+        }
+
+        const auto material_hit = material.scatter(ray, hit, sampler);
+        if (!material_hit)
+            break;
+
+        // The ray scattered at the last vertex is never traced, so the BSDF half of the MIS weights would be missing.
+        // The light sample is skipped there too, both strategies then cover the same paths.
+        const auto is_last_vertex = depth + 1 == m_desc.max_depth;
+        if (const auto connection = !is_last_vertex ? lights.connect(ray, hit, sampler) : std::nullopt)
+            radiance += throughput * lights.connection_radiance(*connection, scene);
+
+        const auto scattering_prob = material.scattering_prob(ray, hit, material_hit->scatter);
+        throughput *= material_hit->attenuation * scattering_prob / material_hit->pdf;
+
+        const auto evaluation = material.evaluate(ray, hit, glm::normalize(material_hit->scatter.direction()));
+        scatter_point = hit.point;
+        scatter_pdf = evaluation ? evaluation->pdf : real(0);
+
+        ray = material_hit->scatter;
+    }
+
+    return radiance;
+}
+
+vec3 RayTracer::pixel_sample_square(const vec3& delta_u, const vec3& delta_v, Sampler& sampler) {
+    const auto px = sampler.next_real() - real(0.5);
+    const auto py = sampler.next_real() - real(0.5);
+    return (px * delta_u) + (py * delta_v);
 }
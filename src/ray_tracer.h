@@ -1,22 +1,57 @@
 #pragma once
 
 #include <cstdint>
+#include <filesystem>
+#include <optional>
 
 #include "vec.h"
+#include "image_dumper.h"
+#include "russian_roulette.h"
+#include "tile_scheduler.h"
 
 // Forward declarations
+class AccumulationBuffer;
 class Camera;
 class Ray;
 class IHittable;
-class IImageDumper;
+class LightList;
+class Sampler;
+class WavefrontIntegrator;
+struct Intersection;
 
 class RayTracer {
   public:
+    enum class Integrator {
+        Iterative, // Every path is followed on its own, one bounce after the other, until it terminates
+        Wavefront, // All the paths of a tile advance one bounce at a time, see WavefrontIntegrator
+    };
+
     struct Description {
         // Rendering params
         uint32_t samples_per_pixel = 10;
         uint32_t max_depth = 10;
+        uint32_t russian_roulette_depth = 3; // Bounces before paths may be terminated by Russian roulette,
+                                             // max_depth or more disables it
+        bool next_event_estimation = true; // Sample emissive primitives at every non specular vertex
         uint32_t num_threads = 1;
+        uint64_t seed = 0; // Renders with the same seed are identical, independently of num_threads
+        Integrator integrator = Integrator::Iterative;
+
+        // Adaptive sampling params. samples_per_pixel becomes the average budget of every tile: pixels stop once the
+        // relative error of their mean falls under adaptive_threshold, and the samples left go to the noisiest ones.
+        bool adaptive_sampling = false;
+        uint32_t min_samples_per_pixel = 8; // Taken by every pixel first, and by every noisy pixel in each round
+        real adaptive_threshold = real(0.05);
+
+        // Progressive params, see render_progressive
+        uint32_t samples_per_pass = 16;
+        std::filesystem::path checkpoint_path{}; // Accumulation buffer saved after every pass, empty disables it
+
+        // Scheduling params
+        uint32_t tile_size = 16; // Side in pixels of the square tiles handed out to threads
+        TileScheduler::Order tile_order = TileScheduler::Order::Hilbert;
+        uint32_t packet_size = 1; // Camera rays traced together (4, 8 or 16), 1 traces every ray on its own.
+                                  // Only used by the iterative integrator, without adaptive sampling.
 
         // Log params
         double percentage_update_progress = 0.2; // Displays progress every time it reaches the specified percentage
@@ -27,24 +62,111 @@ class RayTracer {
 
     [[nodiscard]] static uint32_t max_num_threads();
 
-    void render(const Camera& camera, const IHittable& scene, IImageDumper& image) const;
+    // If sample_counts is given, it receives the number of samples taken by every pixel, normalized so the pixel
+    // with the most samples is 1. 8 bit dumpers keep it proportional to the count with IImageDumper::Transfer::Linear.
+    void render(const Camera& camera,
+                const IHittable& scene,
+                IImageDumper& image,
+                IImageDumper* sample_counts = nullptr) const;
+
+    // Renders in passes of samples_per_pass samples per pixel, accumulated into accumulation until every pixel has
+    // samples_per_pixel samples, and then resolves the image. After every pass the buffer is saved to the checkpoint
+    // path, so an interrupted render loses no work: loading the checkpoint and calling this again continues where it
+    // stopped, and raising samples_per_pixel refines a finished render. Adaptive sampling is not used. Returns false
+    // if the buffer does not match the camera or the seed.
+    bool render_progressive(const Camera& camera,
+                            const IHittable& scene,
+                            AccumulationBuffer& accumulation,
+                            IImageDumper& image) const;
 
+    // Traces one camera ray per pixel, one by one and in packets of 4, 8 and 16 rays, and logs the
+    // throughput of each method. Only primary visibility is computed, in a single thread.
+    void benchmark_primary_rays(const Camera& camera, const IHittable& scene) const;
 
   private:
     Description m_desc;
+    RussianRoulette m_russian_roulette;
 
     struct RenderingInfo {
         vec3 camera_center;
         vec3 pixel00_loc;
         vec3 delta_u, delta_v;
-        double scale;
+        real pixel_spread;
         IImageDumper& image;
+        IImageDumper* sample_counts;
+        const LightList& lights;
+
+        // Samples [first_sample, first_sample + num_samples) are taken by every pixel. Progressive passes add them
+        // to the accumulation buffer instead of writing the image.
+        AccumulationBuffer* accumulation;
+        uint32_t first_sample;
+        uint32_t num_samples;
     };
 
+    void log_information(const Camera& camera, const TileScheduler& scheduler, const LightList& lights) const;
+    [[nodiscard]] RenderingInfo create_rendering_info(const Camera& camera,
+                                                      IImageDumper& image,
+                                                      const LightList& lights) const;
+
+    void render_tiles(TileScheduler& scheduler, const IHittable& scene, const RenderingInfo& info) const;
+
     using Position = std::pair<std::size_t, std::size_t>;
-    void render_pixel(Position pixel, const IHittable& scene, const RenderingInfo& info) const;
 
-    [[nodiscard]] static vec3 ray_color_r(const Ray& ray, const IHittable& scene, uint32_t depth);
-    [[nodiscard]] static vec3 pixel_sample_square(const vec3& delta_u, const vec3& delta_v);
-    [[nodiscard]] static double linear_to_gamma(double val);
+    // Pixels of the tile being rendered in the image and in the sample counts, addressed from the tile origin
+    struct TileTarget {
+        Position origin;
+        IImageDumper::View<IImageDumper::Pixel> image;
+        std::optional<IImageDumper::View<IImageDumper::Pixel>> sample_counts;
+    };
+
+    void render_tile(const TileScheduler::Tile& tile,
+                     const IHittable& scene,
+                     const RenderingInfo& info,
+                     WavefrontIntegrator& wavefront) const;
+    void render_tile_wavefront(const TileScheduler::Tile& tile,
+                               const TileTarget& target,
+                               const IHittable& scene,
+                               const RenderingInfo& info,
+                               WavefrontIntegrator& wavefront) const;
+    void render_tile_adaptive(const TileScheduler::Tile& tile,
+                              const TileTarget& target,
+                              const IHittable& scene,
+                              const RenderingInfo& info,
+                              WavefrontIntegrator& wavefront) const;
+
+    void render_pixel(Position pixel,
+                      const TileTarget& target,
+                      const IHittable& scene,
+                      const RenderingInfo& info) const;
+    void render_packet(Position first_pixel,
+                       uint32_t width,
+                       uint32_t height,
+                       const TileTarget& target,
+                       const IHittable& scene,
+                       const RenderingInfo& info) const;
+    // color is the sum of the num_samples samples taken by the pixel
+    void write_pixel(Position pixel,
+                     vec3 color,
+                     uint32_t num_samples,
+                     const TileTarget& target,
+                     const RenderingInfo& info) const;
+
+    // Average of num_samples samples summing color
+    [[nodiscard]] static vec3 average(vec3 color, uint32_t num_samples);
+
+    [[nodiscard]] static std::pair<uint32_t, uint32_t> packet_dimensions(uint32_t packet_size);
+    [[nodiscard]] static Ray camera_ray(Position pixel, const RenderingInfo& info, Sampler& sampler);
+
+    // Radiance arriving along ray, estimated by a single path. The second overload starts from the already known
+    // first intersection of the ray.
+    [[nodiscard]] vec3 path_radiance(const Ray& ray,
+                                     const IHittable& scene,
+                                     const LightList& lights,
+                                     Sampler& sampler) const;
+    [[nodiscard]] vec3 path_radiance(Ray ray,
+                                     std::optional<Intersection> intersection,
+                                     const IHittable& scene,
+                                     const LightList& lights,
+                                     Sampler& sampler) const;
+    [[nodiscard]] static vec3 pixel_sample_square(const vec3& delta_u, const vec3& delta_v, Sampler& sampler);
 };
@@ -0,0 +1,19 @@
+#include "russian_roulette.h"
+
+#include <algorithm>
+
+#include "sampler.h"
+
+RussianRoulette::RussianRoulette(uint32_t start_depth) : m_start_depth(start_depth) {}
+
+bool RussianRoulette::survives(uint32_t depth, vec3& throughput, Sampler& sampler) const {
+    if (depth < m_start_depth)
+        return true;
+
+    const auto survival = std::min(std::max({throughput.x, throughput.y, throughput.z}), MAX_SURVIVAL);
+    if (sampler.next_real() >= survival)
+        return false;
+
+    throughput /= survival;
+    return true;
+}
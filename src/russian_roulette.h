@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+#include "vec.h"
+
+// Forward declarations
+class Sampler;
+
+// Probabilistic path termination. Once a path has bounced start_depth times it survives every further bounce with
+// a probability following its throughput, and the throughput of the surviving paths is divided by that probability
+// so the estimate stays unbiased. Dark or absorbing paths end early instead of running to the maximum depth.
+class RussianRoulette {
+  public:
+    // Upper bound of the survival probability, so paths with a bright throughput also end eventually
+    static constexpr real MAX_SURVIVAL = real(0.95);
+
+    explicit RussianRoulette(uint32_t start_depth);
+
+    // Returns whether a path that has completed depth bounces continues, updating its throughput if it does
+    [[nodiscard]] bool survives(uint32_t depth, vec3& throughput, Sampler& sampler) const;
+
+  private:
+    uint32_t m_start_depth;
+};
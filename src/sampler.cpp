@@ -0,0 +1,26 @@
+#include "sampler.h"
+
+// SplitMix64 finalizer, used to turn correlated inputs (consecutive pixels, samples) into unrelated seeds
+static uint64_t mix(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30u)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27u)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31u);
+}
+
+Sampler::Sampler(uint64_t seed) {
+    this->seed(mix(seed), 0);
+}
+
+Sampler::Sampler(uint64_t seed, uint64_t pixel, uint64_t sample) {
+    this->seed(mix(seed ^ mix(pixel)), mix(sample));
+}
+
+void Sampler::seed(uint64_t state, uint64_t stream) {
+    m_state = 0;
+    m_increment = (stream << 1u) | 1u;
+
+    (void)next_uint32();
+    m_state += state;
+    (void)next_uint32();
+}
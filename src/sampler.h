@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+#include "vec.h"
+
+// PCG32 random number generator (https://www.pcg-random.org). Every (pixel, sample) pair gets its own
+// independent stream derived from a global seed, so renders are reproducible for any number of threads.
+class Sampler {
+  public:
+    explicit Sampler(uint64_t seed);
+    Sampler(uint64_t seed, uint64_t pixel, uint64_t sample);
+
+    [[nodiscard]] uint32_t next_uint32() {
+        const auto old_state = m_state;
+        m_state = old_state * 6364136223846793005ull + m_increment;
+
+        const auto xor_shifted = static_cast<uint32_t>(((old_state >> 18u) ^ old_state) >> 27u);
+        const auto rotation = static_cast<uint32_t>(old_state >> 59u);
+        return (xor_shifted >> rotation) | (xor_shifted << ((~rotation + 1u) & 31u));
+    }
+
+    // Uniform double in [0, 1)
+    [[nodiscard]] double next_double() { return static_cast<double>(next_uint32()) * 0x1p-32; }
+    [[nodiscard]] double next_double(double min, double max) { return (max - min) * next_double() + min; }
+
+    // Uniform real in [0, 1). In single precision only 24 bits are used, so the value can not round up to 1.
+    [[nodiscard]] real next_real() {
+        if constexpr (std::is_same_v<real, float>)
+            return static_cast<float>(next_uint32() >> 8u) * 0x1p-24f;
+        else
+            return next_double();
+    }
+    [[nodiscard]] real next_real(real min, real max) { return (max - min) * next_real() + min; }
+
+    // Uniform integer in [min, max]
+    [[nodiscard]] int32_t next_int(int32_t min, int32_t max) {
+        return static_cast<int32_t>(next_double(min, static_cast<double>(max) + 1.0));
+    }
+
+  private:
+    uint64_t m_state = 0;
+    uint64_t m_increment = 0;
+
+    void seed(uint64_t state, uint64_t stream);
+};
@@ -1,58 +1,291 @@
 #include "texture.h"
 
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <cassert>
-#include <cstring>
+#include <cmath>
+#include <iostream>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
+#include "texture_cache.h"
+
+// Linear value of every 8 bit sRGB value
+static const std::array<float, 256>& srgb_to_linear() {
+    static const auto table = []() {
+        std::array<float, 256> values{};
+        for (uint32_t i = 0; i < values.size(); ++i) {
+            const auto c = static_cast<double>(i) / 255.0;
+            const auto linear = c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+            values[i] = static_cast<float>(linear);
+        }
+        return values;
+    }();
+
+    return table;
+}
+
 Texture::Texture(const std::filesystem::path& path, Filtering filtering) : m_filtering(filtering) {
     int32_t width, height, channels;
-    auto* data = stbi_load(path.c_str(), &width, &height, &channels, 0);
-    assert(data != nullptr);
-
-    assert(channels == 4 || channels == 3);
+    [[maybe_unused]] const auto found = stbi_info(path.c_str(), &width, &height, &channels);
+    assert(found && (channels == 4 || channels == 3));
 
     m_width = static_cast<uint32_t>(width);
     m_height = static_cast<uint32_t>(height);
     m_channels = static_cast<uint32_t>(channels);
 
-    const auto data_size = m_width * m_height * channels * sizeof(std::byte);
-    m_data = std::vector<std::byte>(data_size);
-    memcpy(m_data.data(), data, data_size);
+    m_image = read(path);
+    assert(m_image != nullptr);
+    m_pyramid = m_image.get();
+}
 
-    stbi_image_free(data);
+Texture::Texture(uint32_t width, uint32_t height, uint32_t channels, std::vector<std::byte> data, Filtering filtering)
+      : m_width(width), m_height(height), m_channels(channels), m_filtering(filtering) {
+    assert(channels == 4 || channels == 3);
+    assert(data.size() == width * height * channels);
+
+    m_image = decode(width, height, channels, data.data());
+    m_pyramid = m_image.get();
 }
 
-vec3 Texture::sample(double u, double v) const {
-    const auto u_pos = static_cast<double>(m_width - 1) * u;
-    const auto v_pos = static_cast<double>(m_height - 1) * v;
+Texture::Texture(const std::filesystem::path& path,
+                 uint32_t width,
+                 uint32_t height,
+                 uint32_t channels,
+                 Filtering filtering,
+                 TextureCache& cache)
+      : m_width(width), m_height(height), m_channels(channels), m_filtering(filtering), m_path(path), m_cache(&cache) {}
+
+uint32_t Texture::num_levels() const {
+    return static_cast<uint32_t>(std::bit_width(std::max(m_width, m_height)));
+}
+
+vec3 Texture::sample(real u, real v, real footprint) const {
+    return sample(u, v, Footprint{.width = footprint});
+}
+
+vec3 Texture::sample(real u, real v, const Footprint& footprint) const {
+    if (m_cache == nullptr)
+        return filter(*m_image, u, v, footprint);
+
+    auto& pinned = m_cache->reader().pyramid;
+    const auto* pyramid = pin(pinned);
+    const auto color = pyramid != nullptr ? filter(*pyramid, u, v, footprint) : vec3(0.0);
+
+    pinned.store(nullptr, std::memory_order_release);
+    return color;
+}
+
+vec3 Texture::filter(const Pyramid& pyramid, real u, real v, const Footprint& footprint) const {
+    const auto& levels = pyramid.levels;
+    const auto max_lod = static_cast<real>(levels.size() - 1);
+    const auto major = glm::length(footprint.major_axis);
+    const auto width = std::max(footprint.width, major);
 
     switch (m_filtering) {
     default:
     case Filtering::Nearest: {
-        const auto u_nearest = static_cast<uint32_t>(round(u_pos));
-        const auto v_nearest = static_cast<uint32_t>(round(v_pos));
+        const auto& image = levels.front();
+        const auto u_nearest = static_cast<uint32_t>(std::round(static_cast<real>(image.width - 1) * u));
+        const auto v_nearest = static_cast<uint32_t>(std::round(static_cast<real>(image.height - 1) * v));
 
-        return get_color_at(u_nearest, v_nearest);
+        return get_color_at(image, u_nearest, v_nearest);
+    }
+    case Filtering::Bilinear: {
+        const auto lod = std::clamp(level_of_detail(width), real(0), max_lod);
+        return bilinear(levels[static_cast<std::size_t>(std::round(lod))], u, v);
     }
-    case Filtering::Bilinear:
-        assert(false && "Not implemented");
-        break;
     case Filtering::Trilinear:
-        assert(false && "Not implemented");
-        break;
-    case Filtering::Anisotropic:
-        assert(false && "Not implemented");
-        break;
+        return trilinear(levels, u, v, std::clamp(level_of_detail(width), real(0), max_lod));
+    case Filtering::Anisotropic: {
+        // Samples as wide as the minor extent, evenly spaced along the major axis so that together they cover it
+        const auto minor = std::max(footprint.width, major / static_cast<real>(MAX_ANISOTROPY));
+        const auto lod = std::clamp(level_of_detail(minor), real(0), max_lod);
+        if (!(major > minor))
+            return trilinear(levels, u, v, std::clamp(level_of_detail(width), real(0), max_lod));
+
+        const auto num_samples = std::min(static_cast<uint32_t>(std::ceil(major / minor)), MAX_ANISOTROPY);
+
+        vec3 color{0.0};
+        for (uint32_t i = 0; i < num_samples; ++i) {
+            const auto offset = (static_cast<real>(i) + real(0.5)) / static_cast<real>(num_samples) - real(0.5);
+            color += trilinear(levels, u + offset * footprint.major_axis.x, v + offset * footprint.major_axis.y, lod);
+        }
+
+        return color / static_cast<real>(num_samples);
+    }
+    }
+}
+
+const Texture::Pyramid* Texture::pin(std::atomic<const Pyramid*>& pinned) const {
+    while (true) {
+        const auto* pyramid = m_pyramid.load(std::memory_order_acquire);
+        if (pyramid != nullptr) {
+            // Pinned before checking that the texels are still resident: eviction either sees the pin, or removed
+            // them before the check and they are loaded again
+            pinned.store(pyramid, std::memory_order_seq_cst);
+            if (m_pyramid.load(std::memory_order_seq_cst) != pyramid)
+                continue;
+
+            m_cache->touch(*this);
+            return pyramid;
+        }
+
+        // An image that became unreadable would be read again, and reported, on every sample
+        if (m_failed.load(std::memory_order_relaxed))
+            return nullptr;
+
+        // Other threads missing at the same time wait for the first one to decode it
+        std::lock_guard lock(m_load_mutex);
+        if (m_failed.load(std::memory_order_relaxed))
+            return nullptr;
+        if (m_pyramid.load(std::memory_order_acquire) != nullptr)
+            continue;
+
+        auto decoded = read(m_path);
+        if (decoded == nullptr) {
+            m_failed.store(true, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        // Pinned before it is published, the evictions of this decode cannot free it
+        pyramid = decoded.get();
+        pinned.store(pyramid, std::memory_order_seq_cst);
+        m_cache->add_resident(*this, std::move(decoded));
+        return pyramid;
+    }
+}
+
+std::size_t Texture::Level::index(uint32_t x, uint32_t y) const {
+    const auto tile = static_cast<std::size_t>(y / TILE_SIZE) * num_tiles_x + x / TILE_SIZE;
+    return tile * TILE_SIZE * TILE_SIZE + (y % TILE_SIZE) * TILE_SIZE + x % TILE_SIZE;
+}
+
+std::size_t Texture::Pyramid::memory_size() const {
+    std::size_t size = 0;
+    for (const auto& level : levels)
+        size += level.texels.size() * sizeof(glm::vec3);
+    return size;
+}
+
+std::unique_ptr<const Texture::Pyramid> Texture::read(const std::filesystem::path& path) {
+    int32_t width, height, channels;
+    auto* data = stbi_load(path.c_str(), &width, &height, &channels, 0);
+    if (data == nullptr) {
+        std::cout << "Could not read texture in path: " << path << "\n";
+        return nullptr;
     }
+
+    assert(channels == 4 || channels == 3);
+
+    auto pyramid = decode(static_cast<uint32_t>(width),
+                          static_cast<uint32_t>(height),
+                          static_cast<uint32_t>(channels),
+                          reinterpret_cast<const std::byte*>(data));
+
+    stbi_image_free(data);
+    return pyramid;
 }
 
-vec3 Texture::get_color_at(uint32_t u, uint32_t v) const {
-    const auto pos = v * m_width * m_channels + u * m_channels;
-    assert(pos < m_data.size());
+std::unique_ptr<const Texture::Pyramid> Texture::decode(uint32_t width,
+                                                        uint32_t height,
+                                                        uint32_t channels,
+                                                        const std::byte* data) {
+    const auto& to_linear = srgb_to_linear();
+
+    auto pyramid = std::make_unique<Pyramid>();
+
+    auto& image = pyramid->levels.emplace_back(create_level(width, height));
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            const auto* texel = data + (static_cast<std::size_t>(y) * width + x) * channels;
+            image.texels[image.index(x, y)] = glm::vec3(to_linear[static_cast<uint8_t>(texel[0])],
+                                                        to_linear[static_cast<uint8_t>(texel[1])],
+                                                        to_linear[static_cast<uint8_t>(texel[2])]);
+        }
+    }
+
+    build_levels(*pyramid);
+    return pyramid;
+}
+
+void Texture::build_levels(Pyramid& pyramid) {
+    auto& levels = pyramid.levels;
+
+    while (levels.back().width > 1 || levels.back().height > 1) {
+        const auto& previous = levels.back();
+        auto level = create_level(std::max(previous.width / 2, 1u), std::max(previous.height / 2, 1u));
+
+        // Box filter over 2x2 texels of linear colors, the last row or column of odd sizes is dropped
+        for (uint32_t y = 0; y < level.height; ++y) {
+            const auto y0 = std::min(2 * y, previous.height - 1);
+            const auto y1 = std::min(2 * y + 1, previous.height - 1);
+
+            for (uint32_t x = 0; x < level.width; ++x) {
+                const auto x0 = std::min(2 * x, previous.width - 1);
+                const auto x1 = std::min(2 * x + 1, previous.width - 1);
+
+                const auto sum = previous.texels[previous.index(x0, y0)] + previous.texels[previous.index(x1, y0)] +
+                                 previous.texels[previous.index(x0, y1)] + previous.texels[previous.index(x1, y1)];
+                level.texels[level.index(x, y)] = sum * 0.25f;
+            }
+        }
+
+        levels.push_back(std::move(level));
+    }
+}
+
+Texture::Level Texture::create_level(uint32_t width, uint32_t height) {
+    const auto num_tiles_x = (width + TILE_SIZE - 1) / TILE_SIZE;
+    const auto num_tiles_y = (height + TILE_SIZE - 1) / TILE_SIZE;
+
+    return {
+        .width = width,
+        .height = height,
+        .num_tiles_x = num_tiles_x,
+        .texels = std::vector<glm::vec3>(static_cast<std::size_t>(num_tiles_x) * num_tiles_y * TILE_SIZE * TILE_SIZE),
+    };
+}
+
+real Texture::level_of_detail(real footprint) const {
+    const auto texels = footprint * static_cast<real>(std::max(m_width, m_height));
+    return texels > 1 ? std::log2(texels) : real(0);
+}
+
+vec3 Texture::bilinear(const Level& level, real u, real v) {
+    // Texel centers are at half integer coordinates, lookups outside the image are clamped to its border
+    const auto x =
+        std::clamp(u * static_cast<real>(level.width) - real(0.5), real(0), static_cast<real>(level.width - 1));
+    const auto y =
+        std::clamp(v * static_cast<real>(level.height) - real(0.5), real(0), static_cast<real>(level.height - 1));
+
+    const auto x0 = static_cast<uint32_t>(x);
+    const auto y0 = static_cast<uint32_t>(y);
+    const auto x1 = std::min(x0 + 1, level.width - 1);
+    const auto y1 = std::min(y0 + 1, level.height - 1);
+
+    const auto fx = x - static_cast<real>(x0);
+    const auto fy = y - static_cast<real>(y0);
+
+    const auto top = glm::mix(get_color_at(level, x0, y0), get_color_at(level, x1, y0), fx);
+    const auto bottom = glm::mix(get_color_at(level, x0, y1), get_color_at(level, x1, y1), fx);
+    return glm::mix(top, bottom, fy);
+}
+
+vec3 Texture::trilinear(const std::vector<Level>& levels, real u, real v, real lod) {
+    const auto first = static_cast<std::size_t>(lod);
+    const auto fraction = lod - static_cast<real>(first);
+
+    const auto color = bilinear(levels[first], u, v);
+    if (fraction == 0)
+        return color;
+
+    return glm::mix(color, bilinear(levels[first + 1], u, v), fraction);
+}
 
-    return {static_cast<double>(m_data[pos]) / 255.0,
-            static_cast<double>(m_data[pos + 1]) / 255.0,
-            static_cast<double>(m_data[pos + 2]) / 255.0};
+vec3 Texture::get_color_at(const Level& level, uint32_t u, uint32_t v) {
+    assert(u < level.width && v < level.height);
+    return vec3(level.texels[level.index(u, v)]);
 }
@@ -1,34 +1,130 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <filesystem>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 #include "vec.h"
 
+// Forward declarations
+class TextureCache;
+
+// 8 bits per channel sRGB image with its mip pyramid, built at load time. Lookups pick the level matching the
+// footprint of the ray on the surface, so distant surfaces read a few texels of a small level instead of scattered
+// texels of the full resolution image.
+//
+// Texels are decoded once to linear single precision colors and stored in square tiles, so the neighbours read by
+// filtering and by nearby rays share cache lines in both directions.
+//
+// Textures created by a TextureCache are only decoded when first sampled, and may be evicted and decoded again
+// later to stay under the memory budget of the cache.
 class Texture {
   public:
     enum class Filtering {
-        Nearest,
-        Bilinear,
-        Trilinear,
-        Anisotropic,
+        Nearest,     // Closest texel of the full resolution image
+        Bilinear,    // Bilinear interpolation in the level closest to the footprint
+        Trilinear,   // Bilinear interpolation in the two levels around the footprint, blended
+        Anisotropic, // Trilinear samples spread along the major axis of elongated footprints
+    };
+
+    // Region of the texture covered by a ray, an ellipse in texture coordinates. Isotropic filters average over its
+    // largest extent, Anisotropic takes samples as wide as width along major_axis.
+    struct Footprint {
+        real width = 0;     // Extent across the ellipse
+        vec2 major_axis{0}; // Extent along the longest direction of the ellipse, 0 if the ellipse is round
     };
 
     Texture(const std::filesystem::path& path, Filtering filtering);
+
+    // Texture from sRGB texels with 3 or 4 channels, stored row by row. Alpha is ignored.
+    Texture(uint32_t width, uint32_t height, uint32_t channels, std::vector<std::byte> data, Filtering filtering);
+
     ~Texture() = default;
 
-    [[nodiscard]] vec3 sample(double u, double v) const;
+    // Linear color at (u, v), filtered over footprint, the width of the region to average in texture coordinates
+    [[nodiscard]] vec3 sample(real u, real v, real footprint = 0) const;
+    [[nodiscard]] vec3 sample(real u, real v, const Footprint& footprint) const;
 
     [[nodiscard]] uint32_t width() const { return m_width; }
     [[nodiscard]] uint32_t height() const { return m_height; }
     [[nodiscard]] uint32_t channels() const { return m_channels; }
+    [[nodiscard]] uint32_t num_levels() const;
+
+    // Whether the texels are currently decoded in memory
+    [[nodiscard]] bool is_resident() const { return m_pyramid.load(std::memory_order_acquire) != nullptr; }
 
   private:
+    friend class TextureCache;
+
+    // 4x4 texels of 12 bytes, three cache lines
+    static constexpr uint32_t TILE_SIZE = 4;
+
+    // Most samples taken by Anisotropic filtering, longer footprints are blurred across their major axis instead
+    static constexpr uint32_t MAX_ANISOTROPY = 16;
+
+    struct Level {
+        uint32_t width, height;
+        uint32_t num_tiles_x; // Tiles in a row, the last tiles of a row or column may be partially used
+        std::vector<glm::vec3> texels;
+
+        [[nodiscard]] std::size_t index(uint32_t x, uint32_t y) const;
+    };
+
+    // Level 0 is the image, every other one halves the previous one down to 1x1
+    struct Pyramid {
+        std::vector<Level> levels;
+
+        [[nodiscard]] std::size_t memory_size() const;
+    };
+
     uint32_t m_width, m_height, m_channels;
     Filtering m_filtering;
 
-    std::vector<std::byte> m_data;
+    // Texels of textures created directly
+    std::unique_ptr<const Pyramid> m_image;
+
+    // Texels sampled: m_image, or the ones decoded by the cache of the texture, which owns them. nullptr while the
+    // cache has not decoded them yet or has evicted them. Samples pin them while they read them, so eviction never
+    // frees texels in use, see TextureCache::Reader.
+    mutable std::atomic<const Pyramid*> m_pyramid = nullptr;
+
+    // Only for textures of a cache
+    std::filesystem::path m_path;
+    TextureCache* m_cache = nullptr;
+    mutable std::mutex m_load_mutex;           // Serializes the decoding of this texture
+    mutable std::atomic<bool> m_failed{};       // The image could not be decoded, it is sampled as black from then on
+    mutable std::atomic<uint64_t> m_last_use{}; // Clock of the cache at the last sample, see TextureCache::touch
+
+    // Texture of the image at path, decoded on first use, see TextureCache::get
+    Texture(const std::filesystem::path& path,
+            uint32_t width,
+            uint32_t height,
+            uint32_t channels,
+            Filtering filtering,
+            TextureCache& cache);
+
+    // Decoded texels of a texture of a cache, loading them through the cache if needed. They are stored in pinned,
+    // the pin of the calling thread, and stay valid until it is cleared. nullptr if they could not be read, which
+    // is only attempted once.
+    [[nodiscard]] const Pyramid* pin(std::atomic<const Pyramid*>& pinned) const;
+
+    [[nodiscard]] vec3 filter(const Pyramid& pyramid, real u, real v, const Footprint& footprint) const;
+
+    [[nodiscard]] static std::unique_ptr<const Pyramid> read(const std::filesystem::path& path);
+    [[nodiscard]] static std::unique_ptr<const Pyramid> decode(uint32_t width,
+                                                               uint32_t height,
+                                                               uint32_t channels,
+                                                               const std::byte* data);
+    [[nodiscard]] static Level create_level(uint32_t width, uint32_t height);
+    static void build_levels(Pyramid& pyramid);
+
+    // Level whose texels are as wide as footprint, fractional and not clamped
+    [[nodiscard]] real level_of_detail(real footprint) const;
 
-    [[nodiscard]] vec3 get_color_at(uint32_t u, uint32_t v) const;
+    [[nodiscard]] static vec3 bilinear(const Level& level, real u, real v);
+    [[nodiscard]] static vec3 trilinear(const std::vector<Level>& levels, real u, real v, real lod);
+    [[nodiscard]] static vec3 get_color_at(const Level& level, uint32_t u, uint32_t v);
 };
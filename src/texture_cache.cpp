@@ -0,0 +1,124 @@
+#include "texture_cache.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include <stb_image.h>
+
+static uint64_t next_cache_id() {
+    static std::atomic<uint64_t> id = 0;
+    return id.fetch_add(1, std::memory_order_relaxed);
+}
+
+TextureCache::TextureCache(Description description) : m_description(description), m_id(next_cache_id()) {}
+
+std::shared_ptr<Texture> TextureCache::get(const std::filesystem::path& path, Texture::Filtering filtering) {
+    std::error_code error;
+    const auto canonical = std::filesystem::weakly_canonical(path, error);
+    if (error) {
+        std::cout << "Could not read texture in path: " << path << "\n";
+        return nullptr;
+    }
+
+    std::lock_guard lock(m_mutex);
+
+    auto& texture = m_textures[{canonical.string(), filtering}];
+    if (texture != nullptr)
+        return texture;
+
+    int32_t width, height, channels;
+    if (!stbi_info(canonical.c_str(), &width, &height, &channels) || (channels != 3 && channels != 4)) {
+        std::cout << "Could not read texture in path: " << path << "\n";
+        m_textures.erase({canonical.string(), filtering});
+        return nullptr;
+    }
+
+    // Constructor is private, std::make_shared cannot call it
+    texture.reset(new Texture(canonical,
+                              static_cast<uint32_t>(width),
+                              static_cast<uint32_t>(height),
+                              static_cast<uint32_t>(channels),
+                              filtering,
+                              *this));
+    return texture;
+}
+
+std::size_t TextureCache::resident_size() const {
+    std::lock_guard lock(m_mutex);
+    return m_resident_size;
+}
+
+uint32_t TextureCache::num_textures() const {
+    std::lock_guard lock(m_mutex);
+    return static_cast<uint32_t>(m_textures.size());
+}
+
+void TextureCache::add_resident(const Texture& texture, std::unique_ptr<const Texture::Pyramid> pyramid) {
+    std::lock_guard lock(m_mutex);
+
+    const auto size = pyramid->memory_size();
+    texture.m_last_use.store(++m_clock, std::memory_order_relaxed);
+    texture.m_pyramid.store(pyramid.get(), std::memory_order_release);
+    m_resident.push_back({.texture = &texture, .pyramid = std::move(pyramid), .size = size});
+    m_resident_size += size;
+
+    while (m_resident_size > m_description.budget && m_resident.size() > 1) {
+        const auto oldest = std::min_element(m_resident.begin(), m_resident.end(), [](const auto& a, const auto& b) {
+            return a.texture->m_last_use.load(std::memory_order_relaxed) <
+                   b.texture->m_last_use.load(std::memory_order_relaxed);
+        });
+
+        // Unpublished before the pins are checked, samples pinning the texels from now on load them again
+        oldest->texture->m_pyramid.store(nullptr, std::memory_order_seq_cst);
+        m_retired.push_back(std::move(oldest->pyramid));
+        m_resident_size -= oldest->size;
+        m_resident.erase(oldest);
+    }
+
+    // Texels still pinned by a sample are kept until a later decode finds them released
+    std::erase_if(m_retired, [this](const auto& retired) {
+        return std::none_of(m_readers.begin(), m_readers.end(), [&retired](const auto& reader) {
+            return reader->pyramid.load(std::memory_order_seq_cst) == retired.get();
+        });
+    });
+}
+
+TextureCache::Reader& TextureCache::reader() const {
+    // Readers of the calling thread in every cache it sampled, given back when the thread exits
+    struct ThreadReaders {
+        std::vector<std::pair<uint64_t, std::shared_ptr<Reader>>> readers;
+
+        ~ThreadReaders() {
+            for (const auto& [id, reader] : readers)
+                reader->in_use.store(false, std::memory_order_release);
+        }
+    };
+    thread_local ThreadReaders thread_readers;
+
+    auto& readers = thread_readers.readers;
+    const auto found = std::find_if(readers.begin(), readers.end(), [this](const auto& r) { return r.first == m_id; });
+    if (found != readers.end())
+        return *found->second;
+
+    std::lock_guard lock(m_mutex);
+
+    // Readers of exited threads are not pinning anything, they are reused
+    auto free = std::find_if(m_readers.begin(), m_readers.end(), [](const auto& reader) {
+        return !reader->in_use.load(std::memory_order_acquire);
+    });
+
+    if (free != m_readers.end()) {
+        (*free)->in_use.store(true, std::memory_order_relaxed);
+        readers.emplace_back(m_id, *free);
+    } else {
+        readers.emplace_back(m_id, m_readers.emplace_back(std::make_shared<Reader>()));
+    }
+
+    return *readers.back().second;
+}
+
+void TextureCache::touch(const Texture& texture) const {
+    const auto now = m_clock.load(std::memory_order_relaxed);
+    if (texture.m_last_use.load(std::memory_order_relaxed) != now)
+        texture.m_last_use.store(now, std::memory_order_relaxed);
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "texture.h"
+
+// Owner of the textures of a scene, loaded from image files. Textures are shared by every material using the same
+// image, only decoded when first sampled, and the least recently used ones are evicted whenever the decoded texels
+// go over the memory budget. Evicted textures are decoded again on their next sample.
+//
+// Resident textures are sampled without locking, the cache is only locked when a texture is decoded. Evicted texels
+// still read by a sample are freed by a later decode instead. The cache must outlive the textures it returns.
+class TextureCache {
+  public:
+    struct Description {
+        std::size_t budget = std::size_t(2) << 30; // Bytes of decoded texels, a single larger texture is still kept
+    };
+
+    explicit TextureCache(Description description);
+    ~TextureCache() = default;
+
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+
+    // Texture of the image in path, the same one for every call with the same file and filtering. Only the header of
+    // the image is read. Returns nullptr if it cannot be read.
+    [[nodiscard]] std::shared_ptr<Texture> get(const std::filesystem::path& path, Texture::Filtering filtering);
+
+    // Bytes of the decoded texels of the resident textures
+    [[nodiscard]] std::size_t resident_size() const;
+    [[nodiscard]] uint32_t num_textures() const;
+
+    // Number of times textures have been decoded, including the ones decoded again after being evicted
+    [[nodiscard]] uint64_t num_decoded() const { return m_clock.load(std::memory_order_relaxed); }
+
+  private:
+    friend class Texture;
+
+    struct Resident {
+        const Texture* texture;
+        std::unique_ptr<const Texture::Pyramid> pyramid;
+        std::size_t size;
+    };
+
+    // Texels pinned by the sample a thread is taking, see Texture::pin. Every thread sampling textures of the cache
+    // has its own, in its own cache line, and gives it back when it exits.
+    struct alignas(64) Reader {
+        std::atomic<const Texture::Pyramid*> pyramid = nullptr;
+        std::atomic<bool> in_use = true;
+    };
+
+    Description m_description;
+    uint64_t m_id; // Unique among all the caches, including destroyed ones whose address may be reused
+
+    mutable std::mutex m_mutex;
+    std::map<std::pair<std::string, Texture::Filtering>, std::shared_ptr<Texture>> m_textures;
+    std::vector<Resident> m_resident;
+    std::size_t m_resident_size = 0;
+    std::vector<std::unique_ptr<const Texture::Pyramid>> m_retired; // Evicted while pinned
+    mutable std::vector<std::shared_ptr<Reader>> m_readers;
+
+    // Advances on every decode. Samples stamp their texture with it, so the oldest stamp is the least recently used,
+    // at the granularity of the decodes: textures used since the same decode are equally recent.
+    std::atomic<uint64_t> m_clock = 0;
+
+    // Publishes the texels just decoded by texture, and evicts others until the budget is met
+    void add_resident(const Texture& texture, std::unique_ptr<const Texture::Pyramid> pyramid);
+
+    // Reader of the calling thread, registered on its first sample
+    [[nodiscard]] Reader& reader() const;
+
+    // Marks texture as used now. Only writes when the stamp changes, so resident textures sampled by many threads
+    // are mostly read.
+    void touch(const Texture& texture) const;
+};
@@ -0,0 +1,134 @@
+#include "tile_scheduler.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+TileScheduler::TileScheduler(uint32_t width, uint32_t height, uint32_t tile_size, Order order, uint32_t num_threads)
+      : m_tile_size(std::max(tile_size, 1u)), m_queues(std::max(num_threads, 1u)) {
+    const auto tiles_x = (width + m_tile_size - 1) / m_tile_size;
+    const auto tiles_y = (height + m_tile_size - 1) / m_tile_size;
+
+    // Side of the power of two grid covering all tiles, needed by the Hilbert curve
+    const auto grid_size = std::bit_ceil(std::max(std::max(tiles_x, tiles_y), 1u));
+
+    std::vector<std::pair<uint32_t, Tile>> keyed_tiles;
+    keyed_tiles.reserve(tiles_x * tiles_y);
+
+    for (uint32_t ty = 0; ty < tiles_y; ++ty) {
+        for (uint32_t tx = 0; tx < tiles_x; ++tx) {
+            const auto tile = Tile{
+                .index = 0,
+                .row = ty * m_tile_size,
+                .col = tx * m_tile_size,
+                .height = std::min(m_tile_size, height - ty * m_tile_size),
+                .width = std::min(m_tile_size, width - tx * m_tile_size),
+            };
+
+            uint32_t key = ty * tiles_x + tx;
+            if (order == Order::Morton)
+                key = morton_code(tx, ty);
+            else if (order == Order::Hilbert)
+                key = hilbert_code(grid_size, tx, ty);
+
+            keyed_tiles.emplace_back(key, tile);
+        }
+    }
+
+    std::sort(keyed_tiles.begin(), keyed_tiles.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    m_tiles.reserve(keyed_tiles.size());
+    for (const auto& [key, tile] : keyed_tiles) {
+        m_tiles.push_back(tile);
+        m_tiles.back().index = static_cast<uint32_t>(m_tiles.size() - 1);
+    }
+
+    // Give every thread a contiguous range of the curve
+    const auto num_tiles = static_cast<uint64_t>(m_tiles.size());
+    const auto num_queues = static_cast<uint64_t>(m_queues.size());
+
+    for (uint64_t i = 0; i < num_queues; ++i) {
+        const auto begin = num_tiles * i / num_queues;
+        const auto end = num_tiles * (i + 1) / num_queues;
+        m_queues[i].range.store((end << 32u) | begin, std::memory_order_relaxed);
+    }
+}
+
+std::optional<TileScheduler::Tile> TileScheduler::next(uint32_t thread) {
+    const auto num_queues = static_cast<uint32_t>(m_queues.size());
+    assert(thread < num_queues);
+
+    if (const auto index = pop_front(m_queues[thread]))
+        return m_tiles[*index];
+
+    // Own range exhausted, steal from the back of the other ranges
+    for (uint32_t i = 1; i < num_queues; ++i) {
+        if (const auto index = pop_back(m_queues[(thread + i) % num_queues]))
+            return m_tiles[*index];
+    }
+
+    return std::nullopt;
+}
+
+std::optional<uint32_t> TileScheduler::pop_front(Queue& queue) {
+    auto range = queue.range.load(std::memory_order_relaxed);
+
+    while (true) {
+        const auto begin = static_cast<uint32_t>(range);
+        const auto end = static_cast<uint32_t>(range >> 32u);
+        if (begin >= end)
+            return std::nullopt;
+
+        const auto new_range = (static_cast<uint64_t>(end) << 32u) | (begin + 1);
+        if (queue.range.compare_exchange_weak(range, new_range, std::memory_order_relaxed))
+            return begin;
+    }
+}
+
+std::optional<uint32_t> TileScheduler::pop_back(Queue& queue) {
+    auto range = queue.range.load(std::memory_order_relaxed);
+
+    while (true) {
+        const auto begin = static_cast<uint32_t>(range);
+        const auto end = static_cast<uint32_t>(range >> 32u);
+        if (begin >= end)
+            return std::nullopt;
+
+        const auto new_range = (static_cast<uint64_t>(end - 1) << 32u) | begin;
+        if (queue.range.compare_exchange_weak(range, new_range, std::memory_order_relaxed))
+            return end - 1;
+    }
+}
+
+uint32_t TileScheduler::morton_code(uint32_t x, uint32_t y) {
+    const auto spread = [](uint32_t v) {
+        v &= 0x0000ffff;
+        v = (v | (v << 8u)) & 0x00ff00ff;
+        v = (v | (v << 4u)) & 0x0f0f0f0f;
+        v = (v | (v << 2u)) & 0x33333333;
+        v = (v | (v << 1u)) & 0x55555555;
+        return v;
+    };
+
+    return spread(x) | (spread(y) << 1u);
+}
+
+uint32_t TileScheduler::hilbert_code(uint32_t n, uint32_t x, uint32_t y) {
+    // https://en.wikipedia.org/wiki/Hilbert_curve#Applications_and_mapping_algorithms
+    uint32_t d = 0;
+    for (auto s = n / 2; s > 0; s /= 2) {
+        const uint32_t rx = (x & s) > 0 ? 1 : 0;
+        const uint32_t ry = (y & s) > 0 ? 1 : 0;
+        d += s * s * ((3 * rx) ^ ry);
+
+        // Rotate the quadrant
+        if (ry == 0) {
+            if (rx == 1) {
+                x = n - 1 - x;
+                y = n - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return d;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+// Splits the image in square tiles, sorts them along a space filling curve and distributes them between
+// threads. Every thread owns a contiguous range of the curve, and steals tiles from the end of other
+// threads' ranges once its own range is exhausted.
+class TileScheduler {
+  public:
+    enum class Order {
+        Scanline,
+        Morton,
+        Hilbert,
+    };
+
+    struct Tile {
+        uint32_t index; // Position of the tile in the curve order
+        uint32_t row, col;
+        uint32_t height, width;
+    };
+
+    TileScheduler(uint32_t width, uint32_t height, uint32_t tile_size, Order order, uint32_t num_threads);
+
+    // Returns the next tile to render by thread, or std::nullopt when all tiles have been handed out
+    [[nodiscard]] std::optional<Tile> next(uint32_t thread);
+
+    [[nodiscard]] const std::vector<Tile>& tiles() const { return m_tiles; }
+    [[nodiscard]] uint32_t tile_size() const { return m_tile_size; }
+
+  private:
+    uint32_t m_tile_size;
+    std::vector<Tile> m_tiles;
+
+    // Range [begin, end) of tiles still owned by a thread, packed as (end << 32 | begin) so both ends
+    // can be updated with a single compare and swap. Padded to avoid false sharing between threads.
+    struct alignas(64) Queue {
+        std::atomic<uint64_t> range;
+    };
+    std::vector<Queue> m_queues;
+
+    [[nodiscard]] std::optional<uint32_t> pop_front(Queue& queue);
+    [[nodiscard]] std::optional<uint32_t> pop_back(Queue& queue);
+
+    [[nodiscard]] static uint32_t morton_code(uint32_t x, uint32_t y);
+    [[nodiscard]] static uint32_t hilbert_code(uint32_t n, uint32_t x, uint32_t y);
+};
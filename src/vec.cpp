@@ -1,41 +1,52 @@
 #include "vec.h"
 
-#include "rand.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
 
-vec3 vec3_random() {
-    return {random_double(), random_double(), random_double()};
+#include "sampler.h"
+
+vec3 vec3_random(Sampler& sampler) {
+    const auto x = sampler.next_real();
+    const auto y = sampler.next_real();
+    const auto z = sampler.next_real();
+    return {x, y, z};
 }
 
-vec3 vec3_random(double min, double max) {
-    return {random_double(min, max), random_double(min, max), random_double(min, max)};
+vec3 vec3_random(Sampler& sampler, real min, real max) {
+    const auto x = sampler.next_real(min, max);
+    const auto y = sampler.next_real(min, max);
+    const auto z = sampler.next_real(min, max);
+    return {x, y, z};
 }
 
-vec3 vec3_random_in_unit_sphere() {
+vec3 vec3_random_in_unit_sphere(Sampler& sampler) {
     while (true) {
-        auto p = vec3_random(-1.0, 1.0);
+        auto p = vec3_random(sampler, -1.0, 1.0);
         const auto length_squared = glm::length(p) * glm::length(p);
         if (length_squared < 1.0)
             return p;
     }
 }
 
-vec3 vec3_random_unit() {
-    return glm::normalize(vec3_random_in_unit_sphere());
+vec3 vec3_random_unit(Sampler& sampler) {
+    return glm::normalize(vec3_random_in_unit_sphere(sampler));
 }
 
-vec3 random_on_hemisphere(const vec3& normal) {
-    vec3 on_unit_sphere = vec3_random_unit();
+vec3 random_on_hemisphere(Sampler& sampler, const vec3& normal) {
+    vec3 on_unit_sphere = vec3_random_unit(sampler);
     if (glm::dot(on_unit_sphere, normal) > 0.0) // In the same hemisphere as the normal
         return on_unit_sphere;
     else
         return -on_unit_sphere;
 }
 
-vec3 random_cosine_direction() {
-    const auto r1 = random_double();
-    const auto r2 = random_double();
+vec3 random_cosine_direction(Sampler& sampler) {
+    const auto r1 = sampler.next_real();
+    const auto r2 = sampler.next_real();
 
-    const auto phi = 2 * M_PI * r1;
+    const auto phi = 2 * glm::pi<real>() * r1;
     const auto x = glm::cos(phi) * glm::sqrt(r2);
     const auto y = glm::sin(phi) * glm::sqrt(r2);
     const auto z = glm::sqrt(1 - r2);
@@ -44,6 +55,111 @@ vec3 random_cosine_direction() {
 }
 
 bool vec3_near_zero(const vec3& v) {
-    auto s = 1e-8;
+    // 1e-8 is below the rounding error of unit length vectors in single precision, a few ulps of 1 are used instead
+    constexpr auto s = std::max(real(1e-8), 8 * std::numeric_limits<real>::epsilon());
     return (fabs(v.x) < s) && (fabs(v.y) < s) && (fabs(v.z) < s);
 }
+
+static real sign_not_zero(real value) {
+    return value >= 0 ? real(1) : real(-1);
+}
+
+static uint32_t to_snorm16(real value) {
+    const auto snorm = static_cast<int16_t>(std::lround(glm::clamp(value, real(-1), real(1)) * 32767));
+    return static_cast<uint16_t>(snorm);
+}
+
+static real from_snorm16(uint32_t bits) {
+    return static_cast<real>(static_cast<int16_t>(static_cast<uint16_t>(bits))) / 32767;
+}
+
+uint32_t pack_octahedral(const vec3& unit) {
+    // Project onto the octahedron |x| + |y| + |z| = 1, and fold the lower half over the diagonals
+    const auto scale = real(1) / (glm::abs(unit.x) + glm::abs(unit.y) + glm::abs(unit.z));
+    auto x = unit.x * scale;
+    auto y = unit.y * scale;
+
+    if (unit.z < 0) {
+        const auto folded_x = (1 - glm::abs(y)) * sign_not_zero(x);
+        const auto folded_y = (1 - glm::abs(x)) * sign_not_zero(y);
+        x = folded_x;
+        y = folded_y;
+    }
+
+    return to_snorm16(x) | to_snorm16(y) << 16;
+}
+
+vec3 unpack_octahedral(uint32_t packed) {
+    auto x = from_snorm16(packed);
+    auto y = from_snorm16(packed >> 16);
+    const auto z = 1 - glm::abs(x) - glm::abs(y);
+
+    // Unfold the lower half
+    const auto t = glm::max(-z, real(0));
+    x += x >= 0 ? -t : t;
+    y += y >= 0 ? -t : t;
+
+    return glm::normalize(vec3(x, y, z));
+}
+
+static uint32_t float_to_half(float value) {
+    const auto bits = std::bit_cast<uint32_t>(value);
+    const auto sign = (bits >> 16) & 0x8000u;
+    const auto float_exponent = (bits >> 23) & 0xffu;
+    auto mantissa = bits & 0x7fffffu;
+
+    // Infinity and NaN
+    if (float_exponent == 0xffu)
+        return sign | 0x7c00u | (mantissa != 0 ? 0x200u : 0u);
+
+    const auto exponent = static_cast<int32_t>(float_exponent) - 127 + 15;
+    if (exponent >= 31)
+        return sign | 0x7c00u;
+
+    // Subnormal halves, or zero when even the largest rounding cannot reach the smallest one
+    if (exponent <= 0) {
+        if (exponent < -10)
+            return sign;
+
+        mantissa |= 0x800000u;
+        const auto shift = static_cast<uint32_t>(14 - exponent);
+        const auto remainder = mantissa & ((1u << shift) - 1);
+        const auto halfway = 1u << (shift - 1);
+
+        auto half = mantissa >> shift;
+        if (remainder > halfway || (remainder == halfway && (half & 1u) != 0))
+            half++;
+        return sign | half;
+    }
+
+    // Rounding may carry into the exponent, which is still the correctly rounded result
+    auto half = sign | static_cast<uint32_t>(exponent) << 10 | mantissa >> 13;
+    const auto remainder = mantissa & 0x1fffu;
+    if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u) != 0))
+        half++;
+    return half;
+}
+
+static float half_to_float(uint32_t half) {
+    const auto sign = (half & 0x8000u) << 16;
+    const auto exponent = (half >> 10) & 0x1fu;
+    const auto mantissa = half & 0x3ffu;
+
+    if (exponent == 0) {
+        const auto magnitude = std::ldexp(static_cast<float>(mantissa), -24);
+        return sign != 0 ? -magnitude : magnitude;
+    }
+
+    if (exponent == 31)
+        return std::bit_cast<float>(sign | 0x7f800000u | mantissa << 13);
+
+    return std::bit_cast<float>(sign | (exponent + 112) << 23 | mantissa << 13);
+}
+
+uint32_t pack_half2(const vec2& v) {
+    return float_to_half(static_cast<float>(v.x)) | float_to_half(static_cast<float>(v.y)) << 16;
+}
+
+vec2 unpack_half2(uint32_t packed) {
+    return {half_to_float(packed & 0xffffu), half_to_float(packed >> 16)};
+}
@@ -5,17 +5,44 @@
 
 using uvec3 = glm::uvec3;
 
+// Scalar type of all the geometry and shading math, selected with the RAY_TRACER_SINGLE_PRECISION option
+#ifdef RAY_TRACER_SINGLE_PRECISION
+using real = float;
+
+using vec2 = glm::vec2;
+using vec3 = glm::vec3;
+using vec4 = glm::vec4;
+using mat3 = glm::mat3;
+using mat4 = glm::mat4;
+#else
+using real = double;
+
 using vec2 = glm::dvec2;
 using vec3 = glm::dvec3;
 using vec4 = glm::dvec4;
+using mat3 = glm::dmat3;
+using mat4 = glm::dmat4;
+#endif
+
+// Forward declarations
+class Sampler;
 
-vec3 vec3_random();
-vec3 vec3_random(double min, double max);
+vec3 vec3_random(Sampler& sampler);
+vec3 vec3_random(Sampler& sampler, real min, real max);
 
-vec3 vec3_random_in_unit_sphere();
-vec3 vec3_random_unit();
+vec3 vec3_random_in_unit_sphere(Sampler& sampler);
+vec3 vec3_random_unit(Sampler& sampler);
 
-vec3 random_on_hemisphere(const vec3& normal);
-vec3 random_cosine_direction();
+vec3 random_on_hemisphere(Sampler& sampler, const vec3& normal);
+vec3 random_cosine_direction(Sampler& sampler);
 
 bool vec3_near_zero(const vec3& v);
+
+// Compact vertex attributes, 32 bits each. Unit vectors are mapped onto an octahedron unfolded into a square and
+// stored as two 16 bit signed normalized values, with an angular error of a few thousandths of a degree. Pairs of
+// floats are stored as half precision, rounded to nearest.
+uint32_t pack_octahedral(const vec3& unit);
+vec3 unpack_octahedral(uint32_t packed);
+
+uint32_t pack_half2(const vec2& v);
+vec2 unpack_half2(uint32_t packed);
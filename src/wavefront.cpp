@@ -0,0 +1,195 @@
+#include "wavefront.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "ray.h"
+#include "interval.h"
+#include "material.h"
+
+template <typename F>
+static double time_ms(F&& function) {
+    const auto start = std::chrono::high_resolution_clock::now();
+    function();
+    const auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+WavefrontIntegrator::Statistics& WavefrontIntegrator::Statistics::operator+=(const Statistics& other) {
+    num_paths += other.num_paths;
+    num_extended += other.num_extended;
+    num_shaded += other.num_shaded;
+    num_connected += other.num_connected;
+    extend_ms += other.extend_ms;
+    sort_ms += other.sort_ms;
+    shade_ms += other.shade_ms;
+    connect_ms += other.connect_ms;
+    compact_ms += other.compact_ms;
+    return *this;
+}
+
+WavefrontIntegrator::WavefrontIntegrator(uint32_t max_depth, uint32_t russian_roulette_depth)
+      : m_max_depth(max_depth), m_russian_roulette(russian_roulette_depth) {}
+
+uint32_t WavefrontIntegrator::add_path(const Ray& ray, const Sampler& sampler) {
+    const auto path = size();
+
+    m_origin.push_back(ray.origin());
+    m_direction.push_back(ray.direction());
+    m_cone.push_back(ray.cone());
+    m_throughput.emplace_back(1.0);
+    m_radiance.emplace_back(0.0);
+    m_sampler.push_back(sampler);
+    m_intersection.emplace_back();
+    m_hit.emplace_back();
+    m_scatter_point.emplace_back(0.0);
+    m_scatter_pdf.push_back(0);
+    m_alive.push_back(1);
+
+    m_statistics.num_paths++;
+
+    return path;
+}
+
+void WavefrontIntegrator::trace(const IHittable& scene, const LightList& lights) {
+    m_active.resize(size());
+    for (uint32_t path = 0; path < size(); ++path)
+        m_active[path] = path;
+
+    for (uint32_t depth = 0; depth < m_max_depth && !m_active.empty(); ++depth) {
+        m_statistics.extend_ms += time_ms([&]() { extend(scene); });
+        m_statistics.sort_ms += time_ms([&]() { sort(); });
+        m_statistics.shade_ms += time_ms([&]() { shade(depth, lights); });
+        m_statistics.connect_ms += time_ms([&]() { connect(scene, lights); });
+        m_statistics.compact_ms += time_ms([&]() { compact(); });
+    }
+}
+
+void WavefrontIntegrator::clear() {
+    m_origin.clear();
+    m_direction.clear();
+    m_cone.clear();
+    m_throughput.clear();
+    m_radiance.clear();
+    m_sampler.clear();
+    m_intersection.clear();
+    m_hit.clear();
+    m_scatter_point.clear();
+    m_scatter_pdf.clear();
+    m_alive.clear();
+    m_active.clear();
+    m_shading.clear();
+    m_connections.clear();
+    m_connection_throughput.clear();
+}
+
+void WavefrontIntegrator::extend(const IHittable& scene) {
+    m_shading.clear();
+
+    for (const auto path : m_active) {
+        const auto ray = Ray(m_origin[path], m_direction[path], m_cone[path]);
+
+        auto& intersection = m_intersection[path];
+        intersection = scene.intersect(ray, interval(RAY_T_MIN, interval::infinity));
+
+        // Paths escaping the scene terminate, the sky does not emit
+        if (!intersection) {
+            m_alive[path] = 0;
+            continue;
+        }
+
+        const auto& hit = m_hit[path] = scene.compute_interaction(ray, *intersection);
+        m_shading.emplace_back(reinterpret_cast<uintptr_t>(hit->material), path);
+    }
+
+    m_statistics.num_extended += m_active.size();
+}
+
+void WavefrontIntegrator::sort() {
+    // Paths of the same material are shaded consecutively, and in increasing path order within a material
+    std::sort(m_shading.begin(), m_shading.end());
+}
+
+void WavefrontIntegrator::shade(uint32_t depth, const LightList& lights) {
+    m_connections.clear();
+    m_connection_throughput.clear();
+
+    for (const auto& [material_key, path] : m_shading) {
+        const auto& hit = *m_hit[path];
+        const auto& material = *hit.material;
+        const auto ray = Ray(m_origin[path], m_direction[path], m_cone[path]);
+
+        if (const auto emission = material.emitted(hit.uv.x, hit.uv.y)) {
+            const auto scatter_pdf = m_scatter_pdf[path];
+            const auto weight =
+                scatter_pdf > 0 ? lights.emission_weight(m_scatter_point[path], scatter_pdf, *m_intersection[path], hit)
+                                : real(1);
+            m_radiance[path] += m_throughput[path] * weight * *emission;
+        }
+
+        const auto material_hit = material.scatter(ray, hit, m_sampler[path]);
+        if (!material_hit) {
+            m_alive[path] = 0;
+            continue;
+        }
+
+        // No light sample at the last vertex, as in RayTracer::path_radiance
+        const auto is_last_vertex = depth + 1 == m_max_depth;
+        if (const auto connection = !is_last_vertex ? lights.connect(ray, hit, m_sampler[path]) : std::nullopt) {
+            m_connections.emplace_back(path, *connection);
+            m_connection_throughput.push_back(m_throughput[path]);
+        }
+
+        const auto scattering_prob = material.scattering_prob(ray, hit, material_hit->scatter);
+        m_throughput[path] *= material_hit->attenuation * scattering_prob / material_hit->pdf;
+
+        const auto evaluation = material.evaluate(ray, hit, glm::normalize(material_hit->scatter.direction()));
+        m_scatter_point[path] = hit.point;
+        m_scatter_pdf[path] = evaluation ? evaluation->pdf : real(0);
+
+        // Decided here rather than before the next extend, in the same sampler order as RayTracer::path_radiance
+        const auto next_depth = depth + 1;
+        if (next_depth < m_max_depth && !m_russian_roulette.survives(next_depth, m_throughput[path], m_sampler[path])) {
+            m_alive[path] = 0;
+            continue;
+        }
+
+        m_origin[path] = material_hit->scatter.origin();
+        m_direction[path] = material_hit->scatter.direction();
+        m_cone[path] = material_hit->scatter.cone();
+    }
+
+    m_statistics.num_shaded += m_shading.size();
+}
+
+void WavefrontIntegrator::connect(const IHittable& scene, const LightList& lights) {
+    for (std::size_t i = 0; i < m_connections.size(); ++i) {
+        const auto& [path, connection] = m_connections[i];
+        m_radiance[path] += m_connection_throughput[i] * lights.connection_radiance(connection, scene);
+    }
+
+    m_statistics.num_connected += m_connections.size();
+}
+
+void WavefrontIntegrator::compact() {
+    const auto end = std::remove_if(m_active.begin(), m_active.end(), [&](uint32_t path) { return !m_alive[path]; });
+    m_active.erase(end, m_active.end());
+}
+
+std::ostream& operator<<(std::ostream& os, const WavefrontIntegrator::Statistics& statistics) {
+    const auto total_ms = statistics.extend_ms + statistics.sort_ms + statistics.shade_ms + statistics.connect_ms +
+                          statistics.compact_ms;
+    const auto percentage = [total_ms](double ms) { return total_ms > 0.0 ? ms / total_ms * 100.0 : 0.0; };
+
+    os << "Wavefront information:\n";
+    os << "    Paths: " << statistics.num_paths << "\n";
+    os << "    Rays extended: " << statistics.num_extended << "\n";
+    os << "    Hits shaded: " << statistics.num_shaded << "\n";
+    os << "    Shadow rays: " << statistics.num_connected << "\n";
+    os << "    Extend: " << statistics.extend_ms << "ms (" << percentage(statistics.extend_ms) << "%)\n";
+    os << "    Sort: " << statistics.sort_ms << "ms (" << percentage(statistics.sort_ms) << "%)\n";
+    os << "    Shade: " << statistics.shade_ms << "ms (" << percentage(statistics.shade_ms) << "%)\n";
+    os << "    Connect: " << statistics.connect_ms << "ms (" << percentage(statistics.connect_ms) << "%)\n";
+    os << "    Compact: " << statistics.compact_ms << "ms (" << percentage(statistics.compact_ms) << "%)\n";
+    return os;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#include "vec.h"
+#include "ray.h"
+#include "sampler.h"
+#include "russian_roulette.h"
+#include "light_list.h"
+#include "hittable/hittable.h"
+
+// Breadth-first path tracer. Instead of following every path until it terminates, a large batch of path
+// states is advanced one bounce at a time through separate stages, each one a tight loop over the batch:
+//   - generate: camera rays are queued with add_path
+//   - extend:   every active path is intersected with the scene
+//   - sort:     hits are grouped by material, so shading runs the same code and data back to back
+//   - shade:    emission is accumulated, the material scatters the next ray and Russian roulette may end the path.
+//               Non specular hits also queue a shadow ray towards a light.
+//   - connect:  shadow rays are traced and the light they reach is accumulated
+//   - compact:  terminated paths are removed from the active queue
+class WavefrontIntegrator {
+  public:
+    struct Statistics {
+        uint64_t num_paths = 0;
+        uint64_t num_extended = 0;  // Rays intersected with the scene, over all bounces
+        uint64_t num_shaded = 0;    // Hits shaded, over all bounces
+        uint64_t num_connected = 0; // Shadow rays traced, over all bounces
+
+        double extend_ms = 0.0;
+        double sort_ms = 0.0;
+        double shade_ms = 0.0;
+        double connect_ms = 0.0;
+        double compact_ms = 0.0;
+
+        Statistics& operator+=(const Statistics& other);
+    };
+
+    WavefrontIntegrator(uint32_t max_depth, uint32_t russian_roulette_depth);
+
+    // Queues a new path starting at ray, and returns its index. The sampler is owned by the path from now on.
+    uint32_t add_path(const Ray& ray, const Sampler& sampler);
+
+    // Advances all the queued paths until every one of them has terminated. Next event estimation samples lights,
+    // an empty list disables it.
+    void trace(const IHittable& scene, const LightList& lights);
+
+    // Removes every path, keeping the allocated memory for the next batch
+    void clear();
+
+    [[nodiscard]] uint32_t size() const { return static_cast<uint32_t>(m_radiance.size()); }
+    [[nodiscard]] const vec3& radiance(uint32_t path) const { return m_radiance[path]; }
+    [[nodiscard]] const Statistics& statistics() const { return m_statistics; }
+
+  private:
+    uint32_t m_max_depth;
+    RussianRoulette m_russian_roulette;
+
+    // Path states, as structure of arrays indexed by path
+    std::vector<vec3> m_origin;
+    std::vector<vec3> m_direction;
+    std::vector<RayCone> m_cone;
+    std::vector<vec3> m_throughput;
+    std::vector<vec3> m_radiance;
+    std::vector<Sampler> m_sampler;
+    std::vector<std::optional<Intersection>> m_intersection;
+    std::vector<std::optional<HitRecord>> m_hit;
+    std::vector<vec3> m_scatter_point; // Vertex that scattered the current ray
+    std::vector<real> m_scatter_pdf;   // Density of the current ray, zero for camera rays and specular scattering
+    std::vector<uint8_t> m_alive;
+
+    // Queues of path indices
+    std::vector<uint32_t> m_active;                                        // Paths extended in the current bounce
+    std::vector<std::pair<uintptr_t, uint32_t>> m_shading;                // (material, path) of the paths that hit
+    std::vector<std::pair<uint32_t, LightList::Connection>> m_connections; // (path, shadow ray)
+    std::vector<vec3> m_connection_throughput;                            // Path throughput at each shadow ray
+
+    Statistics m_statistics;
+
+    void extend(const IHittable& scene);
+    void sort();
+    void shade(uint32_t depth, const LightList& lights);
+    void connect(const IHittable& scene, const LightList& lights);
+    void compact();
+};
+
+std::ostream& operator<<(std::ostream& os, const WavefrontIntegrator::Statistics& statistics);
@@ -0,0 +1,127 @@
+#include <catch2/catch_all.hpp>
+
+#include <filesystem>
+#include <fstream>
+
+#include "camera.h"
+#include "material.h"
+#include "ray_tracer.h"
+#include "image_dumper.h"
+#include "accumulation_buffer.h"
+
+#include "hittable/sphere.h"
+#include "hittable/hittable_list.h"
+
+static std::filesystem::path checkpoint_path(const char* name) {
+    return std::filesystem::temp_directory_path() / name;
+}
+
+TEST_CASE("Accumulation buffer checkpoints round trip", "[Accumulation_Buffer]") {
+    AccumulationBuffer buffer(3, 2, 42);
+    buffer.add(0, 1, vec3(0.25, 0.5, 1.5), 4);
+    buffer.add(1, 2, vec3(3.0), 7);
+    buffer.add(1, 2, vec3(1.0), 1);
+
+    const auto path = checkpoint_path("ray_tracer_round_trip.bin");
+    REQUIRE(buffer.save(path));
+
+    const auto loaded = AccumulationBuffer::load(path);
+    std::filesystem::remove(path);
+
+    REQUIRE(loaded.has_value());
+    REQUIRE(loaded->width() == 3);
+    REQUIRE(loaded->height() == 2);
+    REQUIRE(loaded->seed() == 42);
+
+    for (std::size_t row = 0; row < 2; ++row) {
+        for (std::size_t col = 0; col < 3; ++col) {
+            REQUIRE(loaded->sum(row, col) == buffer.sum(row, col));
+            REQUIRE(loaded->num_samples(row, col) == buffer.num_samples(row, col));
+        }
+    }
+
+    REQUIRE(loaded->sum(1, 2) == vec3(4.0));
+    REQUIRE(loaded->num_samples(1, 2) == 8);
+}
+
+TEST_CASE("Accumulation buffer rejects invalid checkpoints", "[Accumulation_Buffer]") {
+    REQUIRE(!AccumulationBuffer::load(checkpoint_path("ray_tracer_missing.bin")).has_value());
+
+    const auto path = checkpoint_path("ray_tracer_invalid.bin");
+
+    SECTION("Wrong magic") {
+        std::ofstream(path, std::ios::binary) << "not a checkpoint";
+        REQUIRE(!AccumulationBuffer::load(path).has_value());
+    }
+
+    SECTION("Truncated") {
+        REQUIRE(AccumulationBuffer(4, 4, 1).save(path));
+        std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+        REQUIRE(!AccumulationBuffer::load(path).has_value());
+    }
+
+    SECTION("Header larger than the file") {
+        REQUIRE(AccumulationBuffer(4, 4, 1).save(path));
+        {
+            // Width and height follow the magic and the version
+            std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+            file.seekp(8);
+            const uint32_t size = 0xffffffff;
+            file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+            file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        }
+        REQUIRE(!AccumulationBuffer::load(path).has_value());
+    }
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Resumed progressive renders match uninterrupted ones", "[Accumulation_Buffer]") {
+    HittableList scene;
+    scene.add_hittable<Sphere>(vec3(0.0, 0.0, -2.0), 0.5, scene.add_material<Lambertian>(vec3(0.5)));
+    scene.add_hittable<Sphere>(vec3(0.0, 3.0, -2.0), 1.0, scene.add_material<DiffuseEmissive>(vec3(1.0), 2.0));
+
+    const Camera camera({.width = 12, .height = 8, .vertical_fov = 60.0, .look_from = vec3(0.0)});
+    const auto path = checkpoint_path("ray_tracer_resume.bin");
+
+    RayTracer::Description description{
+        .samples_per_pixel = 12,
+        .max_depth = 4,
+        .seed = 9,
+        .samples_per_pass = 4,
+        .checkpoint_path = path,
+        .tile_size = 4,
+    };
+
+    AccumulationBuffer uninterrupted(camera.width(), camera.height(), description.seed);
+    PPMImageDumper expected(camera.width(), camera.height());
+    REQUIRE(RayTracer(description).render_progressive(camera, scene, uninterrupted, expected));
+
+    // Stop after the first pass, then resume from the checkpoint with the full sample count
+    AccumulationBuffer partial(camera.width(), camera.height(), description.seed);
+    PPMImageDumper image(camera.width(), camera.height());
+
+    auto first_pass = description;
+    first_pass.samples_per_pixel = 4;
+    REQUIRE(RayTracer(first_pass).render_progressive(camera, scene, partial, image));
+
+    auto resumed = AccumulationBuffer::load(path);
+    REQUIRE(resumed.has_value());
+    REQUIRE(resumed->num_samples(0, 0) == 4);
+    REQUIRE(RayTracer(description).render_progressive(camera, scene, *resumed, image));
+
+    std::filesystem::remove(path);
+
+    for (std::size_t row = 0; row < camera.height(); ++row) {
+        for (std::size_t col = 0; col < camera.width(); ++col) {
+            REQUIRE(resumed->num_samples(row, col) == 12);
+            REQUIRE(resumed->sum(row, col) == uninterrupted.sum(row, col));
+            REQUIRE(image.pixel(row, col) == expected.pixel(row, col));
+        }
+    }
+
+    // A buffer rendered with another seed can not be continued
+    auto other_seed = description;
+    other_seed.seed = 10;
+    REQUIRE(!RayTracer(other_seed).render_progressive(camera, scene, *resumed, image));
+}
@@ -0,0 +1,75 @@
+#include <catch2/catch_all.hpp>
+
+#include "sampler.h"
+#include "adaptive_sampling.h"
+
+// Takes every sample requested, returning the total number of samples taken
+template <typename F>
+static uint64_t run(AdaptiveSampling& adaptive, F&& sample) {
+    uint64_t total = 0;
+
+    while (true) {
+        const auto& round = adaptive.next_round();
+        if (round.empty())
+            break;
+
+        for (const auto& request : round) {
+            REQUIRE(request.first_sample == adaptive.num_samples(request.pixel));
+
+            for (uint32_t s = 0; s < request.num_samples; ++s)
+                adaptive.add_sample(request.pixel, sample(request.pixel));
+
+            total += request.num_samples;
+        }
+    }
+
+    return total;
+}
+
+TEST_CASE("Adaptive sampling stops pixels without noise", "[Adaptive_Sampling]") {
+    AdaptiveSampling adaptive({.min_samples = 4, .batch_size = 4, .threshold = 0.01}, 3, 1, 3 * 64);
+
+    const auto total = run(adaptive, [](uint32_t pixel) { return vec3(static_cast<real>(pixel)); });
+
+    // Black and constant pixels converge after the first round
+    REQUIRE(total == 3 * 4);
+    for (uint32_t pixel = 0; pixel < 3; ++pixel) {
+        REQUIRE(adaptive.num_samples(pixel) == 4);
+        REQUIRE(adaptive.relative_error(pixel) == 0);
+        REQUIRE(adaptive.sum(pixel) == vec3(4.0 * pixel));
+    }
+}
+
+TEST_CASE("Adaptive sampling spends the budget on noisy pixels", "[Adaptive_Sampling]") {
+    constexpr uint32_t size = 4;
+    constexpr uint64_t budget = size * size * 32;
+    AdaptiveSampling adaptive({.min_samples = 8, .batch_size = 8, .threshold = 0.001}, size, size, budget);
+
+    // Only the top left pixel is noisy
+    Sampler sampler(3);
+    const auto total = run(adaptive, [&](uint32_t pixel) {
+        return pixel == 0 ? vec3(sampler.next_real()) : vec3(0.5);
+    });
+
+    REQUIRE(total == budget);
+
+    // The noisy pixel and its neighbours share what is left after the first round
+    const auto noisy_samples = 8 + (budget - size * size * 8) / 4;
+    for (uint32_t pixel = 0; pixel < size * size; ++pixel) {
+        const auto neighbour = pixel % size <= 1 && pixel / size <= 1;
+        REQUIRE(adaptive.num_samples(pixel) == (neighbour ? noisy_samples : 8));
+        REQUIRE(adaptive.converged(pixel) == !neighbour);
+    }
+}
+
+TEST_CASE("Adaptive sampling estimates the standard error of the mean", "[Adaptive_Sampling]") {
+    AdaptiveSampling adaptive({}, 1, 1, 0);
+
+    // Luminance samples 1, 2, 3 and 4: mean 2.5, sample variance 5/3
+    for (const auto value : {1.0, 2.0, 3.0, 4.0})
+        adaptive.add_sample(0, vec3(value));
+
+    REQUIRE(adaptive.num_samples(0) == 4);
+    REQUIRE(adaptive.relative_error(0) == Catch::Approx(std::sqrt(5.0 / 3.0 / 4.0) / 2.5));
+    REQUIRE(!adaptive.converged(0));
+}
@@ -0,0 +1,235 @@
+#include <catch2/catch_all.hpp>
+
+#include <random>
+
+#include "ray.h"
+#include "interval.h"
+
+#include "hittable/sphere.h"
+#include "hittable/triangle.h"
+#include "hittable/hittable_list.h"
+#include "hittable/bvh_builder.h"
+#include "hittable/bvh_node.h"
+#include "hittable/linear_bvh.h"
+#include "hittable/wide_bvh.h"
+
+static HittableList create_random_spheres(uint32_t count, uint32_t seed) {
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<double> position(-10.0, 10.0);
+    std::uniform_real_distribution<double> radius(0.05, 0.5);
+
+    HittableList list;
+    for (uint32_t i = 0; i < count; ++i)
+        list.add_hittable<Sphere>(vec3(position(generator), position(generator), position(generator)),
+                                  radius(generator),
+                                  nullptr);
+
+    return list;
+}
+
+TEST_CASE("BVH builder produces a valid hierarchy", "[BVH_Builder]") {
+    const auto max_leaf_size = GENERATE(1u, 4u, 8u);
+    const auto list = create_random_spheres(500, 42);
+
+    std::vector<AABB> bounds;
+    for (const auto& object : list.objects())
+        bounds.push_back(object->bounding_box());
+
+    const auto result = BVHBuilder({.num_bins = 12, .max_leaf_size = max_leaf_size}).build(bounds);
+
+    REQUIRE(result.report.num_primitives == 500);
+    REQUIRE(result.report.num_nodes == result.nodes.size());
+    REQUIRE(result.report.max_leaf_primitives <= max_leaf_size);
+
+    std::vector<uint32_t> references(bounds.size(), 0);
+    for (std::size_t n = 0; n < result.nodes.size(); ++n) {
+        const auto& node = result.nodes[n];
+
+        if (node.is_leaf()) {
+            for (auto i = node.first_primitive; i < node.first_primitive + node.num_primitives; ++i) {
+                const auto primitive = result.primitive_indices[i];
+                references[primitive]++;
+
+                for (uint32_t axis = 0; axis < 3; ++axis) {
+                    REQUIRE(node.bounding_box.axis(axis).min <= bounds[primitive].axis(axis).min);
+                    REQUIRE(node.bounding_box.axis(axis).max >= bounds[primitive].axis(axis).max);
+                }
+            }
+        } else {
+            // Depth-first order
+            REQUIRE(node.left == n + 1);
+            REQUIRE(node.right > node.left);
+        }
+    }
+
+    for (const auto count : references)
+        REQUIRE(count == 1);
+}
+
+TEST_CASE("BVH hits the same object as a linear scan", "[BVH_Node]") {
+    const auto list = create_random_spheres(1000, 7);
+    const BVHNode bvh(list);
+
+    std::mt19937 generator(3);
+    std::uniform_real_distribution<double> distribution(-10.0, 10.0);
+
+    for (uint32_t i = 0; i < 1000; ++i) {
+        const auto origin = vec3(distribution(generator), distribution(generator), distribution(generator));
+        const auto direction = vec3(distribution(generator), distribution(generator), distribution(generator));
+        const auto ray = Ray(origin, direction);
+
+        const auto expected = list.hits(ray, interval(0.001, interval::infinity));
+        const auto record = bvh.hits(ray, interval(0.001, interval::infinity));
+
+        REQUIRE(expected.has_value() == record.has_value());
+        if (expected.has_value())
+            REQUIRE(expected->ts == record->ts);
+    }
+}
+
+TEST_CASE("Linear BVH hits the same object as a linear scan", "[Linear_BVH]") {
+    const auto list = create_random_spheres(1000, 11);
+    const LinearBVH bvh(list);
+
+    REQUIRE(bvh.nodes().size() == bvh.report().num_nodes);
+
+    std::mt19937 generator(5);
+    std::uniform_real_distribution<double> distribution(-10.0, 10.0);
+
+    for (uint32_t i = 0; i < 1000; ++i) {
+        const auto origin = vec3(distribution(generator), distribution(generator), distribution(generator));
+        const auto direction = vec3(distribution(generator), distribution(generator), distribution(generator));
+        const auto ray = Ray(origin, direction);
+
+        const auto expected = list.hits(ray, interval(0.001, interval::infinity));
+        const auto record = bvh.hits(ray, interval(0.001, interval::infinity));
+
+        REQUIRE(expected.has_value() == record.has_value());
+        if (expected.has_value())
+            REQUIRE(expected->ts == record->ts);
+    }
+}
+
+TEST_CASE("BVHs hit axis aligned triangles", "[Linear_BVH]") {
+    HittableList list;
+    list.add_hittable<Triangle>(Triangle::Vertex{.pos = vec3(-1.0, -1.0, 0.0)},
+                                Triangle::Vertex{.pos = vec3(1.0, -1.0, 0.0)},
+                                Triangle::Vertex{.pos = vec3(0.0, 1.0, 0.0)},
+                                nullptr);
+    list.add_hittable<Triangle>(Triangle::Vertex{.pos = vec3(-1.0, -1.0, 2.0)},
+                                Triangle::Vertex{.pos = vec3(1.0, -1.0, 2.0)},
+                                Triangle::Vertex{.pos = vec3(0.0, 1.0, 2.0)},
+                                nullptr);
+
+    const auto ray = Ray(vec3(0.0, 0.0, -1.0), vec3(0.0, 0.0, 1.0));
+
+    const auto record = BVHNode(list).hits(ray, interval(0.0, interval::infinity));
+    REQUIRE(record.has_value());
+    REQUIRE(record->ts == 1.0);
+
+    const auto linear_record = LinearBVH(list).hits(ray, interval(0.0, interval::infinity));
+    REQUIRE(linear_record.has_value());
+    REQUIRE(linear_record->ts == 1.0);
+
+    const auto wide_record = WideBVH(list).hits(ray, interval(0.0, interval::infinity));
+    REQUIRE(wide_record.has_value());
+    REQUIRE(wide_record->ts == 1.0);
+}
+
+TEST_CASE("BVH intersections reference the primitive that was hit", "[Wide_BVH]") {
+    HittableList list;
+    list.add_hittable<Sphere>(vec3(0.0, 0.0, 0.0), 1.0, nullptr);
+    list.add_hittable<Sphere>(vec3(0.0, 0.0, 4.0), 1.0, nullptr);
+
+    const auto ray = Ray(vec3(0.0, 0.0, 10.0), vec3(0.0, 0.0, -1.0));
+    const auto intersection = WideBVH(list).intersect(ray, interval(0.0, interval::infinity));
+
+    REQUIRE(intersection.has_value());
+    REQUIRE(intersection->hittable == list.objects()[1].get());
+
+    const auto expected = list.objects()[1]->hits(ray, interval(0.0, interval::infinity));
+    const auto record = list.compute_interaction(ray, *intersection);
+    REQUIRE(record.ts == expected->ts);
+    REQUIRE(record.uv == expected->uv);
+    REQUIRE(record.normal == expected->normal);
+}
+
+TEST_CASE("Wide BVH hits the same object as a linear scan", "[Wide_BVH]") {
+    const auto list = create_random_spheres(1000, 13);
+    const WideBVH bvh(list);
+
+    std::mt19937 generator(9);
+    std::uniform_real_distribution<double> distribution(-10.0, 10.0);
+
+    for (uint32_t i = 0; i < 1000; ++i) {
+        const auto origin = vec3(distribution(generator), distribution(generator), distribution(generator));
+        const auto direction = vec3(distribution(generator), distribution(generator), distribution(generator));
+        const auto ray = Ray(origin, direction);
+
+        const auto expected = list.hits(ray, interval(0.001, interval::infinity));
+        const auto record = bvh.hits(ray, interval(0.001, interval::infinity));
+
+        REQUIRE(expected.has_value() == record.has_value());
+        if (expected.has_value())
+            REQUIRE(expected->ts == record->ts);
+    }
+}
+
+TEST_CASE("Wide BVH node test returns hit mask", "[Wide_BVH]") {
+    // Four unit boxes placed along the x axis, at x = 0, 2, 4 and 6
+    WideBVH::Node node{};
+    for (uint32_t i = 0; i < WideBVH::WIDTH; ++i) {
+        node.min_x[i] = 2.0f * static_cast<float>(i);
+        node.max_x[i] = node.min_x[i] + 1.0f;
+        node.min_y[i] = node.min_z[i] = 0.0f;
+        node.max_y[i] = node.max_z[i] = 1.0f;
+    }
+
+    // Ray along x through all boxes
+    const WideBVH::NodeRay ray{
+        .origin = {-1.0f, 0.5f, 0.5f},
+        .inv_direction = {1.0f, std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity()},
+        .direction_negative = {false, false, false},
+    };
+
+    alignas(16) float t_near[WideBVH::WIDTH];
+    REQUIRE(WideBVH::intersect_node(node, ray, 0.0f, 100.0f, t_near) == 0b1111);
+    REQUIRE(t_near[0] == 1.0f);
+    REQUIRE(t_near[3] == 7.0f);
+
+    // Limiting the interval discards the farthest boxes
+    REQUIRE(WideBVH::intersect_node(node, ray, 0.0f, 4.0f, t_near) == 0b0011);
+}
+
+TEST_CASE("Wide BVH packet traversal matches single rays", "[Wide_BVH]") {
+    const auto list = create_random_spheres(1000, 21);
+    const WideBVH bvh(list);
+
+    std::mt19937 generator(5);
+    std::uniform_real_distribution<double> jitter(-0.05, 0.05);
+
+    // Coherent packets sharing an origin, spread around a random direction
+    for (uint32_t p = 0; p < 100; ++p) {
+        const auto origin = vec3(0.0, 0.0, -15.0);
+        const auto center = vec3(jitter(generator), jitter(generator), 1.0) * real(10);
+
+        RayPacket packet;
+        while (packet.size < RayPacket::MAX_SIZE)
+            packet.add(Ray(origin, center + vec3(jitter(generator), jitter(generator), 0.0)));
+        packet.compute_bounds();
+
+        PacketHitRecord records{};
+        for (auto& t_max : records.t_max)
+            t_max = interval::infinity;
+
+        bvh.intersect_packet(packet, packet.all_lanes(), records);
+
+        for (uint32_t lane = 0; lane < packet.size; ++lane) {
+            const auto expected = bvh.intersect(packet.rays[lane], interval(records.t_min, interval::infinity));
+
+            REQUIRE(expected.has_value() == records.intersections[lane].has_value());
+            if (expected.has_value())
+                REQUIRE(expected->t == records.intersections[lane]->t);
+        }
+    }
+}
@@ -0,0 +1,147 @@
+#include <catch2/catch_all.hpp>
+
+#include <random>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "ray.h"
+#include "interval.h"
+#include "ray_packet.h"
+
+#include "hittable/sphere.h"
+#include "hittable/model.h"
+#include "hittable/instance.h"
+#include "hittable/hittable_list.h"
+#include "hittable/wide_bvh.h"
+
+#include "test_meshes.h"
+
+TEST_CASE("Instances hit like the object with the transform baked in", "[Instance]") {
+    const auto translation = vec3(1.0, -2.0, 0.5);
+    const auto scale = vec3(2.0, 0.5, 1.5);
+    const auto rotation = vec3(0.3, -0.7, 1.1);
+
+    auto transform = glm::translate(mat4(1.0), translation);
+    transform = glm::scale(transform, scale);
+    transform = glm::rotate(transform, rotation.x, vec3(1.0, 0.0, 0.0));
+    transform = glm::rotate(transform, rotation.y, vec3(0.0, 1.0, 0.0));
+    transform = glm::rotate(transform, rotation.z, vec3(0.0, 0.0, 1.0));
+
+    const auto baked = create_grid_mesh({.size = 12, .bump = real(0.3), .transform = transform});
+    const Instance instance(create_grid_mesh({.size = 12, .bump = real(0.3)}), translation, scale, rotation);
+
+    // Bounds of the transformed object bounds, so they contain the baked mesh
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+        REQUIRE(instance.bounding_box().axis(axis).min <= baked->bounding_box().axis(axis).min + 1e-6);
+        REQUIRE(instance.bounding_box().axis(axis).max >= baked->bounding_box().axis(axis).max - 1e-6);
+    }
+
+    std::mt19937 generator(11);
+    std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+
+    const auto center = baked->bounding_box().centroid();
+    uint32_t num_hits = 0;
+
+    for (uint32_t i = 0; i < 500; ++i) {
+        const auto origin = center + vec3(distribution(generator), distribution(generator), distribution(generator)) *
+                                         real(5);
+        const auto target = center + vec3(distribution(generator), distribution(generator), distribution(generator));
+        const Ray ray(origin, target - origin);
+
+        const auto expected = baked->hits(ray, interval(RAY_T_MIN, interval::infinity));
+        const auto record = instance.hits(ray, interval(RAY_T_MIN, interval::infinity));
+
+        REQUIRE(record.has_value() == expected.has_value());
+        if (!expected.has_value())
+            continue;
+
+        num_hits++;
+        REQUIRE(record->ts == Catch::Approx(expected->ts).epsilon(1e-4));
+        REQUIRE(glm::distance(record->point, expected->point) < 1e-4);
+        REQUIRE(glm::distance(record->normal, expected->normal) < 1e-4);
+        REQUIRE(glm::distance(record->uv, expected->uv) < 1e-4);
+        REQUIRE(record->front_face == expected->front_face);
+    }
+
+    REQUIRE(num_hits > 100);
+}
+
+TEST_CASE("A top level BVH over instances shares one mesh", "[Instance]") {
+    const auto mesh = create_grid_mesh({.size = 8, .bump = real(0.3)});
+
+    // 10 x 10 copies of the mesh, one unit apart, facing -z
+    HittableList scene;
+    for (uint32_t row = 0; row < 10; ++row) {
+        for (uint32_t col = 0; col < 10; ++col) {
+            const auto offset = vec3(static_cast<real>(col) * 2, static_cast<real>(row) * 2, 0.0);
+            scene.add_hittable<Instance>(mesh, offset, vec3(1.0), vec3(0.0));
+        }
+    }
+
+    const WideBVH bvh(scene);
+    REQUIRE(mesh.use_count() == 101);
+
+    SECTION("Single rays") {
+        for (uint32_t row = 0; row < 10; ++row) {
+            for (uint32_t col = 0; col < 10; ++col) {
+                const auto x = static_cast<real>(col) * 2 + real(0.5);
+                const auto y = static_cast<real>(row) * 2 + real(0.5);
+
+                const auto record = bvh.hits(Ray(vec3(x, y, -5.0), vec3(0.0, 0.0, 1.0)), interval(0.0, 100.0));
+                REQUIRE(record.has_value());
+                REQUIRE(record->point.x == Catch::Approx(x));
+                REQUIRE(record->point.y == Catch::Approx(y));
+                REQUIRE(record->uv.x == Catch::Approx(0.5));
+                REQUIRE(record->uv.y == Catch::Approx(0.5));
+
+                // Rays between the copies miss
+                REQUIRE(!bvh.intersect(Ray(vec3(x + 1, y, -5.0), vec3(0.0, 0.0, 1.0)), interval(0.0, 100.0)));
+            }
+        }
+    }
+
+    SECTION("Packets match single rays") {
+        std::mt19937 generator(5);
+        std::uniform_real_distribution<double> jitter(-0.05, 0.05);
+
+        for (uint32_t p = 0; p < 100; ++p) {
+            const auto origin = vec3(9.0, 9.0, -15.0);
+            const auto center = vec3(jitter(generator), jitter(generator), 0.1) * real(10);
+
+            RayPacket packet;
+            while (packet.size < RayPacket::MAX_SIZE)
+                packet.add(Ray(origin, center + vec3(jitter(generator), jitter(generator), 0.0)));
+            packet.compute_bounds();
+
+            PacketHitRecord records{};
+            for (auto& t_max : records.t_max)
+                t_max = interval::infinity;
+
+            bvh.intersect_packet(packet, packet.all_lanes(), records);
+
+            for (uint32_t lane = 0; lane < packet.size; ++lane) {
+                const auto expected = bvh.intersect(packet.rays[lane], interval(records.t_min, interval::infinity));
+
+                REQUIRE(expected.has_value() == records.intersections[lane].has_value());
+                if (expected.has_value()) {
+                    REQUIRE(expected->t == records.intersections[lane]->t);
+                    REQUIRE(expected->instance == records.intersections[lane]->instance);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("Instanced spheres are scaled", "[Instance]") {
+    const auto sphere = std::make_shared<Sphere>(vec3(0.0), 1.0, nullptr);
+    const Instance instance(sphere, vec3(0.0, 0.0, 10.0), vec3(3.0), vec3(0.0));
+
+    REQUIRE(instance.bounding_box().min() == vec3(-3.0, -3.0, 7.0));
+    REQUIRE(instance.bounding_box().max() == vec3(3.0, 3.0, 13.0));
+
+    const auto record = instance.hits(Ray(vec3(0.0), vec3(0.0, 0.0, 1.0)), interval(RAY_T_MIN, interval::infinity));
+    REQUIRE(record.has_value());
+    REQUIRE(record->ts == Catch::Approx(7.0));
+    REQUIRE(record->point.z == Catch::Approx(7.0));
+    REQUIRE(record->normal.z == Catch::Approx(-1.0));
+    REQUIRE(record->front_face);
+}
@@ -0,0 +1,212 @@
+#include <catch2/catch_all.hpp>
+
+#include <random>
+
+#include "ray.h"
+
+#include "hittable/model.h"
+
+#include "test_meshes.h"
+
+TEST_CASE("Mesh bounding box correct", "[Hittable_Mesh]") {
+    const auto mesh = create_grid_mesh({.size = 8});
+    const auto bbox = mesh->bounding_box();
+
+    REQUIRE(bbox.axis(0).min == 0.0);
+    REQUIRE(bbox.axis(0).max == 1.0);
+
+    REQUIRE(bbox.axis(1).min == 0.0);
+    REQUIRE(bbox.axis(1).max == 1.0);
+}
+
+TEST_CASE("Ray hits mesh face", "[Hittable_Mesh]") {
+    const auto mesh = create_grid_mesh({.size = 16});
+
+    const auto x = GENERATE(take(10, random(0.01, 0.99)));
+    const auto y = GENERATE(take(10, random(0.01, 0.99)));
+
+    const auto record = mesh->hits(Ray(vec3(x, y, -1.0), vec3(0.0, 0.0, 1.0)), interval(0.0, interval::infinity));
+    REQUIRE(record.has_value());
+    REQUIRE(record->ts == Catch::Approx(1.0));
+    REQUIRE(record->uv.x == Catch::Approx(x));
+    REQUIRE(record->uv.y == Catch::Approx(y));
+    REQUIRE(record->front_face);
+}
+
+TEST_CASE("Ray misses mesh", "[Hittable_Mesh]") {
+    const auto mesh = create_grid_mesh({.size = 16});
+
+    const auto record = mesh->hits(Ray(vec3(1.5, 0.5, -1.0), vec3(0.0, 0.0, 1.0)), interval(0.0, interval::infinity));
+    REQUIRE(!record.has_value());
+
+    const auto record2 = mesh->hits(Ray(vec3(0.5, 0.5, -1.0), vec3(0.0, 0.0, 1.0)), interval(0.0, 0.9));
+    REQUIRE(!record2.has_value());
+}
+
+TEST_CASE("Ray hits small mesh faces", "[Hittable_Mesh]") {
+    // Edges of 1e-4 give determinants below the single precision epsilon
+    const std::vector<Triangle::Vertex> vertices = {
+        {.pos = vec3(0.0, 0.0, 0.0)},
+        {.pos = vec3(1e-4, 0.0, 0.0)},
+        {.pos = vec3(0.0, 1e-4, 0.0)},
+        {.pos = vec3(1e-4, 1e-4, 0.0)},
+    };
+    const std::vector<uvec3> faces = {{0, 1, 2}, {1, 3, 2}};
+
+    const Mesh mesh(vertices, faces, nullptr);
+    const Mesh float_mesh(vertices, faces, nullptr, {.float_positions = true});
+
+    for (const auto* tested : {&mesh, &float_mesh}) {
+        const auto record = tested->hits(Ray(vec3(2.5e-5, 2.5e-5, -1.0), vec3(0.0, 0.0, 1.0)), interval(0.0, 2.0));
+        REQUIRE(record.has_value());
+        REQUIRE(record->ts == Catch::Approx(1.0));
+
+        const auto record2 = tested->hits(Ray(vec3(7.5e-5, 7.5e-5, -1.0), vec3(0.0, 0.0, 1.0)), interval(0.0, 2.0));
+        REQUIRE(record2.has_value());
+        REQUIRE(record2->ts == Catch::Approx(1.0));
+    }
+}
+
+TEST_CASE("Mesh hits match the individual triangles", "[Hittable_Mesh]") {
+    // Bumpy grid, so rays can cross several faces and the closest one must be picked
+    std::vector<Triangle::Vertex> vertices;
+    std::vector<uvec3> faces;
+
+    constexpr uint32_t n = 12;
+    for (uint32_t row = 0; row <= n; ++row) {
+        for (uint32_t col = 0; col <= n; ++col) {
+            const auto x = static_cast<real>(col) / n;
+            const auto y = static_cast<real>(row) / n;
+            const auto z = real(0.3) * glm::sin(real(17) * x) * glm::cos(real(13) * y);
+            vertices.push_back({.pos = vec3(x, y, z), .uv = vec2(x, y), .normal = vec3(0.0, 0.0, -1.0)});
+        }
+    }
+
+    for (uint32_t row = 0; row < n; ++row) {
+        for (uint32_t col = 0; col < n; ++col) {
+            const auto i = row * (n + 1) + col;
+            faces.emplace_back(i, i + 1, i + n + 1);
+            faces.emplace_back(i + 1, i + n + 2, i + n + 1);
+        }
+    }
+
+    const Mesh mesh(vertices, faces, nullptr);
+
+    std::vector<Triangle> triangles;
+    for (const auto& f : faces)
+        triangles.emplace_back(vertices[f.x], vertices[f.y], vertices[f.z], nullptr);
+
+    std::mt19937 generator(3);
+    std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+
+    for (uint32_t i = 0; i < 500; ++i) {
+        const auto offset = vec3(distribution(generator), distribution(generator), 0.0);
+        const auto origin = vec3(0.5, 0.5, -2.0) + offset;
+        const auto direction = vec3(distribution(generator), distribution(generator), 4.0);
+        const Ray ray(origin, direction);
+
+        std::optional<HitRecord> expected;
+        auto closest = interval::infinity;
+        for (const auto& triangle : triangles) {
+            const auto record = triangle.hits(ray, interval(0.0, closest));
+            if (record.has_value()) {
+                expected = record;
+                closest = record->ts;
+            }
+        }
+
+        const auto record = mesh.hits(ray, interval(0.0, interval::infinity));
+        REQUIRE(record.has_value() == expected.has_value());
+        if (expected.has_value()) {
+            REQUIRE(record->ts == expected->ts);
+            REQUIRE(record->uv == expected->uv);
+            REQUIRE(record->normal == expected->normal);
+        }
+    }
+}
+
+TEST_CASE("Compact meshes hit like full precision meshes", "[Hittable_Mesh]") {
+    // Bumpy grid with normals that vary per vertex, so the packed normals are exercised
+    std::vector<Triangle::Vertex> vertices;
+    std::vector<uvec3> faces;
+
+    constexpr uint32_t n = 32;
+    for (uint32_t row = 0; row <= n; ++row) {
+        for (uint32_t col = 0; col <= n; ++col) {
+            const auto x = static_cast<real>(col) / n;
+            const auto y = static_cast<real>(row) / n;
+            const auto z = real(0.3) * glm::sin(real(17) * x) * glm::cos(real(13) * y);
+            const auto normal = glm::normalize(vec3(glm::sin(real(5) * x), glm::cos(real(3) * y), real(-1)));
+            vertices.push_back({.pos = vec3(x, y, z), .uv = vec2(x, y), .normal = normal});
+        }
+    }
+
+    for (uint32_t row = 0; row < n; ++row) {
+        for (uint32_t col = 0; col < n; ++col) {
+            const auto i = row * (n + 1) + col;
+            faces.emplace_back(i, i + 1, i + n + 1);
+            faces.emplace_back(i + 1, i + n + 2, i + n + 1);
+        }
+    }
+
+    const Mesh mesh(vertices, faces, nullptr);
+    const Mesh compact(vertices, faces, nullptr, {.float_positions = true, .compact_attributes = true});
+
+    REQUIRE(compact.num_faces() == mesh.num_faces());
+    REQUIRE(compact.memory_size() < mesh.memory_size());
+
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+
+    uint32_t num_hits = 0;
+    uint32_t num_mismatches = 0;
+    for (uint32_t i = 0; i < 500; ++i) {
+        const auto origin = vec3(0.5, 0.5, -2.0) + vec3(distribution(generator), distribution(generator), 0.0);
+        const Ray ray(origin, vec3(distribution(generator), distribution(generator), 4.0));
+
+        const auto expected = mesh.hits(ray, interval(0.0, interval::infinity));
+        const auto record = compact.hits(ray, interval(0.0, interval::infinity));
+
+        // Rays grazing the border may land on either side of it once positions are rounded to float
+        if (record.has_value() != expected.has_value()) {
+            num_mismatches++;
+            continue;
+        }
+
+        if (expected.has_value()) {
+            num_hits++;
+            REQUIRE(record->ts == Catch::Approx(expected->ts).epsilon(1e-4));
+            REQUIRE(glm::distance(record->uv, expected->uv) < 2e-3);
+            REQUIRE(glm::distance(record->normal, expected->normal) < 1e-3);
+        }
+    }
+
+    REQUIRE(num_hits > 100);
+    REQUIRE(num_mismatches < 3);
+}
+
+TEST_CASE("Packed attributes round trip", "[Hittable_Mesh]") {
+    SECTION("Octahedral normals") {
+        std::mt19937 generator(9);
+        std::normal_distribution<double> distribution;
+
+        for (uint32_t i = 0; i < 1000; ++i) {
+            const auto unit =
+                glm::normalize(vec3(distribution(generator), distribution(generator), distribution(generator)));
+            const auto unpacked = unpack_octahedral(pack_octahedral(unit));
+
+            REQUIRE(glm::length(unpacked) == Catch::Approx(1.0).epsilon(1e-5));
+            REQUIRE(glm::distance(unpacked, unit) < 1e-4);
+        }
+
+        REQUIRE(unpack_octahedral(pack_octahedral(vec3(0.0, 0.0, -1.0))) == vec3(0.0, 0.0, -1.0));
+    }
+
+    SECTION("Half precision texture coordinates") {
+        REQUIRE(unpack_half2(pack_half2(vec2(0.5, 0.25))) == vec2(0.5, 0.25));
+        REQUIRE(unpack_half2(pack_half2(vec2(-2.0, 0.0))) == vec2(-2.0, 0.0));
+
+        const auto uv = vec2(0.123456, 0.987654);
+        REQUIRE(glm::distance(unpack_half2(pack_half2(uv)), uv) < 1e-3);
+    }
+}
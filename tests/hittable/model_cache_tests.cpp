@@ -0,0 +1,220 @@
+#include <catch2/catch_all.hpp>
+
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+
+#include "ray.h"
+#include "cache_file.h"
+
+#include "hittable/model.h"
+#include "hittable/wide_bvh.h"
+#include "hittable/model_cache.h"
+
+#include "test_meshes.h"
+
+// Stand-in source model, only its path and modification time matter to the cache
+static std::filesystem::path create_source(const char* name) {
+    const auto path = std::filesystem::temp_directory_path() / name;
+    std::ofstream(path) << "o cube\n";
+    return path;
+}
+
+static void require_same_hits(const Mesh& expected, const Mesh& mesh) {
+    REQUIRE(mesh.bounding_box().min() == expected.bounding_box().min());
+    REQUIRE(mesh.bounding_box().max() == expected.bounding_box().max());
+
+    std::mt19937 generator(5);
+    std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+
+    for (uint32_t i = 0; i < 200; ++i) {
+        const auto origin = vec3(0.5, 0.5, -2.0) + vec3(distribution(generator), distribution(generator), 0.0);
+        const Ray ray(origin, vec3(distribution(generator), distribution(generator), 4.0));
+
+        const auto expected_record = expected.hits(ray, interval(0.0, interval::infinity));
+        const auto record = mesh.hits(ray, interval(0.0, interval::infinity));
+
+        REQUIRE(record.has_value() == expected_record.has_value());
+        if (expected_record.has_value()) {
+            REQUIRE(record->ts == expected_record->ts);
+            REQUIRE(record->uv == expected_record->uv);
+            REQUIRE(record->normal == expected_record->normal);
+        }
+    }
+}
+
+TEST_CASE("Cached meshes intersect like the original ones", "[Model_Cache]") {
+    const auto source = create_source("ray_tracer_model_cache.obj");
+    const auto key = ModelCache::key(source, vec3(1.0, 2.0, 3.0), vec3(1.0), vec3(0.0));
+    REQUIRE(key.has_value());
+
+    const std::vector<std::shared_ptr<Mesh>> meshes = {
+        create_grid_mesh({.size = 12, .bump = real(0.3)}),
+        create_grid_mesh({.size = 5, .bump = real(0.3), .offset = 1}),
+    };
+    REQUIRE(ModelCache::save(*key, meshes));
+
+    const auto cached = ModelCache::load(*key, nullptr);
+    REQUIRE(cached.has_value());
+    REQUIRE(cached->size() == meshes.size());
+
+    for (std::size_t i = 0; i < meshes.size(); ++i)
+        require_same_hits(*meshes[i], *(*cached)[i]);
+
+    std::filesystem::remove(ModelCache::path(*key));
+    std::filesystem::remove(source);
+}
+
+TEST_CASE("Model caches are keyed by source, transform and modification time", "[Model_Cache]") {
+    const auto source = create_source("ray_tracer_model_cache_key.obj");
+    const auto key = ModelCache::key(source, vec3(0.0), vec3(2.0), vec3(0.0));
+    REQUIRE(key.has_value());
+    REQUIRE(!ModelCache::key(source.string() + ".missing", vec3(0.0), vec3(2.0), vec3(0.0)).has_value());
+
+    REQUIRE(ModelCache::save(*key, {create_grid_mesh({.size = 4, .bump = real(0.3)})}));
+    REQUIRE(ModelCache::load(*key, nullptr).has_value());
+
+    SECTION("Other transforms use another cache") {
+        auto moved = *key;
+        moved.translation = vec3(0.0, 1.0, 0.0);
+
+        REQUIRE(ModelCache::path(moved) != ModelCache::path(*key));
+        REQUIRE(!ModelCache::load(moved, nullptr).has_value());
+    }
+
+    SECTION("Edited sources are imported again") {
+        auto edited = *key;
+        edited.modified += 1;
+
+        REQUIRE(ModelCache::path(edited) == ModelCache::path(*key));
+        REQUIRE(!ModelCache::load(edited, nullptr).has_value());
+    }
+
+    SECTION("Truncated caches are rejected") {
+        const auto path = ModelCache::path(*key);
+        std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+
+        REQUIRE(!ModelCache::load(*key, nullptr).has_value());
+    }
+
+    std::filesystem::remove(ModelCache::path(*key));
+    std::filesystem::remove(source);
+}
+
+TEST_CASE("Model caches are written to the cache directory", "[Model_Cache]") {
+    const auto previous = ModelCache::directory();
+    const auto directory = std::filesystem::temp_directory_path() / "ray_tracer_model_cache_directory";
+    std::filesystem::remove_all(directory);
+    ModelCache::set_directory(directory);
+
+    const auto source = create_source("ray_tracer_model_cache_directory.obj");
+    const auto key = ModelCache::key(source, vec3(0.0), vec3(1.0), vec3(0.0));
+    REQUIRE(key.has_value());
+    REQUIRE(ModelCache::path(*key).parent_path() == directory);
+
+    // The directory is created, and only the cache is left in it
+    REQUIRE(ModelCache::save(*key, {create_grid_mesh({.size = 4, .bump = real(0.3)})}));
+    REQUIRE(ModelCache::load(*key, nullptr).has_value());
+    REQUIRE(std::distance(std::filesystem::directory_iterator(directory), std::filesystem::directory_iterator()) == 1);
+
+    // A file in the way of the directory
+    ModelCache::set_directory(source / "cache");
+    REQUIRE(!ModelCache::save(*key, {create_grid_mesh({.size = 4, .bump = real(0.3)})}));
+
+    ModelCache::set_directory(previous);
+    std::filesystem::remove_all(directory);
+    std::filesystem::remove(source);
+}
+
+TEST_CASE("Cache readers stop at the end of the data", "[Model_Cache]") {
+    const auto path = std::filesystem::temp_directory_path() / "ray_tracer_cache_file.bin";
+
+    CacheWriter writer;
+    writer.write(uint32_t{7});
+    writer.write(std::vector<float>{1.0f, 2.0f, 3.0f});
+    REQUIRE(writer.save(path));
+
+    const auto file = MappedFile::open(path);
+    REQUIRE(file.has_value());
+    REQUIRE(file->bytes().size() == sizeof(uint32_t) + sizeof(uint64_t) + 3 * sizeof(float));
+
+    CacheReader reader(file->bytes());
+    uint32_t value = 0;
+    std::vector<float> values;
+    REQUIRE(reader.read(value));
+    REQUIRE(reader.read(values));
+    REQUIRE(value == 7);
+    REQUIRE(values == std::vector<float>{1.0f, 2.0f, 3.0f});
+
+    REQUIRE(reader.remaining() == 0);
+    REQUIRE(!reader.read(value));
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Cached hierarchies are rejected if they are not valid", "[Model_Cache]") {
+    const auto path = std::filesystem::temp_directory_path() / "ray_tracer_cache_bvh.bin";
+
+    std::vector<AABB> bounds;
+    for (uint32_t i = 0; i < 64; ++i) {
+        const auto x = static_cast<real>(i % 8), y = static_cast<real>(i / 8);
+        bounds.emplace_back(vec3(x, y, 0.0), vec3(x + 0.5, y + 0.5, 1.0));
+    }
+
+    CacheWriter writer;
+    WideBVH(bounds).save(writer);
+    REQUIRE(writer.save(path));
+
+    std::vector<std::byte> bytes(std::filesystem::file_size(path));
+    std::ifstream(path, std::ios::binary).read(reinterpret_cast<char*>(bytes.data()),
+                                                static_cast<std::streamsize>(bytes.size()));
+    std::filesystem::remove(path);
+
+    // Vectors are stored as their size followed by their elements
+    uint64_t num_nodes = 0;
+    std::memcpy(&num_nodes, bytes.data(), sizeof(num_nodes));
+    REQUIRE(num_nodes > 1);
+
+    const auto root = sizeof(uint64_t);
+    const auto root_child = root + offsetof(WideBVH::Node, child);
+    const auto root_num_primitives = root + offsetof(WideBVH::Node, num_primitives);
+    const auto primitive_order = root + num_nodes * sizeof(WideBVH::Node) + sizeof(uint64_t);
+
+    const auto load = [&bytes]() {
+        CacheReader reader(bytes);
+        return WideBVH::load(reader);
+    };
+
+    const auto write = [&bytes](std::size_t offset, auto value) {
+        std::memcpy(bytes.data() + offset, &value, sizeof(value));
+    };
+
+    REQUIRE(load().has_value());
+
+    SECTION("Child node referencing its parent") {
+        write(root_child, uint32_t{0});
+        write(root_num_primitives, uint16_t{0});
+        REQUIRE(!load().has_value());
+    }
+
+    SECTION("Child node out of the hierarchy") {
+        write(root_child, static_cast<uint32_t>(num_nodes));
+        write(root_num_primitives, uint16_t{0});
+        REQUIRE(!load().has_value());
+    }
+
+    SECTION("Leaf out of the primitives") {
+        write(root_child, uint32_t{60});
+        write(root_num_primitives, uint16_t{5});
+        REQUIRE(!load().has_value());
+    }
+
+    SECTION("Primitive stored twice") {
+        write(primitive_order + sizeof(uint32_t), uint32_t{0});
+        write(primitive_order, uint32_t{0});
+        REQUIRE(!load().has_value());
+    }
+}
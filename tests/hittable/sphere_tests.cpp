@@ -5,10 +5,10 @@
 #include "hittable/sphere.h"
 
 TEST_CASE("Sphere bounding box correct", "[Hittable_Sphere]") {
-    const auto x = GENERATE(take(5, random(-5.0, 5.0)));
-    const auto y = GENERATE(take(5, random(-5.0, 5.0)));
-    const auto z = GENERATE(take(5, random(-5.0, 5.0)));
-    const auto r = GENERATE(take(5, random(0.1, 5.0)));
+    const auto x = static_cast<real>(GENERATE(take(5, random(-5.0, 5.0))));
+    const auto y = static_cast<real>(GENERATE(take(5, random(-5.0, 5.0))));
+    const auto z = static_cast<real>(GENERATE(take(5, random(-5.0, 5.0))));
+    const auto r = static_cast<real>(GENERATE(take(5, random(0.1, 5.0))));
 
     Sphere sphere(vec3(x, y, z), r, nullptr);
     const auto bbox = sphere.bounding_box();
@@ -92,4 +92,29 @@ TEST_CASE("Ray misses sphere because of interval", "[Hittable_Sphere]") {
 
     const auto record = sphere.hits(ray, interval(0.0, 0.9));
     REQUIRE(!record.has_value());
-}
\ No newline at end of file
+}
+
+TEST_CASE("Sphere texture coordinate gradients match finite differences", "[Hittable_Sphere]") {
+    const auto radius = static_cast<real>(GENERATE(2.0, -2.0));
+    Sphere sphere(vec3(1.0, 0.0, 0.0), radius, nullptr);
+
+    const auto hit_towards = [&sphere](const vec3& direction) {
+        const auto record = sphere.hits(Ray(vec3(1.0, 0.0, 0.0), direction), interval(0.0, interval::infinity));
+        REQUIRE(record.has_value());
+        return *record;
+    };
+
+    const auto record = hit_towards(vec3(0.3, 0.4, -0.8));
+    const auto step = real(1e-3);
+
+    // Small moves along the surface, away from the seam of the longitude
+    for (const auto& tangent : {glm::cross(record.normal, vec3(0.0, 1.0, 0.0)), vec3(0.0, 1.0, 0.0)}) {
+        const auto moved = hit_towards(record.point + step * glm::normalize(tangent) - vec3(1.0, 0.0, 0.0));
+        const auto displacement = moved.point - record.point;
+
+        const auto expected_u = glm::dot(record.u_gradient, displacement);
+        REQUIRE(moved.uv.x - record.uv.x == Catch::Approx(expected_u).epsilon(0.01).margin(1e-6));
+        const auto expected_v = glm::dot(record.v_gradient, displacement);
+        REQUIRE(moved.uv.y - record.uv.y == Catch::Approx(expected_v).epsilon(0.01).margin(1e-6));
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "vec.h"
+
+#include "hittable/model.h"
+
+struct GridMeshDescription {
+    uint32_t size = 8;          // Quads along each side
+    real bump = 0;              // Height of the bumps, a flat grid if 0
+    real offset = 0;            // Height of the grid
+    mat4 transform = mat4(1.0); // Applied to every vertex
+};
+
+// size x size grid of quads over [0, 1] in x and y, at z = offset + bump * sin(17 x) cos(13 y) before the transform.
+// Normals all point the same way, so interpolating them commutes with the transform.
+inline std::shared_ptr<Mesh> create_grid_mesh(const GridMeshDescription& description) {
+    const auto n = description.size;
+    const auto& transform = description.transform;
+    const auto normal = glm::normalize(glm::transpose(glm::inverse(mat3(transform))) * vec3(0.0, 0.0, -1.0));
+
+    std::vector<Triangle::Vertex> vertices;
+    std::vector<uvec3> faces;
+
+    for (uint32_t row = 0; row <= n; ++row) {
+        for (uint32_t col = 0; col <= n; ++col) {
+            const auto x = static_cast<real>(col) / static_cast<real>(n);
+            const auto y = static_cast<real>(row) / static_cast<real>(n);
+            const auto z = description.offset + description.bump * glm::sin(real(17) * x) * glm::cos(real(13) * y);
+            const auto position = transform * vec4(x, y, z, 1.0);
+            vertices.push_back({
+                .pos = vec3(position.x, position.y, position.z),
+                .uv = vec2(x, y),
+                .normal = normal,
+            });
+        }
+    }
+
+    for (uint32_t row = 0; row < n; ++row) {
+        for (uint32_t col = 0; col < n; ++col) {
+            const auto i = row * (n + 1) + col;
+            faces.emplace_back(i, i + 1, i + n + 1);
+            faces.emplace_back(i + 1, i + n + 2, i + n + 1);
+        }
+    }
+
+    return std::make_shared<Mesh>(vertices, faces, nullptr);
+}
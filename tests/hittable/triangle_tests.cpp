@@ -123,6 +123,19 @@ TEST_CASE("Ray misses triangle because of interval", "[Hittable_Triangle]") {
     REQUIRE(!record.has_value());
 }
 
+TEST_CASE("Ray hits small triangle", "[Hittable_Triangle]") {
+    // Edges of 1e-4 give a determinant below the single precision epsilon
+    Triangle triangle(Triangle::Vertex{.pos = vec3(0.0, 0.0, 0.0)},
+                      Triangle::Vertex{.pos = vec3(1e-4, 0.0, 0.0)},
+                      Triangle::Vertex{.pos = vec3(0.0, 1e-4, 0.0)},
+                      nullptr);
+    Ray ray(vec3(2.5e-5, 2.5e-5, -1.0), vec3(0.0, 0.0, 1.0));
+
+    const auto record = triangle.hits(ray, interval(0.0, interval::infinity));
+    REQUIRE(record.has_value());
+    REQUIRE(record->ts == Catch::Approx(1.0));
+}
+
 TEST_CASE("Correct triangle uv coordinates", "[Hittable_Triangle]") {
     HittableList scene;
     scene.add_hittable<Triangle>(Triangle::Vertex{.pos = {0.0, 1.0, 0.0}, .uv = {0.0, 0.0}},
@@ -145,4 +158,23 @@ TEST_CASE("Correct triangle uv coordinates", "[Hittable_Triangle]") {
     const auto record3 = scene.hits(Ray(vec3(0.5, 0.1, -1.0), vec3(0.0, 0.0, 1.0)), interval(0.0, interval::infinity));
     REQUIRE(record3.has_value());
     REQUIRE(record3->uv == vec2(0.5, 0.9));
-}
\ No newline at end of file
+}
+
+TEST_CASE("Triangle texture coordinate gradients", "[Hittable_Triangle]") {
+    Triangle triangle(Triangle::Vertex{.pos = {0.0, 0.0, 0.0}, .uv = {0.0, 0.0}},
+                      Triangle::Vertex{.pos = {2.0, 0.0, 0.0}, .uv = {1.0, 0.0}},
+                      Triangle::Vertex{.pos = {0.0, 4.0, 0.0}, .uv = {0.0, 1.0}},
+                      nullptr);
+
+    const Ray ray(vec3(0.5, 0.5, -1.0), vec3(0.0, 0.0, 1.0));
+    const auto record = triangle.hits(ray, interval(0.0, interval::infinity));
+    REQUIRE(record.has_value());
+    REQUIRE(record->u_gradient == vec3(0.5, 0.0, 0.0));
+    REQUIRE(record->v_gradient == vec3(0.0, 0.25, 0.0));
+
+    // Degenerate triangles have no gradients
+    const auto [u_gradient, v_gradient] =
+        Triangle::uv_gradients(vec3(1.0, 0.0, 0.0), vec3(2.0, 0.0, 0.0), vec2(1.0, 0.0), vec2(0.0, 1.0));
+    REQUIRE(u_gradient == vec3(0.0));
+    REQUIRE(v_gradient == vec3(0.0));
+}
@@ -0,0 +1,134 @@
+#include <catch2/catch_all.hpp>
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <string>
+
+#include "image_dumper.h"
+
+TEST_CASE("Image pixels are contiguous and aligned", "[Image_Dumper]") {
+    PPMImageDumper image(5, 3);
+
+    REQUIRE(image.stride() == 5);
+    REQUIRE(image.pixels().size() == 15);
+    REQUIRE(reinterpret_cast<uintptr_t>(image.pixels().data()) % IImageDumper::ALIGNMENT == 0);
+
+    for (const auto& pixel : image.pixels())
+        REQUIRE(pixel == IImageDumper::Pixel(0.0f));
+
+    image.set_pixel(2, 1, vec3(0.25, 0.5, 1.0));
+    REQUIRE(image.pixel(2, 1) == vec3(0.25, 0.5, 1.0));
+    REQUIRE(image.pixels()[2 * 5 + 1] == IImageDumper::Pixel(0.25f, 0.5f, 1.0f));
+}
+
+TEST_CASE("Image views address a rectangle of the image", "[Image_Dumper]") {
+    PPMImageDumper image(8, 6);
+
+    auto view = image.view(2, 3, 3, 4);
+    REQUIRE(view.width() == 4);
+    REQUIRE(view.height() == 3);
+    REQUIRE(view.stride() == 8);
+
+    for (std::size_t row = 0; row < view.height(); ++row)
+        for (auto& pixel : view.row(row))
+            pixel = IImageDumper::Pixel(static_cast<float>(row + 1));
+
+    view(0, 0) = IImageDumper::Pixel(9.0f);
+
+    REQUIRE(image.pixel(2, 3) == vec3(9.0));
+    REQUIRE(image.pixel(2, 6) == vec3(1.0));
+    REQUIRE(image.pixel(4, 3) == vec3(3.0));
+
+    // Pixels around the view are untouched
+    REQUIRE(image.pixel(2, 2) == vec3(0.0));
+    REQUIRE(image.pixel(2, 7) == vec3(0.0));
+    REQUIRE(image.pixel(1, 3) == vec3(0.0));
+    REQUIRE(image.pixel(5, 3) == vec3(0.0));
+
+    const auto& const_image = image;
+    REQUIRE(const_image.view(2, 3, 3, 4)(2, 3) == IImageDumper::Pixel(3.0f));
+}
+
+static std::string dump_to_string(const IImageDumper& image, const char* name) {
+    const auto path = std::filesystem::temp_directory_path() / name;
+    image.dump(path);
+
+    std::stringstream contents;
+    contents << std::ifstream(path, std::ios::binary).rdbuf();
+    std::filesystem::remove(path);
+
+    return contents.str();
+}
+
+TEST_CASE("8 bit images are gamma encoded and clamped", "[Image_Dumper]") {
+    const auto fill = [](IImageDumper& image) {
+        image.set_pixel(0, 0, vec3(0.0, 0.5, 1.0));
+        image.set_pixel(0, 1, vec3(-1.0, 0.25, 2.0));
+    };
+
+    SECTION("P3") {
+        PPMImageDumper image(2, 1);
+        fill(image);
+        REQUIRE(dump_to_string(image, "ray_tracer_image.ppm") == "P3\n2 1\n255\n0 181 255\n0 128 255\n");
+    }
+
+    SECTION("P6") {
+        P6ImageDumper image(2, 1);
+        fill(image);
+        REQUIRE(dump_to_string(image, "ray_tracer_image_p6.ppm") ==
+                std::string("P6\n2 1\n255\n\x00\xb5\xff\x00\x80\xff", 17));
+    }
+}
+
+TEST_CASE("8 bit images can be encoded linearly", "[Image_Dumper]") {
+    const auto fill = [](IImageDumper& image) {
+        image.set_pixel(0, 0, vec3(0.0, 0.5, 1.0));
+        image.set_pixel(0, 1, vec3(-1.0, 0.25, 2.0));
+    };
+
+    SECTION("P3") {
+        PPMImageDumper image(2, 1, IImageDumper::Transfer::Linear);
+        fill(image);
+        REQUIRE(dump_to_string(image, "ray_tracer_image_linear.ppm") == "P3\n2 1\n255\n0 128 255\n0 64 255\n");
+    }
+
+    SECTION("P6") {
+        P6ImageDumper image(2, 1, IImageDumper::Transfer::Linear);
+        fill(image);
+        REQUIRE(dump_to_string(image, "ray_tracer_image_linear_p6.ppm") ==
+                std::string("P6\n2 1\n255\n\x00\x80\xff\x00\x40\xff", 17));
+    }
+}
+
+TEST_CASE("8 bit images clamp values that are not finite", "[Image_Dumper]") {
+    const auto nan = std::numeric_limits<real>::quiet_NaN();
+    const auto infinity = std::numeric_limits<real>::infinity();
+
+    PPMImageDumper image(1, 1);
+    image.set_pixel(0, 0, vec3(nan, infinity, -infinity));
+    REQUIRE(dump_to_string(image, "ray_tracer_image_not_finite.ppm") == "P3\n1 1\n255\n0 255 0\n");
+}
+
+TEST_CASE("PFM images keep linear values bottom row first", "[Image_Dumper]") {
+    PFMImageDumper image(1, 2);
+    image.set_pixel(0, 0, vec3(2.5, -1.0, 0.125));
+    image.set_pixel(1, 0, vec3(100.0, 0.0, 1.0));
+
+    const auto contents = dump_to_string(image, "ray_tracer_image.pfm");
+
+    const std::string header = std::endian::native == std::endian::little ? "PF\n1 2\n-1.0\n" : "PF\n1 2\n1.0\n";
+    REQUIRE(contents.size() == header.size() + 2 * 3 * sizeof(float));
+    REQUIRE(contents.substr(0, header.size()) == header);
+
+    float values[6];
+    std::memcpy(values, contents.data() + header.size(), sizeof(values));
+
+    const float expected[6] = {100.0f, 0.0f, 1.0f, 2.5f, -1.0f, 0.125f};
+    for (std::size_t i = 0; i < 6; ++i)
+        REQUIRE(values[i] == expected[i]);
+}
@@ -0,0 +1,146 @@
+#include <catch2/catch_all.hpp>
+
+#include "ray.h"
+#include "sampler.h"
+#include "interval.h"
+#include "material.h"
+#include "light_list.h"
+#include "wavefront.h"
+
+#include "hittable/sphere.h"
+#include "hittable/triangle.h"
+#include "hittable/hittable_list.h"
+#include "hittable/wide_bvh.h"
+
+// Diffuse ground at z = 0 lit by a spherical light of radius 1 and radiance 2, centered 5 units above the origin
+static HittableList create_lit_ground() {
+    HittableList scene;
+
+    const auto up = vec3(0.0, 0.0, 1.0);
+    const auto ground = scene.add_material<Lambertian>(vec3(0.5));
+    scene.add_hittable<Triangle>(Triangle::Vertex{.pos = vec3(-100.0, -100.0, 0.0), .normal = up},
+                                 Triangle::Vertex{.pos = vec3(100.0, -100.0, 0.0), .normal = up},
+                                 Triangle::Vertex{.pos = vec3(0.0, 100.0, 0.0), .normal = up},
+                                 ground);
+    scene.add_hittable<Sphere>(vec3(0.0, 0.0, 5.0), 1.0, scene.add_material<DiffuseEmissive>(vec3(1.0), 2.0));
+
+    return scene;
+}
+
+// Estimates the light reflected by the origin towards the camera, combining light samples and BSDF samples
+static real estimate_direct_light(const IHittable& scene, const LightList& lights, uint32_t num_samples) {
+    const auto ray = Ray(vec3(0.0, 0.0, 1.0), vec3(0.0, 0.0, -1.0));
+    const auto record = scene.hits(ray, interval(RAY_T_MIN, interval::infinity));
+    REQUIRE(record.has_value());
+
+    auto sum = vec3(0.0);
+    for (uint32_t i = 0; i < num_samples; ++i) {
+        Sampler sampler(5, 0, i);
+
+        const auto material_hit = record->material->scatter(ray, *record, sampler);
+        REQUIRE(material_hit.has_value());
+
+        if (const auto connection = lights.connect(ray, *record, sampler))
+            sum += lights.connection_radiance(*connection, scene);
+
+        const auto& scatter = material_hit->scatter;
+        const auto intersection = scene.intersect(scatter, interval(RAY_T_MIN, interval::infinity));
+        if (!intersection)
+            continue;
+
+        const auto light_record = scene.compute_interaction(scatter, *intersection);
+        const auto emission = light_record.material->emitted(light_record.uv.x, light_record.uv.y);
+        if (!emission)
+            continue;
+
+        const auto evaluation = record->material->evaluate(ray, *record, glm::normalize(scatter.direction()));
+        const auto weight = lights.emission_weight(record->point, evaluation->pdf, *intersection, light_record);
+        const auto throughput = material_hit->attenuation *
+                                record->material->scattering_prob(ray, *record, scatter) / material_hit->pdf;
+
+        sum += weight * throughput * *emission;
+    }
+
+    return sum.x / static_cast<real>(num_samples);
+}
+
+TEST_CASE("Light list collects the emissive primitives", "[Light_List]") {
+    auto scene = create_lit_ground();
+    scene.add_hittable<Sphere>(vec3(3.0, 0.0, 5.0), 1.0, scene.add_material<Lambertian>(vec3(0.5)));
+
+    REQUIRE(LightList(scene).size() == 1);
+    REQUIRE(LightList(WideBVH(scene)).size() == 1);
+    REQUIRE(LightList().empty());
+}
+
+TEST_CASE("Next event estimation converges to the direct light", "[Light_List]") {
+    const auto scene = create_lit_ground();
+
+    // Reflected radiance is albedo * radiance * sin^2 of the half angle of the cone subtended by the light
+    const auto expected = 0.5 * 2.0 * (1.0 / 25.0);
+
+    SECTION("BSDF sampling only") {
+        REQUIRE(estimate_direct_light(scene, LightList(), 100000) == Catch::Approx(expected).margin(0.002));
+    }
+
+    SECTION("BSDF and light sampling") {
+        REQUIRE(estimate_direct_light(scene, LightList(scene), 100000) == Catch::Approx(expected).margin(0.002));
+    }
+}
+
+TEST_CASE("Shadow rays are blocked by occluders", "[Light_List]") {
+    auto scene = create_lit_ground();
+    const LightList lights(scene);
+
+    // Opaque triangle between the ground and the light
+    const auto up = vec3(0.0, 0.0, 1.0);
+    scene.add_hittable<Triangle>(Triangle::Vertex{.pos = vec3(-10.0, -10.0, 2.0), .normal = up},
+                                 Triangle::Vertex{.pos = vec3(10.0, -10.0, 2.0), .normal = up},
+                                 Triangle::Vertex{.pos = vec3(0.0, 10.0, 2.0), .normal = up},
+                                 scene.add_material<Lambertian>(vec3(0.5)));
+
+    const auto ray = Ray(vec3(0.0, 0.0, 1.0), vec3(0.0, 0.0, -1.0));
+    const auto record = scene.hits(ray, interval(RAY_T_MIN, interval::infinity));
+    REQUIRE(record.has_value());
+
+    for (uint32_t i = 0; i < 100; ++i) {
+        Sampler sampler(9, 0, i);
+        const auto connection = lights.connect(ray, *record, sampler);
+        REQUIRE(connection.has_value());
+        REQUIRE(lights.connection_radiance(*connection, scene) == vec3(0.0));
+    }
+}
+
+TEST_CASE("Light samples do not change the expected radiance of short paths", "[Light_List]") {
+    // Closed diffuse room around a large light, so every vertex can sample it
+    HittableList scene;
+    scene.add_hittable<Sphere>(vec3(0.0), 10.0, scene.add_material<Lambertian>(vec3(0.5)));
+    scene.add_hittable<Sphere>(vec3(0.0, 0.0, 5.0), 3.0, scene.add_material<DiffuseEmissive>(vec3(1.0), 2.0));
+    const WideBVH bvh(scene);
+    const LightList lights(bvh);
+
+    const auto max_depth = GENERATE(1u, 2u, 3u);
+
+    const auto mean_radiance = [&](const LightList& light_list) {
+        constexpr uint32_t num_paths = 20000;
+
+        WavefrontIntegrator wavefront(max_depth, max_depth);
+        for (uint32_t i = 0; i < num_paths; ++i)
+            wavefront.add_path(Ray(vec3(0.0), vec3(1.0, 0.0, -0.5)), Sampler(3, i, 0));
+        wavefront.trace(bvh, light_list);
+
+        real sum = 0;
+        for (uint32_t path = 0; path < wavefront.size(); ++path)
+            sum += wavefront.radiance(path).r;
+        return sum / num_paths;
+    };
+
+    // Without light samples, only the light hit by scattered rays is found
+    const auto expected = mean_radiance(LightList());
+    const auto estimate = mean_radiance(lights);
+
+    if (max_depth == 1)
+        REQUIRE(estimate == 0.0);
+    else
+        REQUIRE(estimate == Catch::Approx(expected).epsilon(0.05));
+}
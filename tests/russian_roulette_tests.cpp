@@ -0,0 +1,52 @@
+#include <catch2/catch_all.hpp>
+
+#include "sampler.h"
+#include "russian_roulette.h"
+
+TEST_CASE("Russian roulette keeps every path before the start depth", "[Russian_Roulette]") {
+    const RussianRoulette russian_roulette(3);
+    Sampler sampler(1);
+
+    for (uint32_t depth = 0; depth < 3; ++depth) {
+        auto throughput = vec3(0.01);
+        REQUIRE(russian_roulette.survives(depth, throughput, sampler));
+        REQUIRE(throughput == vec3(0.01));
+    }
+}
+
+TEST_CASE("Russian roulette terminates paths without throughput", "[Russian_Roulette]") {
+    const RussianRoulette russian_roulette(0);
+    Sampler sampler(2);
+
+    for (uint32_t i = 0; i < 100; ++i) {
+        auto throughput = vec3(0.0);
+        REQUIRE(!russian_roulette.survives(1, throughput, sampler));
+    }
+}
+
+TEST_CASE("Russian roulette preserves the expected throughput", "[Russian_Roulette]") {
+    const RussianRoulette russian_roulette(0);
+    Sampler sampler(3);
+
+    const auto initial = vec3(0.3, 0.1, 0.2);
+
+    constexpr uint32_t num_paths = 100000;
+    auto sum = vec3(0.0);
+    uint32_t num_survivors = 0;
+
+    for (uint32_t i = 0; i < num_paths; ++i) {
+        auto throughput = initial;
+        if (russian_roulette.survives(1, throughput, sampler)) {
+            sum += throughput;
+            num_survivors++;
+        }
+    }
+
+    // Survival probability follows the largest component of the throughput
+    REQUIRE(static_cast<double>(num_survivors) / num_paths == Catch::Approx(0.3).margin(0.01));
+
+    const auto mean = sum / static_cast<real>(num_paths);
+    REQUIRE(mean.x == Catch::Approx(initial.x).margin(0.01));
+    REQUIRE(mean.y == Catch::Approx(initial.y).margin(0.01));
+    REQUIRE(mean.z == Catch::Approx(initial.z).margin(0.01));
+}
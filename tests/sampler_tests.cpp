@@ -0,0 +1,63 @@
+#include <catch2/catch_all.hpp>
+
+#include <vector>
+
+#include "sampler.h"
+
+TEST_CASE("Sampler values in range", "[Sampler]") {
+    Sampler sampler(1234);
+
+    for (uint32_t i = 0; i < 10000; ++i) {
+        const auto value = sampler.next_double();
+        REQUIRE(value >= 0.0);
+        REQUIRE(value < 1.0);
+
+        const auto integer = sampler.next_int(-3, 3);
+        REQUIRE(integer >= -3);
+        REQUIRE(integer <= 3);
+    }
+}
+
+TEST_CASE("Sampler real values never reach one", "[Sampler]") {
+    Sampler sampler(5678);
+
+    for (uint32_t i = 0; i < 10000; ++i) {
+        const auto value = sampler.next_real();
+        REQUIRE(value >= real(0));
+        REQUIRE(value < real(1));
+    }
+}
+
+TEST_CASE("Sampler is reproducible", "[Sampler]") {
+    Sampler a(7, 100, 3);
+    Sampler b(7, 100, 3);
+
+    for (uint32_t i = 0; i < 100; ++i)
+        REQUIRE(a.next_uint32() == b.next_uint32());
+}
+
+TEST_CASE("Sampler streams are independent", "[Sampler]") {
+    const auto first_values = [](Sampler sampler) {
+        std::vector<uint32_t> values;
+        for (uint32_t i = 0; i < 8; ++i)
+            values.push_back(sampler.next_uint32());
+        return values;
+    };
+
+    const auto reference = first_values(Sampler(7, 100, 3));
+
+    REQUIRE(first_values(Sampler(8, 100, 3)) != reference);
+    REQUIRE(first_values(Sampler(7, 101, 3)) != reference);
+    REQUIRE(first_values(Sampler(7, 100, 4)) != reference);
+}
+
+TEST_CASE("Sampler mean is close to one half", "[Sampler]") {
+    Sampler sampler(99);
+
+    constexpr uint32_t count = 100000;
+    auto sum = 0.0;
+    for (uint32_t i = 0; i < count; ++i)
+        sum += sampler.next_double();
+
+    REQUIRE(sum / count == Catch::Approx(0.5).margin(0.01));
+}
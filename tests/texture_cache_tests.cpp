@@ -0,0 +1,155 @@
+#include <catch2/catch_all.hpp>
+
+#include <algorithm>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+#include "image_dumper.h"
+#include "texture_cache.h"
+
+// 8 bit image of size x size pixels, whose color depends on the pixel and on seed
+static std::filesystem::path create_image(const char* name, uint32_t size, real seed) {
+    P6ImageDumper image(size, size);
+    for (uint32_t row = 0; row < size; ++row) {
+        for (uint32_t col = 0; col < size; ++col) {
+            const auto x = static_cast<real>(col) / static_cast<real>(size);
+            const auto y = static_cast<real>(row) / static_cast<real>(size);
+            image.set_pixel(row, col, vec3(x, y, seed));
+        }
+    }
+
+    const auto path = std::filesystem::temp_directory_path() / name;
+    image.dump(path);
+    return path;
+}
+
+// Samples over the whole texture, through several mip levels
+static std::vector<vec3> sample_grid(const Texture& texture) {
+    std::vector<vec3> colors;
+    for (uint32_t i = 0; i < 64; ++i) {
+        const auto u = static_cast<real>(i % 8) / 7;
+        const auto v = static_cast<real>(i / 8) / 7;
+        colors.push_back(texture.sample(u, v, static_cast<real>(i % 4) / 16));
+    }
+    return colors;
+}
+
+TEST_CASE("Cached textures are shared and decoded on first use", "[Texture_Cache]") {
+    const auto path = create_image("ray_tracer_texture_cache.ppm", 16, real(0.25));
+
+    TextureCache cache({});
+    const auto texture = cache.get(path, Texture::Filtering::Trilinear);
+    REQUIRE(texture != nullptr);
+    REQUIRE(texture->width() == 16);
+    REQUIRE(texture->height() == 16);
+    REQUIRE(texture->num_levels() == 5);
+
+    REQUIRE(cache.get(path.parent_path() / "." / path.filename(), Texture::Filtering::Trilinear) == texture);
+    REQUIRE(cache.get(path, Texture::Filtering::Nearest) != texture);
+    REQUIRE(cache.get(path.string() + ".missing", Texture::Filtering::Trilinear) == nullptr);
+    REQUIRE(cache.num_textures() == 2);
+
+    REQUIRE(!texture->is_resident());
+    REQUIRE(cache.resident_size() == 0);
+
+    const Texture eager(path, Texture::Filtering::Trilinear);
+    REQUIRE(sample_grid(*texture) == sample_grid(eager));
+
+    REQUIRE(texture->is_resident());
+    REQUIRE(cache.resident_size() > 0);
+    REQUIRE(cache.num_decoded() == 1);
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Textures whose image becomes unreadable are sampled as black", "[Texture_Cache]") {
+    const auto path = create_image("ray_tracer_texture_cache_removed.ppm", 8, real(0.5));
+
+    TextureCache cache({});
+    const auto texture = cache.get(path, Texture::Filtering::Bilinear);
+    REQUIRE(texture != nullptr);
+
+    std::filesystem::remove(path);
+    REQUIRE(texture->sample(real(0.5), real(0.5)) == vec3(0.0));
+
+    // The failure is kept, the image is not read again even once it is back
+    create_image("ray_tracer_texture_cache_removed.ppm", 8, real(0.5));
+    REQUIRE(texture->sample(real(0.5), real(0.5)) == vec3(0.0));
+    REQUIRE(!texture->is_resident());
+    REQUIRE(cache.num_decoded() == 0);
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Least recently used textures are evicted over the budget", "[Texture_Cache]") {
+    const auto path_a = create_image("ray_tracer_texture_cache_a.ppm", 16, real(0.2));
+    const auto path_b = create_image("ray_tracer_texture_cache_b.ppm", 16, real(0.6));
+    const auto path_c = create_image("ray_tracer_texture_cache_c.ppm", 16, real(0.9));
+
+    const Texture eager_a(path_a, Texture::Filtering::Trilinear);
+    const Texture eager_b(path_b, Texture::Filtering::Trilinear);
+    const auto expected_a = sample_grid(eager_a);
+    const auto expected_b = sample_grid(eager_b);
+
+    // Size of the texels of a 16x16 texture, kept resident even though it is over the budget
+    TextureCache single({.budget = 1});
+    REQUIRE(sample_grid(*single.get(path_a, Texture::Filtering::Trilinear)) == expected_a);
+    const auto texture_size = single.resident_size();
+
+    // Room for two textures
+    TextureCache cache({.budget = 2 * texture_size});
+    const auto a = cache.get(path_a, Texture::Filtering::Trilinear);
+    const auto b = cache.get(path_b, Texture::Filtering::Trilinear);
+    const auto c = cache.get(path_c, Texture::Filtering::Trilinear);
+
+    SECTION("Sequential") {
+        REQUIRE(sample_grid(*a) == expected_a);
+        REQUIRE(sample_grid(*b) == expected_b);
+        REQUIRE(a->is_resident());
+        REQUIRE(b->is_resident());
+
+        // a is the least recently used when c is decoded
+        (void)c->sample(real(0.5), real(0.5));
+        REQUIRE(!a->is_resident());
+        REQUIRE(b->is_resident());
+        REQUIRE(c->is_resident());
+        REQUIRE(cache.resident_size() == 2 * texture_size);
+
+        // Evicted textures are decoded again, evicting b in turn
+        const auto num_decoded = cache.num_decoded();
+        REQUIRE(sample_grid(*a) == expected_a);
+        REQUIRE(cache.num_decoded() == num_decoded + 1);
+        REQUIRE(!b->is_resident());
+        REQUIRE(c->is_resident());
+    }
+
+    SECTION("Concurrent") {
+        std::vector<std::thread> threads;
+        std::vector<uint8_t> correct(8, 1);
+
+        for (uint32_t t = 0; t < correct.size(); ++t) {
+            threads.emplace_back([&, t]() {
+                for (uint32_t i = 0; i < 50; ++i) {
+                    const auto& texture = (i + t) % 3 == 0 ? *a : (i + t) % 3 == 1 ? *b : *c;
+                    const auto colors = sample_grid(texture);
+
+                    if (&texture == a.get() && colors != expected_a)
+                        correct[t] = 0;
+                    if (&texture == b.get() && colors != expected_b)
+                        correct[t] = 0;
+                }
+            });
+        }
+
+        for (auto& thread : threads)
+            thread.join();
+
+        REQUIRE(std::count(correct.begin(), correct.end(), 1) == static_cast<std::ptrdiff_t>(correct.size()));
+        REQUIRE(cache.resident_size() <= 2 * texture_size);
+    }
+
+    std::filesystem::remove(path_a);
+    std::filesystem::remove(path_b);
+    std::filesystem::remove(path_c);
+}
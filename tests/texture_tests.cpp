@@ -0,0 +1,117 @@
+#include <catch2/catch_all.hpp>
+
+#include "ray.h"
+#include "texture.h"
+
+// size x size checkerboard of black and white texels
+static Texture create_checkerboard(uint32_t size, Texture::Filtering filtering) {
+    std::vector<std::byte> data;
+    for (uint32_t y = 0; y < size; ++y) {
+        for (uint32_t x = 0; x < size; ++x) {
+            const auto value = (x + y) % 2 == 0 ? std::byte{255} : std::byte{0};
+            data.insert(data.end(), 3, value);
+        }
+    }
+
+    return {size, size, 3, std::move(data), filtering};
+}
+
+// size x size vertical stripes, the even columns white
+static Texture create_stripes(uint32_t size, Texture::Filtering filtering) {
+    std::vector<std::byte> data;
+    for (uint32_t y = 0; y < size; ++y) {
+        for (uint32_t x = 0; x < size; ++x)
+            data.insert(data.end(), 3, x % 2 == 0 ? std::byte{255} : std::byte{0});
+    }
+
+    return {size, size, 3, std::move(data), filtering};
+}
+
+TEST_CASE("Mip pyramids halve down to a single texel", "[Texture]") {
+    REQUIRE(create_checkerboard(8, Texture::Filtering::Trilinear).num_levels() == 4);
+
+    const Texture texture(6, 3, 4, std::vector<std::byte>(6 * 3 * 4, std::byte{10}), Texture::Filtering::Bilinear);
+    REQUIRE(texture.num_levels() == 3); // 6x3, 3x1, 1x1
+    REQUIRE(texture.sample(real(0.3), real(0.7), 1.0).r == Catch::Approx(10.0 / 255.0 / 12.92));
+}
+
+TEST_CASE("Footprints select the mip level", "[Texture]") {
+    const auto texture = create_checkerboard(8, Texture::Filtering::Trilinear);
+
+    // Texel centers of the full resolution image
+    REQUIRE(texture.sample(0.5 / 8.0, 0.5 / 8.0).r == Catch::Approx(1.0));
+    REQUIRE(texture.sample(1.5 / 8.0, 0.5 / 8.0).r == Catch::Approx(0.0));
+
+    // Footprints of two texels or more only see the averaged levels
+    REQUIRE(texture.sample(0.5 / 8.0, 0.5 / 8.0, 2.0 / 8.0).r == Catch::Approx(0.5));
+    REQUIRE(texture.sample(real(0.3), real(0.9), 10.0).r == Catch::Approx(0.5));
+
+    // Halfway between the first two levels
+    const auto blended = texture.sample(0.5 / 8.0, 0.5 / 8.0, std::sqrt(real(2)) / 8).r;
+    REQUIRE(blended == Catch::Approx(0.75));
+}
+
+TEST_CASE("Bilinear filtering interpolates between texel centers", "[Texture]") {
+    const auto texture = create_checkerboard(4, Texture::Filtering::Bilinear);
+
+    REQUIRE(texture.sample(1.0 / 4.0, 0.5 / 4.0).r == Catch::Approx(0.5));
+    REQUIRE(texture.sample(0.5 / 4.0, 0.5 / 4.0).r == Catch::Approx(1.0));
+
+    // Clamped to the border
+    REQUIRE(texture.sample(-1.0, 0.5 / 4.0).r == Catch::Approx(1.0));
+}
+
+TEST_CASE("Anisotropic filtering samples along the major axis of the footprint", "[Texture]") {
+    const auto anisotropic = create_stripes(8, Texture::Filtering::Anisotropic);
+    const auto trilinear = create_stripes(8, Texture::Filtering::Trilinear);
+
+    // One texel across the stripes and the whole texture along them, only the stripe under (u, v) is seen
+    const Texture::Footprint along_stripes{.width = real(1.0 / 8.0), .major_axis = vec2(0.0, 1.0)};
+    REQUIRE(anisotropic.sample(0.5 / 8.0, 0.5, along_stripes).r == Catch::Approx(1.0));
+    REQUIRE(anisotropic.sample(1.5 / 8.0, 0.5, along_stripes).r == Catch::Approx(0.0));
+    REQUIRE(trilinear.sample(0.5 / 8.0, 0.5, along_stripes).r == Catch::Approx(0.5));
+
+    const Texture::Footprint across_stripes{.width = real(1.0 / 8.0), .major_axis = vec2(1.0, 0.0)};
+    REQUIRE(anisotropic.sample(0.5, 0.5, across_stripes).r == Catch::Approx(0.5));
+
+    // Round footprints are filtered like Trilinear
+    const auto footprint = real(3.0 / 16.0);
+    REQUIRE(anisotropic.sample(real(0.3), real(0.6), footprint) == trilinear.sample(real(0.3), real(0.6), footprint));
+}
+
+TEST_CASE("Ray cones widen with distance", "[Texture]") {
+    const Ray ray(vec3(0.0), vec3(0.0, 0.0, 2.0), RayCone{.width = 0.5, .spread = real(0.01)});
+
+    REQUIRE(ray.footprint(0.0) == Catch::Approx(0.5));
+    REQUIRE(ray.footprint(10.0) == Catch::Approx(0.7));
+    REQUIRE(Ray(vec3(0.0), vec3(1.0)).footprint(100.0) == 0.0);
+}
+
+static double srgb_to_linear(uint32_t value) {
+    const auto c = static_cast<double>(value) / 255.0;
+    return c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+}
+
+TEST_CASE("Texels are decoded from sRGB", "[Texture]") {
+    // 5x6 gradient, so that texels span several tiles and partially used ones
+    std::vector<std::byte> data;
+    for (uint32_t y = 0; y < 6; ++y) {
+        for (uint32_t x = 0; x < 5; ++x) {
+            data.push_back(static_cast<std::byte>(x * 50));
+            data.push_back(static_cast<std::byte>(y * 50));
+            data.push_back(std::byte{188});
+        }
+    }
+
+    const Texture texture(5, 6, 3, std::move(data), Texture::Filtering::Nearest);
+
+    for (uint32_t y = 0; y < 6; ++y) {
+        for (uint32_t x = 0; x < 5; ++x) {
+            const auto color = texture.sample(static_cast<real>(x) / 4, static_cast<real>(y) / 5);
+
+            REQUIRE(color.r == Catch::Approx(srgb_to_linear(x * 50)));
+            REQUIRE(color.g == Catch::Approx(srgb_to_linear(y * 50)));
+            REQUIRE(color.b == Catch::Approx(0.5).margin(5e-3));
+        }
+    }
+}
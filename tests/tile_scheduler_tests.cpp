@@ -0,0 +1,47 @@
+#include <catch2/catch_all.hpp>
+
+#include <vector>
+
+#include "tile_scheduler.h"
+
+TEST_CASE("Tiles cover the whole image exactly once", "[Tile_Scheduler]") {
+    const auto order =
+        GENERATE(TileScheduler::Order::Scanline, TileScheduler::Order::Morton, TileScheduler::Order::Hilbert);
+
+    constexpr uint32_t width = 100, height = 70;
+    TileScheduler scheduler(width, height, 16, order, 3);
+
+    REQUIRE(scheduler.tiles().size() == 7 * 5);
+
+    std::vector<uint32_t> coverage(width * height, 0);
+    std::vector<uint32_t> handed_out(scheduler.tiles().size(), 0);
+
+    // Thread 0 is the only one asking for work, so it has to steal the tiles of the other threads
+    while (const auto tile = scheduler.next(0)) {
+        handed_out[tile->index]++;
+
+        for (auto row = tile->row; row < tile->row + tile->height; ++row)
+            for (auto col = tile->col; col < tile->col + tile->width; ++col)
+                coverage[row * width + col]++;
+    }
+
+    for (const auto count : handed_out)
+        REQUIRE(count == 1);
+
+    for (const auto count : coverage)
+        REQUIRE(count == 1);
+}
+
+TEST_CASE("Hilbert order visits neighbouring tiles", "[Tile_Scheduler]") {
+    TileScheduler scheduler(128, 128, 16, TileScheduler::Order::Hilbert, 1);
+    const auto& tiles = scheduler.tiles();
+
+    for (std::size_t i = 1; i < tiles.size(); ++i) {
+        const auto row_distance = tiles[i].row > tiles[i - 1].row ? tiles[i].row - tiles[i - 1].row
+                                                                  : tiles[i - 1].row - tiles[i].row;
+        const auto col_distance = tiles[i].col > tiles[i - 1].col ? tiles[i].col - tiles[i - 1].col
+                                                                  : tiles[i - 1].col - tiles[i].col;
+
+        REQUIRE(row_distance + col_distance == 16);
+    }
+}
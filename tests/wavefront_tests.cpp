@@ -0,0 +1,67 @@
+#include <catch2/catch_all.hpp>
+
+#include "ray.h"
+#include "sampler.h"
+#include "material.h"
+#include "wavefront.h"
+
+#include "hittable/sphere.h"
+#include "hittable/hittable_list.h"
+
+TEST_CASE("Wavefront paths collect emission of the light they hit", "[Wavefront]") {
+    HittableList scene;
+    scene.add_hittable<Sphere>(vec3(0.0, 0.0, -5.0), 1.0, scene.add_material<DiffuseEmissive>(vec3(1.0), 2.0));
+
+    WavefrontIntegrator wavefront(4, 4);
+    const auto hit_path = wavefront.add_path(Ray(vec3(0.0), vec3(0.0, 0.0, -1.0)), Sampler(1, 0, 0));
+    const auto miss_path = wavefront.add_path(Ray(vec3(0.0), vec3(0.0, 0.0, 1.0)), Sampler(1, 1, 0));
+
+    wavefront.trace(scene, LightList());
+
+    REQUIRE(wavefront.radiance(hit_path) == vec3(2.0));
+    REQUIRE(wavefront.radiance(miss_path) == vec3(0.0));
+
+    const auto& statistics = wavefront.statistics();
+    REQUIRE(statistics.num_paths == 2);
+    REQUIRE(statistics.num_extended == 2);
+    REQUIRE(statistics.num_shaded == 1);
+}
+
+TEST_CASE("Wavefront paths stop at the maximum depth", "[Wavefront]") {
+    // Camera inside a closed diffuse sphere, paths never escape
+    HittableList scene;
+    scene.add_hittable<Sphere>(vec3(0.0), 10.0, scene.add_material<Lambertian>(vec3(0.5)));
+
+    const auto max_depth = GENERATE(0u, 1u, 5u);
+    WavefrontIntegrator wavefront(max_depth, max_depth);
+
+    for (uint32_t i = 0; i < 8; ++i)
+        wavefront.add_path(Ray(vec3(0.0), vec3(1.0, 0.0, 0.0)), Sampler(7, i, 0));
+
+    wavefront.trace(scene, LightList());
+
+    REQUIRE(wavefront.statistics().num_extended == 8 * max_depth);
+    for (uint32_t path = 0; path < wavefront.size(); ++path)
+        REQUIRE(wavefront.radiance(path) == vec3(0.0));
+
+    wavefront.clear();
+    REQUIRE(wavefront.size() == 0);
+}
+
+TEST_CASE("Wavefront paths are ended early by Russian roulette", "[Wavefront]") {
+    HittableList scene;
+    scene.add_hittable<Sphere>(vec3(0.0), 10.0, scene.add_material<Lambertian>(vec3(0.5)));
+
+    constexpr uint32_t max_depth = 50;
+    WavefrontIntegrator wavefront(max_depth, 2);
+
+    for (uint32_t i = 0; i < 64; ++i)
+        wavefront.add_path(Ray(vec3(0.0), vec3(1.0, 0.0, 0.0)), Sampler(7, i, 0));
+
+    wavefront.trace(scene, LightList());
+
+    // Every path survives the first two bounces, and almost none of them reaches the maximum depth
+    const auto num_extended = wavefront.statistics().num_extended;
+    REQUIRE(num_extended >= 64 * 2);
+    REQUIRE(num_extended < 64 * max_depth / 4);
+}